@@ -0,0 +1,168 @@
+#include <easylua/function.hpp>
+#include <easylua/state.hpp>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+// Counts heap allocations made through operator new, so that the benchmarks can report allocations per call. The replacement applies to
+// the whole program, so these benchmarks are built into their own executable and the others do not pay for the counting.
+static std::atomic<std::size_t> allocation_count{0};
+
+void *operator new(std::size_t size)
+{
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+    class lua_fixture
+    {
+    public:
+        lua_fixture()
+        {
+            L = luaL_newstate();
+            luaL_dostring(L, "function f(a, b) return #a + #b end");
+            lua_getglobal(L, "f");
+        }
+
+        ~lua_fixture() { lua_close(L); }
+
+        lua_State *L;
+    };
+
+    // Strings longer than the small string buffer, so that every copy allocates.
+    const std::string first_argument(64, 'a');
+    const std::string second_argument(64, 'b');
+
+    /// @brief Emulates the previous call path, which took every argument by value at each level.
+    template <typename Function>
+    int call_by_value(Function &function, std::string a, std::string b)
+    {
+        return function(std::string(a), std::string(b));
+    }
+
+    void report_allocations(benchmark::State &bench_state, std::size_t before)
+    {
+        bench_state.counters["allocs_per_call"] = benchmark::Counter(static_cast<double>(allocation_count.load() - before) / bench_state.iterations());
+    }
+}
+
+static void BM_safe_function_call_forwarding(benchmark::State &bench_state)
+{
+    lua_fixture fixture;
+    safe_function_reference f(fixture.L);
+    const std::size_t before = allocation_count.load();
+    for (auto _ : bench_state)
+    {
+        int result = f(first_argument, second_argument);
+        benchmark::DoNotOptimize(result);
+    }
+    report_allocations(bench_state, before);
+}
+BENCHMARK(BM_safe_function_call_forwarding);
+
+static void BM_safe_function_call_by_value(benchmark::State &bench_state)
+{
+    lua_fixture fixture;
+    safe_function_reference f(fixture.L);
+    const std::size_t before = allocation_count.load();
+    for (auto _ : bench_state)
+    {
+        int result = call_by_value(f, first_argument, second_argument);
+        benchmark::DoNotOptimize(result);
+    }
+    report_allocations(bench_state, before);
+}
+BENCHMARK(BM_safe_function_call_by_value);
+
+// A script that returns "either a number or nil", half of the time each. The throwing path pays for an exception and the allocations of
+// its message on every nil; the expected path returns the error by value.
+static const char *number_or_nil = "function score(i) if i % 2 == 0 then return i end return nil end";
+
+static void BM_number_or_nil_call_throwing(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_dostring(lua, number_or_nil);
+    lua_getglobal(lua, "score");
+    safe_function_reference score(lua);
+    lua_Integer i = 0;
+    const std::size_t before = allocation_count.load();
+    for (auto _ : bench_state)
+    {
+        try
+        {
+            benchmark::DoNotOptimize(score.call<double>(i++));
+        }
+        catch (const type_error &)
+        {
+        }
+    }
+    report_allocations(bench_state, before);
+}
+BENCHMARK(BM_number_or_nil_call_throwing);
+
+static void BM_number_or_nil_try_call(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_dostring(lua, number_or_nil);
+    lua_getglobal(lua, "score");
+    safe_function_reference score(lua);
+    lua_Integer i = 0;
+    const std::size_t before = allocation_count.load();
+    for (auto _ : bench_state)
+        benchmark::DoNotOptimize(score.try_call<double>(i++));
+    report_allocations(bench_state, before);
+}
+BENCHMARK(BM_number_or_nil_try_call);
+
+static void BM_stack_get_mismatch_throwing(benchmark::State &bench_state)
+{
+    state lua;
+    lua_pushnil(lua);
+    const std::size_t before = allocation_count.load();
+    for (auto _ : bench_state)
+    {
+        try
+        {
+            benchmark::DoNotOptimize(stack::get<double>(lua, -1));
+        }
+        catch (const type_error &)
+        {
+        }
+    }
+    report_allocations(bench_state, before);
+}
+BENCHMARK(BM_stack_get_mismatch_throwing);
+
+static void BM_stack_try_get_mismatch(benchmark::State &bench_state)
+{
+    state lua;
+    lua_pushnil(lua);
+    const std::size_t before = allocation_count.load();
+    for (auto _ : bench_state)
+        benchmark::DoNotOptimize(stack::try_get<double>(lua, -1));
+    report_allocations(bench_state, before);
+}
+BENCHMARK(BM_stack_try_get_mismatch);
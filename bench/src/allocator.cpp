@@ -0,0 +1,89 @@
+#include <easylua/state.hpp>
+
+#include <memory_resource>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+// A short-lived workload: build a few tables and strings, then throw the state away.
+static constexpr const char *workload = R"(
+local t = {}
+for i = 1, 200 do
+    t[i] = { id = i, name = "item" .. i, tags = { "a", "b", "c" } }
+end
+local s = {}
+for i = 1, #t do
+    s[#s + 1] = t[i].name
+end
+count = #s
+)";
+
+static void run_workload(benchmark::State &bench_state, state &lua)
+{
+    luaL_openlibs(lua);
+    if (!lua.run(workload))
+        bench_state.SkipWithError("workload failed");
+}
+
+static void BM_state_default(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        state lua;
+        run_workload(bench_state, lua);
+    }
+}
+BENCHMARK(BM_state_default);
+
+static void BM_state_default_allocator(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        state lua(std::make_unique<default_allocator>());
+        run_workload(bench_state, lua);
+    }
+}
+BENCHMARK(BM_state_default_allocator);
+
+static void BM_state_pool_allocator(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        state lua(std::make_unique<pool_allocator>());
+        run_workload(bench_state, lua);
+    }
+}
+BENCHMARK(BM_state_pool_allocator);
+
+static void BM_state_arena_allocator(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        state lua(std::make_unique<arena_allocator>());
+        run_workload(bench_state, lua);
+    }
+}
+BENCHMARK(BM_state_arena_allocator);
+
+static void BM_state_pmr_pool_resource(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        std::pmr::unsynchronized_pool_resource resource;
+        state lua(std::make_unique<memory_resource_allocator>(&resource));
+        run_workload(bench_state, lua);
+    }
+}
+BENCHMARK(BM_state_pmr_pool_resource);
+
+static void BM_state_pmr_monotonic_resource(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        std::pmr::monotonic_buffer_resource resource;
+        state lua(std::make_unique<memory_resource_allocator>(&resource));
+        run_workload(bench_state, lua);
+    }
+}
+BENCHMARK(BM_state_pmr_monotonic_resource);
@@ -0,0 +1,77 @@
+#include <easylua/function.hpp>
+#include <easylua/state.hpp>
+
+#include <chrono>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+static const char *const workload = R"(
+    function workload()
+        local t = {}
+        for i = 1, 10000 do
+            t[#t + 1] = (i * 7) % 13
+        end
+        local sum = 0
+        for _, v in ipairs(t) do
+            sum = sum + v
+        end
+        return sum
+    end
+)";
+
+static void BM_workload_unlimited(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_openlibs(lua);
+    lua.run(workload);
+    lua_getglobal(lua, "workload");
+    safe_function_reference function(lua);
+    for (auto _ : bench_state)
+    {
+        int sum = function();
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_workload_unlimited);
+
+static void BM_workload_budget(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_openlibs(lua);
+    lua.run(workload);
+    lua_getglobal(lua, "workload");
+    safe_function_reference function(lua);
+
+    execution_budget budget;
+    budget.max_instructions = 1'000'000'000;
+    budget.max_duration = std::chrono::seconds(10);
+    budget.granularity = static_cast<int>(bench_state.range(0));
+    for (auto _ : bench_state)
+    {
+        const budget_scope scope(lua, budget);
+        int sum = function();
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_workload_budget)->ArgName("granularity")->Arg(100)->Arg(1000)->Arg(10000);
+
+static void BM_workload_deadline(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_openlibs(lua);
+    lua.run(workload);
+    lua_getglobal(lua, "workload");
+    safe_function_reference function(lua);
+
+    execution_budget budget;
+    budget.max_duration = std::chrono::seconds(10);
+    for (auto _ : bench_state)
+    {
+        const budget_scope scope(lua, budget);
+        int sum = function();
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_workload_deadline);
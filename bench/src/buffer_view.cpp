@@ -0,0 +1,66 @@
+#include <easylua/buffer_view.hpp>
+#include <easylua/function.hpp>
+#include <easylua/state.hpp>
+
+#include <string_view>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+// Reads a few header fields of a packet, the way a filter script does. The view avoids copying the payload into a Lua string.
+static const char *const scripts = R"(
+    function sum_view(view)
+        return view:u16(1) + view:u32(3) + view[7] + view[#view]
+    end
+
+    function sum_string(s)
+        local length, id, flags = string.unpack("<I2I4B", s)
+        return length + id + flags + s:byte(#s)
+    end
+)";
+
+static std::vector<unsigned char> make_packet(std::size_t size)
+{
+    std::vector<unsigned char> packet(size);
+    for (std::size_t i = 0; i < size; i++)
+        packet[i] = static_cast<unsigned char>(i * 31);
+
+    return packet;
+}
+
+static void BM_buffer_view_pass(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_openlibs(lua);
+    buffer_view::register_type(lua);
+    lua.run(scripts);
+    lua_getglobal(lua, "sum_view");
+    safe_function_reference sum(lua);
+
+    const std::vector<unsigned char> packet = make_packet(static_cast<std::size_t>(bench_state.range(0)));
+    for (auto _ : bench_state)
+    {
+        buffer_owner owner;
+        benchmark::DoNotOptimize(sum.call<lua_Integer>(owner.view(packet.data(), packet.size())));
+    }
+    bench_state.SetBytesProcessed(bench_state.iterations() * bench_state.range(0));
+}
+BENCHMARK(BM_buffer_view_pass)->Arg(64)->Arg(64 << 10);
+
+static void BM_string_copy_pass(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_openlibs(lua);
+    lua.run(scripts);
+    lua_getglobal(lua, "sum_string");
+    safe_function_reference sum(lua);
+
+    const std::vector<unsigned char> packet = make_packet(static_cast<std::size_t>(bench_state.range(0)));
+    const std::string_view bytes(reinterpret_cast<const char *>(packet.data()), packet.size());
+    for (auto _ : bench_state)
+        benchmark::DoNotOptimize(sum.call<lua_Integer>(bytes));
+    bench_state.SetBytesProcessed(bench_state.iterations() * bench_state.range(0));
+}
+BENCHMARK(BM_string_copy_pass)->Arg(64)->Arg(64 << 10);
@@ -0,0 +1,146 @@
+#include <easylua/function.hpp>
+#include <easylua/state.hpp>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+namespace
+{
+    const char *const arity_script = "function f(a, b, c, d, e, f, g, h) return 1 end";
+
+    template <typename Function, std::size_t... I>
+    int call_with_arguments(Function &function, std::index_sequence<I...>)
+    {
+        int result = function(static_cast<int>(I)...);
+        return result;
+    }
+}
+
+template <std::size_t Arguments>
+static void BM_safe_function_call(benchmark::State &bench_state)
+{
+    state lua;
+    lua_State *L = lua;
+    luaL_dostring(L, arity_script);
+    lua_getglobal(L, "f");
+    safe_function_reference f(L);
+    for (auto _ : bench_state)
+        benchmark::DoNotOptimize(call_with_arguments(f, std::make_index_sequence<Arguments>()));
+}
+BENCHMARK_TEMPLATE(BM_safe_function_call, 0);
+BENCHMARK_TEMPLATE(BM_safe_function_call, 1);
+BENCHMARK_TEMPLATE(BM_safe_function_call, 4);
+BENCHMARK_TEMPLATE(BM_safe_function_call, 8);
+
+template <std::size_t Arguments>
+static void BM_unsafe_function_call(benchmark::State &bench_state)
+{
+    state lua;
+    lua_State *L = lua;
+    luaL_dostring(L, arity_script);
+    lua_getglobal(L, "f");
+    // An absolute index, because the stack grows while the function is called.
+    unsafe_function_reference f(L, lua_gettop(L));
+    for (auto _ : bench_state)
+        benchmark::DoNotOptimize(call_with_arguments(f, std::make_index_sequence<Arguments>()));
+}
+BENCHMARK_TEMPLATE(BM_unsafe_function_call, 0);
+BENCHMARK_TEMPLATE(BM_unsafe_function_call, 1);
+BENCHMARK_TEMPLATE(BM_unsafe_function_call, 4);
+BENCHMARK_TEMPLATE(BM_unsafe_function_call, 8);
+
+// The same call written directly against the C API, as a baseline for the wrapper overhead.
+template <std::size_t Arguments>
+static void BM_raw_function_call(benchmark::State &bench_state)
+{
+    lua_State *L = luaL_newstate();
+    luaL_dostring(L, arity_script);
+    lua_getglobal(L, "f");
+    const int function = luaL_ref(L, LUA_REGISTRYINDEX);
+    for (auto _ : bench_state)
+    {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, function);
+        for (std::size_t i = 0; i < Arguments; i++)
+            lua_pushinteger(L, static_cast<lua_Integer>(i));
+
+        if (lua_pcall(L, static_cast<int>(Arguments), LUA_MULTRET, 0) != LUA_OK)
+            bench_state.SkipWithError("call failed");
+
+        benchmark::DoNotOptimize(lua_tointeger(L, -1));
+        lua_settop(L, 0);
+    }
+    lua_close(L);
+}
+BENCHMARK_TEMPLATE(BM_raw_function_call, 0);
+BENCHMARK_TEMPLATE(BM_raw_function_call, 1);
+BENCHMARK_TEMPLATE(BM_raw_function_call, 4);
+BENCHMARK_TEMPLATE(BM_raw_function_call, 8);
+
+// Caching a callback by copying a reference shares its registry slot, where creating a new reference takes a slot of its own.
+static void BM_safe_reference_copy(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_dostring(lua, arity_script);
+    lua_getglobal(lua, "f");
+    const safe_function_reference f(lua);
+    std::vector<safe_function_reference> cache;
+    cache.reserve(static_cast<std::size_t>(bench_state.range(0)));
+    for (auto _ : bench_state)
+    {
+        for (std::int64_t i = 0; i < bench_state.range(0); i++)
+            cache.push_back(f);
+        cache.clear();
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * bench_state.range(0));
+}
+BENCHMARK(BM_safe_reference_copy)->Arg(100000);
+
+static void BM_safe_reference_new(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_dostring(lua, arity_script);
+    std::vector<safe_function_reference> cache;
+    cache.reserve(static_cast<std::size_t>(bench_state.range(0)));
+    for (auto _ : bench_state)
+    {
+        for (std::int64_t i = 0; i < bench_state.range(0); i++)
+        {
+            lua_getglobal(lua, "f");
+            cache.emplace_back(lua);
+        }
+        reset_references(cache.begin(), cache.end());
+        cache.clear();
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * bench_state.range(0));
+}
+BENCHMARK(BM_safe_reference_new)->Arg(100000);
+
+static void BM_typed_function_call(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_dostring(lua, "function f(a, b) return a + b end");
+    lua_getglobal(lua, "f");
+    safe_function_reference f(lua);
+    for (auto _ : bench_state)
+        benchmark::DoNotOptimize(f.call<int>(1, 2));
+}
+BENCHMARK(BM_typed_function_call);
+
+static void BM_untyped_function_call(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_dostring(lua, "function f(a, b) return a + b end");
+    lua_getglobal(lua, "f");
+    safe_function_reference f(lua);
+    for (auto _ : bench_state)
+    {
+        int result = f(1, 2);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_untyped_function_call);
@@ -0,0 +1,100 @@
+#include <easylua/gc.hpp>
+#include <easylua/state.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+// A frame of an allocation-heavy script: every call builds a few hundred short-lived tables and strings, and keeps some of them in a
+// long-lived cache so that the heap does not only hold garbage.
+static const char *frame_script = R"(
+    cache = {}
+    local frame_number = 0
+    function frame()
+        frame_number = frame_number + 1
+        local items = {}
+        for i = 1, 200 do
+            items[i] = { id = i, name = 'item' .. i, tags = { 'a', 'b' } }
+        end
+        cache[frame_number % 1000] = items[frame_number % 200 + 1]
+        return #items
+    end
+)";
+
+enum class frame_gc
+{
+    incremental,
+    generational,
+    scheduled,
+    scheduled_generational
+};
+
+// Reports the latency percentiles of the frames. In the scheduled modes, the collector runs between frames and its time is reported
+// separately; in the generational one, each run is a single minor collection.
+static void run_frames(benchmark::State &bench_state, frame_gc mode)
+{
+    state lua(library::base | library::string);
+    luaL_dostring(lua, frame_script);
+    const bool scheduled = mode == frame_gc::scheduled || mode == frame_gc::scheduled_generational;
+    if (mode == frame_gc::generational || mode == frame_gc::scheduled_generational)
+        lua.gc().set_generational();
+
+    gc_scheduler scheduler(lua, std::chrono::microseconds(200));
+    if (!scheduled)
+        lua.gc().restart();
+
+    std::vector<double> latencies;
+    latencies.reserve(100000);
+    for (auto _ : bench_state)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        lua_getglobal(lua, "frame");
+        lua_call(lua, 0, 1);
+        lua_pop(lua, 1);
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+
+        if (scheduled)
+            scheduler.run();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    const auto percentile = [&](double p) { return latencies[static_cast<std::size_t>(p * static_cast<double>(latencies.size() - 1))]; };
+    bench_state.counters["p50_us"] = percentile(0.50);
+    bench_state.counters["p99_us"] = percentile(0.99);
+    bench_state.counters["max_us"] = latencies.back();
+    bench_state.counters["memory_kb"] = static_cast<double>(lua.gc().get_memory()) / 1024;
+    if (scheduled)
+    {
+        const gc_scheduler::statistics &statistics = scheduler.get_statistics();
+        bench_state.counters["gc_us_per_frame"] =
+            std::chrono::duration<double, std::micro>(statistics.total_time).count() / static_cast<double>(statistics.runs);
+    }
+}
+
+static void BM_gc_frame_incremental(benchmark::State &bench_state)
+{
+    run_frames(bench_state, frame_gc::incremental);
+}
+BENCHMARK(BM_gc_frame_incremental)->Iterations(20000);
+
+static void BM_gc_frame_generational(benchmark::State &bench_state)
+{
+    run_frames(bench_state, frame_gc::generational);
+}
+BENCHMARK(BM_gc_frame_generational)->Iterations(20000);
+
+static void BM_gc_frame_scheduled(benchmark::State &bench_state)
+{
+    run_frames(bench_state, frame_gc::scheduled);
+}
+BENCHMARK(BM_gc_frame_scheduled)->Iterations(20000);
+
+static void BM_gc_frame_scheduled_generational(benchmark::State &bench_state)
+{
+    run_frames(bench_state, frame_gc::scheduled_generational);
+}
+BENCHMARK(BM_gc_frame_scheduled_generational)->Iterations(20000);
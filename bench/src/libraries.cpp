@@ -0,0 +1,69 @@
+#include <easylua/state.hpp>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+static const library sandbox = library::base | library::string | library::math;
+
+static void BM_startup_openlibs(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        state lua;
+        luaL_openlibs(lua);
+        benchmark::DoNotOptimize(lua.get_state());
+    }
+}
+BENCHMARK(BM_startup_openlibs);
+
+static void BM_startup_all_lazy(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        state lua(library::all, library_mode::lazy);
+        benchmark::DoNotOptimize(lua.get_state());
+    }
+}
+BENCHMARK(BM_startup_all_lazy);
+
+static void BM_startup_sandbox_eager(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        state lua(sandbox);
+        benchmark::DoNotOptimize(lua.get_state());
+    }
+}
+BENCHMARK(BM_startup_sandbox_eager);
+
+static void BM_startup_sandbox_lazy(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        state lua(sandbox, library_mode::lazy);
+        benchmark::DoNotOptimize(lua.get_state());
+    }
+}
+BENCHMARK(BM_startup_sandbox_lazy);
+
+// Startup followed by a script that touches one library, which is where the lazy mode pays for the library it builds.
+static void BM_startup_sandbox_lazy_first_use(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        state lua(sandbox, library_mode::lazy);
+        luaL_dostring(lua, "return math.floor(1.5)");
+    }
+}
+BENCHMARK(BM_startup_sandbox_lazy_first_use);
+
+static void BM_startup_sandbox_eager_first_use(benchmark::State &bench_state)
+{
+    for (auto _ : bench_state)
+    {
+        state lua(sandbox);
+        luaL_dostring(lua, "return math.floor(1.5)");
+    }
+}
+BENCHMARK(BM_startup_sandbox_eager_first_use);
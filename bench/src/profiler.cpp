@@ -0,0 +1,57 @@
+#include <easylua/function.hpp>
+#include <easylua/profiler.hpp>
+#include <easylua/state.hpp>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+static const char *const workload = R"(
+    local function step(i)
+        return (i * 7) % 13
+    end
+
+    function workload()
+        local sum = 0
+        for i = 1, 10000 do
+            sum = sum + step(i)
+        end
+        return sum
+    end
+)";
+
+static void BM_profiler_stopped(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_openlibs(lua);
+    lua.run(workload);
+    lua_getglobal(lua, "workload");
+    safe_function_reference function(lua);
+
+    profiler profiler(lua);
+    for (auto _ : bench_state)
+    {
+        int sum = function();
+        benchmark::DoNotOptimize(sum);
+    }
+}
+BENCHMARK(BM_profiler_stopped);
+
+static void BM_profiler_running(benchmark::State &bench_state)
+{
+    state lua;
+    luaL_openlibs(lua);
+    lua.run(workload);
+    lua_getglobal(lua, "workload");
+    safe_function_reference function(lua);
+
+    profiler profiler(lua, static_cast<int>(bench_state.range(0)));
+    profiler.start();
+    for (auto _ : bench_state)
+    {
+        int sum = function();
+        benchmark::DoNotOptimize(sum);
+    }
+    profiler.stop();
+}
+BENCHMARK(BM_profiler_running)->ArgName("period")->Arg(1000)->Arg(10000)->Arg(100000);
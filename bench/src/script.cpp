@@ -0,0 +1,126 @@
+#include <easylua/script.hpp>
+
+#include <filesystem>
+#include <fstream>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+namespace
+{
+    /// @brief Writes a rule pack of roughly the given size to a temporary file.
+    class script_file
+    {
+    public:
+        explicit script_file(std::size_t size) : path_(std::filesystem::temp_directory_path() / ("easylua_bench_" + std::to_string(size) + ".lua"))
+        {
+            std::ofstream file(path_, std::ios::trunc);
+            std::size_t written = 0;
+            for (int i = 0; written < size; ++i)
+            {
+                const std::string rule = "function rule_" + std::to_string(i) + "(x) if x > " + std::to_string(i) + " then return x * 2 else return x end end\n";
+                file << rule;
+                written += rule.size();
+            }
+        }
+
+        ~script_file() { std::filesystem::remove(path_); }
+
+        std::string get_path() const { return path_.string(); }
+
+        /// @brief Asks the kernel to drop the file from the page cache.
+        void evict() const
+        {
+            const int fd = ::open(path_.c_str(), O_RDONLY);
+            if (fd < 0)
+                return;
+
+            ::fdatasync(fd);
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+
+    private:
+        std::filesystem::path path_;
+    };
+
+    template <typename Load>
+    void load_benchmark(benchmark::State &bench_state, Load load, bool cold)
+    {
+        const script_file file(static_cast<std::size_t>(bench_state.range(0)));
+        lua_State *L = luaL_newstate();
+        for (auto _ : bench_state)
+        {
+            if (cold)
+            {
+                bench_state.PauseTiming();
+                file.evict();
+                bench_state.ResumeTiming();
+            }
+
+            if (!load(L, file.get_path()))
+                bench_state.SkipWithError("load failed");
+
+            lua_settop(L, 0);
+        }
+        bench_state.SetBytesProcessed(bench_state.iterations() * bench_state.range(0));
+        lua_close(L);
+    }
+}
+
+static void BM_load_file_warm(benchmark::State &bench_state)
+{
+    load_benchmark(bench_state, script::load_file, false);
+}
+BENCHMARK(BM_load_file_warm)->Arg(64 << 10)->Arg(4 << 20);
+
+static void BM_load_file_mapped_warm(benchmark::State &bench_state)
+{
+    load_benchmark(bench_state, [](lua_State *L, const std::string &path) { return script::load_file_mapped(L, path); }, false);
+}
+BENCHMARK(BM_load_file_mapped_warm)->Arg(64 << 10)->Arg(4 << 20);
+
+static void BM_load_file_cold(benchmark::State &bench_state)
+{
+    load_benchmark(bench_state, script::load_file, true);
+}
+BENCHMARK(BM_load_file_cold)->Arg(64 << 10)->Arg(4 << 20);
+
+static void BM_load_file_mapped_cold(benchmark::State &bench_state)
+{
+    load_benchmark(bench_state, [](lua_State *L, const std::string &path) { return script::load_file_mapped(L, path); }, true);
+}
+BENCHMARK(BM_load_file_mapped_cold)->Arg(64 << 10)->Arg(4 << 20);
+
+static const std::string small_script = "local sum = 0 for i = 1, 10 do sum = sum + i end result = sum";
+
+static void BM_run_string(benchmark::State &bench_state)
+{
+    lua_State *L = luaL_newstate();
+    for (auto _ : bench_state)
+    {
+        if (!script::run_string(L, small_script))
+            bench_state.SkipWithError("run failed");
+    }
+    lua_close(L);
+}
+BENCHMARK(BM_run_string);
+
+// Compiling and running the same chunk directly through the C API, as a baseline for the wrapper overhead.
+static void BM_raw_run_string(benchmark::State &bench_state)
+{
+    lua_State *L = luaL_newstate();
+    for (auto _ : bench_state)
+    {
+        if (luaL_loadbufferx(L, small_script.data(), small_script.size(), small_script.c_str(), nullptr) != LUA_OK || lua_pcall(L, 0, LUA_MULTRET, 0) != LUA_OK)
+            bench_state.SkipWithError("run failed");
+
+        lua_settop(L, 0);
+    }
+    lua_close(L);
+}
+BENCHMARK(BM_raw_run_string);
@@ -0,0 +1,75 @@
+#include <easylua/snapshot.hpp>
+#include <easylua/state.hpp>
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+// A rule library of the kind the snapshot is meant for: many small functions and constant tables.
+static std::string make_rules(int count)
+{
+    std::string rules = "rules = {}\nweights = {}\n";
+    for (int i = 0; i < count; i++)
+    {
+        const std::string n = std::to_string(i);
+        rules += "weights[" + n + "] = { base = " + n + ", factor = 1.5, tags = { 'a', 'b', 'c' } }\n";
+        rules += "rules[" + n + "] = function(request)\n"
+                 "    local w = weights[" + n + "]\n"
+                 "    if request.kind == 'x' .. " + n + " then return w.base * w.factor end\n"
+                 "    return string.len(request.kind) + w.base\n"
+                 "end\n";
+    }
+
+    return rules;
+}
+
+// Loads the rules under a short chunk name, as a file would be. luaL_dostring names the chunk after its source, and that name is
+// part of the bytecode of every function it defines.
+static void run_rules(lua_State *L, const std::string &rules)
+{
+    if (luaL_loadbuffer(L, rules.data(), rules.size(), "=rules") == LUA_OK)
+        lua_pcall(L, 0, 0, 0);
+
+    lua_settop(L, 0);
+}
+
+static void BM_init_run_script(benchmark::State &bench_state)
+{
+    const std::string rules = make_rules(static_cast<int>(bench_state.range(0)));
+    for (auto _ : bench_state)
+    {
+        state lua(library::all);
+        run_rules(lua, rules);
+        benchmark::DoNotOptimize(lua.get_state());
+    }
+}
+BENCHMARK(BM_init_run_script)->Arg(10)->Arg(300);
+
+static void BM_init_from_snapshot(benchmark::State &bench_state)
+{
+    state source(library::all);
+    run_rules(source, make_rules(static_cast<int>(bench_state.range(0))));
+    const state_snapshot snapshot(source);
+
+    for (auto _ : bench_state)
+    {
+        state lua = snapshot.instantiate();
+        benchmark::DoNotOptimize(lua.get_state());
+    }
+}
+BENCHMARK(BM_init_from_snapshot)->Arg(10)->Arg(300);
+
+static void BM_snapshot_capture(benchmark::State &bench_state)
+{
+    state source(library::all);
+    run_rules(source, make_rules(static_cast<int>(bench_state.range(0))));
+
+    for (auto _ : bench_state)
+    {
+        const state_snapshot snapshot(source);
+        benchmark::DoNotOptimize(&snapshot);
+    }
+}
+BENCHMARK(BM_snapshot_capture)->Arg(300);
@@ -0,0 +1,215 @@
+#include <easylua/state.hpp>
+#include <easylua/usertype.hpp>
+
+#include <map>
+#include <numeric>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+static std::vector<double> make_features(std::size_t size)
+{
+    std::vector<double> features(size);
+    std::iota(features.begin(), features.end(), 0.0);
+    return features;
+}
+
+static void BM_push_vector(benchmark::State &bench_state)
+{
+    state lua;
+    const std::vector<double> features = make_features(static_cast<std::size_t>(bench_state.range(0)));
+    for (auto _ : bench_state)
+    {
+        stack::push(lua, features);
+        lua_settop(lua, 0);
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * bench_state.range(0));
+}
+BENCHMARK(BM_push_vector)->Arg(10000);
+
+// What user code does without container support: one element at a time into a table that grows as it is filled.
+static void BM_push_vector_per_element(benchmark::State &bench_state)
+{
+    state lua;
+    const std::vector<double> features = make_features(static_cast<std::size_t>(bench_state.range(0)));
+    for (auto _ : bench_state)
+    {
+        unsafe_table_reference table = unsafe_table_reference::create(lua);
+        for (std::size_t i = 0; i < features.size(); i++)
+            table.set(static_cast<lua_Integer>(i + 1), features[i]);
+        lua_settop(lua, 0);
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * bench_state.range(0));
+}
+BENCHMARK(BM_push_vector_per_element)->Arg(10000);
+
+static void BM_get_vector(benchmark::State &bench_state)
+{
+    state lua;
+    stack::push(lua, make_features(static_cast<std::size_t>(bench_state.range(0))));
+    for (auto _ : bench_state)
+    {
+        std::vector<double> features = stack::get<std::vector<double>>(lua, -1);
+        benchmark::DoNotOptimize(features.data());
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * bench_state.range(0));
+}
+BENCHMARK(BM_get_vector)->Arg(10000);
+
+namespace
+{
+    struct vector3
+    {
+        double x = 1;
+        double y = 2;
+        double z = 3;
+    };
+
+    template <typename T>
+    T sample_value()
+    {
+        if constexpr (std::is_same_v<T, bool>)
+            return true;
+        else if constexpr (std::is_arithmetic_v<T>)
+            return static_cast<T>(42);
+        else if constexpr (std::is_same_v<T, const char *>)
+            return "player_name";
+        else if constexpr (std::is_same_v<T, std::optional<int>>)
+            return 42;
+        else if constexpr (std::is_same_v<T, std::tuple<int, double, bool>>)
+            return {1, 2.0, true};
+        else if constexpr (std::is_same_v<T, std::vector<int>>)
+            return {1, 2, 3, 4, 5, 6, 7, 8};
+        else if constexpr (std::is_same_v<T, std::map<std::string, int>>)
+            return {{"hp", 100}, {"mp", 50}, {"xp", 0}};
+        else if constexpr (std::is_same_v<T, vector3>)
+            return vector3();
+        else
+            return T("player_name");
+    }
+
+    void register_vector3(lua_State *L)
+    {
+        usertype<vector3>(L, "vector3").property("x", &vector3::x).property("y", &vector3::y).property("z", &vector3::z);
+    }
+}
+
+template <typename T>
+static void BM_stack_push(benchmark::State &bench_state)
+{
+    state lua;
+    if constexpr (std::is_same_v<T, vector3>)
+        register_vector3(lua);
+
+    const T value = sample_value<T>();
+    for (auto _ : bench_state)
+    {
+        stack::push(lua, value);
+        lua_settop(lua, 0);
+    }
+}
+BENCHMARK_TEMPLATE(BM_stack_push, bool);
+BENCHMARK_TEMPLATE(BM_stack_push, int);
+BENCHMARK_TEMPLATE(BM_stack_push, double);
+BENCHMARK_TEMPLATE(BM_stack_push, const char *);
+BENCHMARK_TEMPLATE(BM_stack_push, std::string);
+BENCHMARK_TEMPLATE(BM_stack_push, std::string_view);
+BENCHMARK_TEMPLATE(BM_stack_push, std::optional<int>);
+BENCHMARK_TEMPLATE(BM_stack_push, std::tuple<int, double, bool>);
+BENCHMARK_TEMPLATE(BM_stack_push, std::vector<int>);
+BENCHMARK_TEMPLATE(BM_stack_push, std::map<std::string, int>);
+BENCHMARK_TEMPLATE(BM_stack_push, vector3);
+
+template <typename T>
+static void BM_stack_get(benchmark::State &bench_state)
+{
+    state lua;
+    if constexpr (std::is_same_v<T, vector3>)
+        register_vector3(lua);
+
+    stack::push(lua, sample_value<T>());
+    for (auto _ : bench_state)
+    {
+        T value = stack::get<T>(lua, -1);
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK_TEMPLATE(BM_stack_get, bool);
+BENCHMARK_TEMPLATE(BM_stack_get, int);
+BENCHMARK_TEMPLATE(BM_stack_get, double);
+BENCHMARK_TEMPLATE(BM_stack_get, const char *);
+BENCHMARK_TEMPLATE(BM_stack_get, std::string);
+BENCHMARK_TEMPLATE(BM_stack_get, std::string_view);
+BENCHMARK_TEMPLATE(BM_stack_get, std::optional<int>);
+BENCHMARK_TEMPLATE(BM_stack_get, std::tuple<int, double, bool>);
+BENCHMARK_TEMPLATE(BM_stack_get, std::vector<int>);
+BENCHMARK_TEMPLATE(BM_stack_get, std::map<std::string, int>);
+BENCHMARK_TEMPLATE(BM_stack_get, vector3);
+
+// The C API equivalents of the scalar and string conversions, as a baseline for the wrapper overhead.
+static void BM_raw_push_get_integer(benchmark::State &bench_state)
+{
+    state lua;
+    for (auto _ : bench_state)
+    {
+        lua_pushinteger(lua, 42);
+        int isnum = 0;
+        benchmark::DoNotOptimize(lua_tointegerx(lua, -1, &isnum));
+        lua_settop(lua, 0);
+    }
+}
+BENCHMARK(BM_raw_push_get_integer);
+
+static void BM_raw_push_get_number(benchmark::State &bench_state)
+{
+    state lua;
+    for (auto _ : bench_state)
+    {
+        lua_pushnumber(lua, 42.0);
+        int isnum = 0;
+        benchmark::DoNotOptimize(lua_tonumberx(lua, -1, &isnum));
+        lua_settop(lua, 0);
+    }
+}
+BENCHMARK(BM_raw_push_get_number);
+
+static void BM_raw_push_get_string(benchmark::State &bench_state)
+{
+    state lua;
+    const std::string value = "player_name";
+    for (auto _ : bench_state)
+    {
+        lua_pushlstring(lua, value.data(), value.size());
+        std::size_t length = 0;
+        const char *string = lua_tolstring(lua, -1, &length);
+        std::string result(string, length);
+        benchmark::DoNotOptimize(result);
+        lua_settop(lua, 0);
+    }
+}
+BENCHMARK(BM_raw_push_get_string);
+
+static void BM_stack_try_get_match(benchmark::State &bench_state)
+{
+    state lua;
+    lua_pushnumber(lua, 1.5);
+    for (auto _ : bench_state)
+        benchmark::DoNotOptimize(*stack::try_get<double>(lua, -1));
+}
+BENCHMARK(BM_stack_try_get_match);
+
+static void BM_stack_get_match(benchmark::State &bench_state)
+{
+    state lua;
+    lua_pushnumber(lua, 1.5);
+    for (auto _ : bench_state)
+        benchmark::DoNotOptimize(stack::get<double>(lua, -1));
+}
+BENCHMARK(BM_stack_get_match);
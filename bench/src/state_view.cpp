@@ -0,0 +1,77 @@
+#include <easylua/state.hpp>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+static void BM_state_index_read(benchmark::State &bench_state)
+{
+    state lua;
+    lua.run("tick_rate = 60");
+    for (auto _ : bench_state)
+    {
+        int value = lua["tick_rate"];
+        benchmark::DoNotOptimize(value);
+        lua_settop(lua, 0);
+    }
+}
+BENCHMARK(BM_state_index_read);
+
+static void BM_global_read(benchmark::State &bench_state)
+{
+    state lua;
+    lua.run("tick_rate = 60");
+    const global tick_rate = lua.get_global("tick_rate");
+    for (auto _ : bench_state)
+    {
+        int value = tick_rate;
+        benchmark::DoNotOptimize(value);
+    }
+}
+BENCHMARK(BM_global_read);
+
+static void BM_state_index_write(benchmark::State &bench_state)
+{
+    state lua;
+    int i = 0;
+    for (auto _ : bench_state)
+        lua["tick_count"] = ++i;
+}
+BENCHMARK(BM_state_index_write);
+
+static void BM_global_write(benchmark::State &bench_state)
+{
+    state lua;
+    const global tick_count = lua.get_global("tick_count");
+    int i = 0;
+    for (auto _ : bench_state)
+        tick_count.set(++i);
+}
+BENCHMARK(BM_global_write);
+
+// The C API equivalents of the global accessors, as a baseline for the wrapper overhead.
+static void BM_raw_global_read(benchmark::State &bench_state)
+{
+    state lua;
+    lua.run("tick_rate = 60");
+    for (auto _ : bench_state)
+    {
+        lua_getglobal(lua, "tick_rate");
+        int isnum = 0;
+        benchmark::DoNotOptimize(lua_tointegerx(lua, -1, &isnum));
+        lua_settop(lua, 0);
+    }
+}
+BENCHMARK(BM_raw_global_read);
+
+static void BM_raw_global_write(benchmark::State &bench_state)
+{
+    state lua;
+    lua_Integer i = 0;
+    for (auto _ : bench_state)
+    {
+        lua_pushinteger(lua, ++i);
+        lua_setglobal(lua, "tick_count");
+    }
+}
+BENCHMARK(BM_raw_global_write);
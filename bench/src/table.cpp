@@ -0,0 +1,39 @@
+#include <easylua/state.hpp>
+
+#include <benchmark/benchmark.h>
+
+using namespace easylua;
+
+static void BM_table_fill(benchmark::State &bench_state)
+{
+    state lua;
+    const int size = static_cast<int>(bench_state.range(0));
+    const int array_size = bench_state.range(1) ? size : 0;
+    for (auto _ : bench_state)
+    {
+        safe_table_reference table = lua.create_table(array_size);
+        for (int i = 1; i <= size; i++)
+            table.raw_set(i, i);
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * size);
+}
+BENCHMARK(BM_table_fill)->ArgNames({"size", "presized"})->ArgsProduct({{16, 1024}, {0, 1}});
+
+static void BM_table_for_each(benchmark::State &bench_state)
+{
+    state lua;
+    const int size = static_cast<int>(bench_state.range(0));
+    safe_table_reference table = lua.create_table(0, size);
+    for (int i = 0; i < size; i++)
+        table.set("key" + std::to_string(i), i);
+
+    for (auto _ : bench_state)
+    {
+        lua_Integer sum = 0;
+        table.for_each<std::string_view, lua_Integer>([&](std::string_view, lua_Integer value)
+                                                      { sum += value; });
+        benchmark::DoNotOptimize(sum);
+    }
+    bench_state.SetItemsProcessed(bench_state.iterations() * size);
+}
+BENCHMARK(BM_table_for_each)->Arg(1024);
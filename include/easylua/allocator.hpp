@@ -0,0 +1,483 @@
+#ifndef __EASYLUA_ALLOCATOR_H
+#define __EASYLUA_ALLOCATOR_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+
+namespace easylua
+{
+    /**
+     * @brief Base class for allocators that can be passed to a state. A state takes ownership of its allocator and destroys it after the
+     * Lua state has been closed.
+     *
+     * Derived classes implement the lua_Alloc contract through reallocate():
+     *  - new_size == 0: free ptr (which may be null) and return null.
+     *  - ptr == nullptr: allocate a new block of new_size bytes. old_size then encodes the type of the object and must be ignored.
+     *  - otherwise: resize the block at ptr from old_size to new_size bytes. Shrinking must never fail.
+     */
+    class allocator
+    {
+    public:
+        virtual ~allocator() = default;
+
+        virtual void *reallocate(void *ptr, std::size_t old_size, std::size_t new_size) = 0;
+    };
+
+    namespace detail
+    {
+        /**
+         * @brief lua_Alloc trampoline for an allocator. It is instantiated for the concrete allocator type so that the call is not dispatched
+         * through the vtable when the type is final.
+         */
+        template <typename Allocator>
+        void *allocate(void *ud, void *ptr, std::size_t old_size, std::size_t new_size)
+        {
+            return static_cast<Allocator *>(ud)->reallocate(ptr, ptr ? old_size : 0, new_size);
+        }
+
+        /// @brief The alignment that blocks handed to Lua need to satisfy.
+        static constexpr std::size_t allocation_alignment = alignof(std::max_align_t);
+
+        constexpr std::size_t align_up(std::size_t size)
+        {
+            return (size + allocation_alignment - 1) & ~(allocation_alignment - 1);
+        }
+
+        /**
+         * @brief Records a chunk so that it can be released later. Allocators are called from within the Lua VM, so a failure is reported
+         * through the return value rather than an exception. The chunk is freed on failure.
+         */
+        inline bool track_chunk(std::vector<void *> &chunks, void *chunk) noexcept
+        {
+            try
+            {
+                chunks.push_back(chunk);
+                return true;
+            }
+            catch (const std::bad_alloc &)
+            {
+                std::free(chunk);
+                return false;
+            }
+        }
+    } // namespace detail
+
+    /// @brief Allocator that forwards to the C runtime, equivalent to the allocator that luaL_newstate uses.
+    class default_allocator final : public allocator
+    {
+    public:
+        void *reallocate(void *ptr, std::size_t, std::size_t new_size) override
+        {
+            if (new_size == 0)
+            {
+                std::free(ptr);
+                return nullptr;
+            }
+
+            return std::realloc(ptr, new_size);
+        }
+    };
+
+    /**
+     * @brief Allocator with segregated free lists for small blocks. Blocks up to max_pooled_size bytes are carved from large chunks and
+     * recycled through a free list per size class, larger blocks are forwarded to the C runtime. All chunks are released at once when the
+     * allocator is destroyed, which happens after the owning state has been closed.
+     */
+    class pool_allocator final : public allocator
+    {
+    public:
+        static constexpr std::size_t max_pooled_size = 256;
+        static constexpr std::size_t default_chunk_size = 64 * 1024;
+
+        /**
+         * @brief Construct a new pool_allocator object
+         *
+         * @param chunk_size The size of the chunks that small blocks are carved from.
+         * @throw invalid_argument If chunk_size is smaller than max_pooled_size.
+         */
+        explicit pool_allocator(std::size_t chunk_size = default_chunk_size) : chunk_size_(detail::align_up(chunk_size))
+        {
+            if (chunk_size_ < max_pooled_size)
+                throw invalid_argument("chunk_size", "cannot be smaller than the largest pooled block");
+
+            free_lists_.fill(nullptr);
+        }
+
+        ~pool_allocator()
+        {
+            for (void *chunk : chunks_)
+                std::free(chunk);
+        }
+
+        pool_allocator(const pool_allocator &other) = delete;
+        pool_allocator &operator=(const pool_allocator &other) = delete;
+
+        void *reallocate(void *ptr, std::size_t old_size, std::size_t new_size) override
+        {
+            if (new_size == 0)
+            {
+                deallocate(ptr, old_size);
+                return nullptr;
+            }
+
+            if (!ptr)
+                return allocate(new_size);
+
+            // Both sizes fall in the same size class, the block can be reused as is.
+            if (is_pooled(old_size) && is_pooled(new_size) && size_class(old_size) == size_class(new_size))
+                return ptr;
+
+            if (!is_pooled(old_size) && !is_pooled(new_size))
+                return std::realloc(ptr, new_size);
+
+            void *new_ptr = allocate(new_size);
+            if (!new_ptr)
+                return new_size < old_size ? keep_shrunk_block(ptr, old_size) : nullptr;
+
+            std::memcpy(new_ptr, ptr, std::min(old_size, new_size));
+            deallocate(ptr, old_size);
+            return new_ptr;
+        }
+
+    private:
+        static constexpr std::size_t number_of_classes = max_pooled_size / detail::allocation_alignment;
+
+        struct free_block
+        {
+            free_block *next;
+        };
+
+        static bool is_pooled(std::size_t size) { return size > 0 && size <= max_pooled_size; }
+        static std::size_t size_class(std::size_t size) { return (size - 1) / detail::allocation_alignment; }
+
+        void *allocate(std::size_t size)
+        {
+            if (!is_pooled(size))
+                return std::malloc(size);
+
+            const std::size_t index = size_class(size);
+            if (free_block *block = free_lists_[index])
+            {
+                free_lists_[index] = block->next;
+                return block;
+            }
+
+            const std::size_t block_size = (index + 1) * detail::allocation_alignment;
+            if (chunk_remaining_ < block_size)
+            {
+                // Hand the tail of the current chunk to the free lists before starting a new one.
+                while (chunk_remaining_ >= detail::allocation_alignment)
+                {
+                    const std::size_t tail_class = std::min(size_class(chunk_remaining_), number_of_classes - 1);
+                    const std::size_t tail_size = (tail_class + 1) * detail::allocation_alignment;
+                    push_free(chunk_cursor_, tail_class);
+                    chunk_cursor_ += tail_size;
+                    chunk_remaining_ -= tail_size;
+                }
+
+                void *chunk = std::malloc(chunk_size_);
+                if (!chunk || !detail::track_chunk(chunks_, chunk))
+                    return nullptr;
+                chunk_cursor_ = static_cast<char *>(chunk);
+                chunk_remaining_ = chunk_size_;
+            }
+
+            void *block = chunk_cursor_;
+            chunk_cursor_ += block_size;
+            chunk_remaining_ -= block_size;
+            return block;
+        }
+
+        /**
+         * @brief Keeps a block that could not be moved to a smaller size class, because shrinking must never fail. Lua frees it with its
+         * new size, so it is recycled through the free list of that class; a block from the C runtime is then released with the chunks.
+         * If even that cannot be recorded, the block is leaked rather than handed to std::free twice.
+         */
+        void *keep_shrunk_block(void *ptr, std::size_t old_size) noexcept
+        {
+            if (!is_pooled(old_size))
+            {
+                try
+                {
+                    chunks_.push_back(ptr);
+                }
+                catch (const std::bad_alloc &)
+                {
+                }
+            }
+
+            return ptr;
+        }
+
+        void deallocate(void *ptr, std::size_t size)
+        {
+            if (!ptr)
+                return;
+
+            if (!is_pooled(size))
+            {
+                std::free(ptr);
+                return;
+            }
+
+            push_free(ptr, size_class(size));
+        }
+
+        void push_free(void *ptr, std::size_t index)
+        {
+            free_block *block = static_cast<free_block *>(ptr);
+            block->next = free_lists_[index];
+            free_lists_[index] = block;
+        }
+
+        std::size_t chunk_size_;
+        std::vector<void *> chunks_;
+        char *chunk_cursor_ = nullptr;
+        std::size_t chunk_remaining_ = 0;
+        std::array<free_block *, number_of_classes> free_lists_;
+    };
+
+    /**
+     * @brief Bump allocator. Blocks are handed out sequentially from large chunks and are only reclaimed when the arena is destroyed, with
+     * the exception of the most recent block which can be grown, shrunk and freed in place. This suits short-lived states that are closed
+     * before they produce much garbage. The state that owns the arena destroys it after lua_close, so its memory is never released while
+     * the state can still use it.
+     */
+    class arena_allocator final : public allocator
+    {
+    public:
+        static constexpr std::size_t default_chunk_size = 256 * 1024;
+
+        /**
+         * @brief Construct a new arena_allocator object
+         *
+         * @param chunk_size The size of the chunks that blocks are carved from. Larger blocks get a chunk of their own.
+         * @throw invalid_argument If chunk_size is 0.
+         */
+        explicit arena_allocator(std::size_t chunk_size = default_chunk_size) : chunk_size_(detail::align_up(chunk_size))
+        {
+            if (chunk_size_ == 0)
+                throw invalid_argument("chunk_size", "cannot be 0");
+        }
+
+        ~arena_allocator()
+        {
+            release();
+        }
+
+        arena_allocator(const arena_allocator &other) = delete;
+        arena_allocator &operator=(const arena_allocator &other) = delete;
+
+        void *reallocate(void *ptr, std::size_t old_size, std::size_t new_size) override
+        {
+            const std::size_t old_aligned = detail::align_up(old_size);
+            const std::size_t new_aligned = detail::align_up(new_size);
+
+            if (ptr && is_last(ptr, old_aligned))
+            {
+                // The most recent block can be resized in place as long as it fits in the current chunk.
+                if (new_aligned <= old_aligned + (chunk_end_ - cursor_))
+                {
+                    cursor_ = static_cast<char *>(ptr) + new_aligned;
+                    return new_size == 0 ? nullptr : ptr;
+                }
+            }
+
+            if (new_size == 0)
+                return nullptr;
+
+            if (ptr && new_aligned <= old_aligned)
+                return ptr;
+
+            void *new_ptr = allocate(new_aligned);
+            if (new_ptr && ptr)
+                std::memcpy(new_ptr, ptr, std::min(old_size, new_size));
+
+            return new_ptr;
+        }
+
+    private:
+        bool is_last(void *ptr, std::size_t aligned_size) const
+        {
+            return static_cast<char *>(ptr) + aligned_size == cursor_;
+        }
+
+        void *allocate(std::size_t aligned_size)
+        {
+            if (aligned_size > static_cast<std::size_t>(chunk_end_ - cursor_))
+            {
+                const std::size_t size = std::max(aligned_size, chunk_size_);
+                char *chunk = static_cast<char *>(std::malloc(size));
+                if (!chunk || !detail::track_chunk(chunks_, chunk))
+                    return nullptr;
+
+                // Only switch to the new chunk if it leaves more room than the current one.
+                const std::size_t remaining = size - aligned_size;
+                if (remaining > static_cast<std::size_t>(chunk_end_ - cursor_))
+                {
+                    cursor_ = chunk + aligned_size;
+                    chunk_end_ = chunk + size;
+                }
+
+                return chunk;
+            }
+
+            void *block = cursor_;
+            cursor_ += aligned_size;
+            return block;
+        }
+
+        void release()
+        {
+            for (void *chunk : chunks_)
+                std::free(chunk);
+        }
+
+        std::size_t chunk_size_;
+        std::vector<void *> chunks_;
+        char *cursor_ = nullptr;
+        char *chunk_end_ = nullptr;
+    };
+
+    /// @brief Adapts a std::pmr::memory_resource so that it can be used as the allocator of a state.
+    class memory_resource_allocator final : public allocator
+    {
+    public:
+        /**
+         * @brief Construct a new memory_resource_allocator object
+         *
+         * @param resource The memory resource to allocate from. It must outlive the state.
+         * @throw invalid_argument If resource is null.
+         */
+        explicit memory_resource_allocator(std::pmr::memory_resource *resource) : resource_(resource)
+        {
+            if (!resource_)
+                throw invalid_argument("resource", "cannot be null");
+        }
+
+        void *reallocate(void *ptr, std::size_t old_size, std::size_t new_size) override
+        {
+            if (new_size == 0)
+            {
+                if (ptr)
+                    resource_->deallocate(ptr, old_size, detail::allocation_alignment);
+                return nullptr;
+            }
+
+            void *new_ptr = nullptr;
+            try
+            {
+                new_ptr = resource_->allocate(new_size, detail::allocation_alignment);
+            }
+            catch (const std::bad_alloc &)
+            {
+                // Lua expects a failed allocation to return null, exceptions must not unwind through the VM.
+                return nullptr;
+            }
+
+            if (ptr)
+            {
+                std::memcpy(new_ptr, ptr, std::min(old_size, new_size));
+                resource_->deallocate(ptr, old_size, detail::allocation_alignment);
+            }
+
+            return new_ptr;
+        }
+
+    private:
+        std::pmr::memory_resource *resource_;
+    };
+
+    /**
+     * @brief Allocator that keeps track of the memory used by a state and optionally enforces a hard limit on it. Allocations are forwarded
+     * to an underlying allocator. An allocation that would exceed the limit fails, which Lua reports as LUA_ERRMEM; script::run_string and
+     * script::run_file return it as load_result::result::memory_error.
+     */
+    class tracking_allocator final : public allocator
+    {
+    public:
+        /// @brief Value of the limit that disables it.
+        static constexpr std::size_t no_limit = 0;
+
+        /**
+         * @brief Construct a new tracking_allocator object
+         *
+         * @param limit The maximum number of bytes that may be allocated at the same time, or no_limit.
+         * @param allocator The allocator to forward allocations to.
+         * @throw invalid_argument If allocator is null.
+         */
+        explicit tracking_allocator(std::size_t limit = no_limit, std::unique_ptr<allocator> allocator = std::make_unique<default_allocator>())
+            : allocator_(std::move(allocator)), limit_(limit)
+        {
+            if (!allocator_)
+                throw invalid_argument("allocator", "cannot be null");
+        }
+
+        void *reallocate(void *ptr, std::size_t old_size, std::size_t new_size) override
+        {
+            if (new_size > old_size && limit_ != no_limit && new_size - old_size > limit_ - std::min(live_bytes_, limit_))
+            {
+                ++failed_allocation_count_;
+                return nullptr;
+            }
+
+            void *new_ptr = allocator_->reallocate(ptr, old_size, new_size);
+            if (new_size > 0 && !new_ptr)
+            {
+                ++failed_allocation_count_;
+                return nullptr;
+            }
+
+            live_bytes_ = live_bytes_ - old_size + new_size;
+            peak_bytes_ = std::max(peak_bytes_, live_bytes_);
+            if (!ptr && new_size > 0)
+                ++allocation_count_;
+
+            return new_ptr;
+        }
+
+        /// @brief Returns the number of bytes that are currently allocated.
+        std::size_t get_live_bytes() const { return live_bytes_; }
+
+        /// @brief Returns the highest number of bytes that were allocated at the same time.
+        std::size_t get_peak_bytes() const { return peak_bytes_; }
+
+        /// @brief Returns the number of blocks that were allocated, not counting resizes.
+        std::size_t get_allocation_count() const { return allocation_count_; }
+
+        /// @brief Returns the number of allocations that failed, either because of the limit or because the underlying allocator failed.
+        std::size_t get_failed_allocation_count() const { return failed_allocation_count_; }
+
+        std::size_t get_limit() const { return limit_; }
+
+        /**
+         * @brief Sets the limit. Lowering the limit below the number of live bytes does not free anything, but makes every further
+         * allocation fail until enough memory has been released.
+         */
+        void set_limit(std::size_t limit) { limit_ = limit; }
+
+        /// @brief Resets the peak to the number of bytes that are currently allocated.
+        void reset_peak() { peak_bytes_ = live_bytes_; }
+
+    private:
+        std::unique_ptr<allocator> allocator_;
+        std::size_t limit_;
+        std::size_t live_bytes_ = 0;
+        std::size_t peak_bytes_ = 0;
+        std::size_t allocation_count_ = 0;
+        std::size_t failed_allocation_count_ = 0;
+    };
+} // namespace easylua
+
+#endif
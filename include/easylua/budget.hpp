@@ -0,0 +1,299 @@
+#ifndef __EASYLUA_BUDGET_H
+#define __EASYLUA_BUDGET_H
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+
+namespace easylua
+{
+    /**
+     * @brief Limits on how much work Lua code may do before it is aborted.
+     *
+     * Both limits are enforced by a count hook that runs every granularity VM instructions. The instruction limit is exact, and the deadline
+     * is checked by the same hook. Note that Lua 5.4 makes every instruction slower while a count hook is set, whatever its count, so a
+     * budget has a cost that the granularity does not remove.
+     *
+     * For a deadline, a watchdog thread also sets the hook of the thread that created the budget to run on every instruction when the
+     * deadline passes, so a large granularity does not delay the abort there. Time spent inside a single C function, such as a long
+     * string.rep, is not interrupted.
+     */
+    struct execution_budget
+    {
+        /// @brief The maximum number of VM instructions, or 0 for no limit.
+        std::uint64_t max_instructions = 0;
+        /// @brief The maximum wall-clock time, or 0 for no limit.
+        std::chrono::nanoseconds max_duration{0};
+        /// @brief The number of instructions between two checks.
+        int granularity = 1000;
+    };
+
+    namespace detail
+    {
+        struct budget_state
+        {
+            lua_State *state;
+            std::uint64_t max_instructions;
+            std::chrono::steady_clock::time_point deadline;
+            bool has_deadline;
+            int granularity;
+            std::uint64_t instructions;
+            bool exceeded;
+        };
+
+        inline const void *budget_key()
+        {
+            static const char key = 0;
+            return &key;
+        }
+
+        /// @brief Returns the budget of the innermost budget_scope of the state, or null if there is none.
+        inline budget_state *active_budget(lua_State *L)
+        {
+            lua_rawgetp(L, LUA_REGISTRYINDEX, budget_key());
+            auto *budget = static_cast<budget_state *>(lua_touserdata(L, -1));
+            lua_pop(L, 1);
+            return budget;
+        }
+
+        /// @brief Returns whether the innermost budget of the state has run out. Used to tell budget errors apart from other errors.
+        inline bool is_budget_exceeded(lua_State *L)
+        {
+            const budget_state *budget = active_budget(L);
+            return budget && budget->exceeded;
+        }
+
+        /// @brief Returns the number of instructions until the next check.
+        inline int next_count(const budget_state &budget)
+        {
+            if (budget.max_instructions == 0)
+                return budget.granularity;
+
+            const std::uint64_t remaining = budget.max_instructions - budget.instructions;
+            return static_cast<int>(std::min<std::uint64_t>(remaining, static_cast<std::uint64_t>(budget.granularity)));
+        }
+
+        inline void budget_hook(lua_State *L, lua_Debug *)
+        {
+            budget_state *budget = active_budget(L);
+            if (!budget)
+                return;
+
+            if (!budget->exceeded)
+            {
+                // The count of the thread that runs, which coroutines inherit when they are created and the watchdog may have changed.
+                const int count = lua_gethookcount(L);
+                if (budget->max_instructions != 0)
+                    budget->instructions += static_cast<std::uint64_t>(count);
+
+                const bool out_of_instructions = budget->max_instructions != 0 && budget->instructions >= budget->max_instructions;
+                const bool out_of_time = budget->has_deadline && std::chrono::steady_clock::now() >= budget->deadline;
+                if (!out_of_instructions && !out_of_time)
+                {
+                    const int next = next_count(*budget);
+                    if (next != count)
+                        lua_sethook(L, &budget_hook, LUA_MASKCOUNT, next);
+
+                    return;
+                }
+
+                // From now on the error is raised for every instruction, so a pcall in the script cannot catch it and carry on.
+                budget->exceeded = true;
+                lua_sethook(L, &budget_hook, LUA_MASKCOUNT, 1);
+            }
+
+            luaL_error(L, "execution budget exceeded");
+        }
+
+        /**
+         * @brief A thread that makes the budget hook run on every instruction once the deadline of a budget has passed. lua_sethook may be
+         * called while the state runs, which is how the standalone interpreter stops a script on Ctrl-C.
+         */
+        class budget_watchdog
+        {
+        public:
+            static budget_watchdog &get_instance()
+            {
+                static budget_watchdog watchdog;
+                return watchdog;
+            }
+
+            ~budget_watchdog()
+            {
+                {
+                    const std::lock_guard<std::mutex> lock(mutex_);
+                    stop_ = true;
+                }
+
+                changed_.notify_one();
+                thread_.join();
+            }
+
+            void add(budget_state *budget)
+            {
+                bool earliest = false;
+                {
+                    const std::lock_guard<std::mutex> lock(mutex_);
+                    const auto entry = deadlines_.emplace(budget->deadline, budget);
+                    earliest = entry == deadlines_.begin();
+                }
+
+                if (earliest)
+                    changed_.notify_one();
+            }
+
+            /// @brief Removes a budget. Once this returns, the watchdog no longer touches the state of the budget.
+            void remove(budget_state *budget)
+            {
+                const std::lock_guard<std::mutex> lock(mutex_);
+                const auto range = deadlines_.equal_range(budget->deadline);
+                for (auto it = range.first; it != range.second; ++it)
+                {
+                    if (it->second == budget)
+                    {
+                        deadlines_.erase(it);
+                        break;
+                    }
+                }
+            }
+
+        private:
+            budget_watchdog() : thread_([this]
+                                        { run(); })
+            {
+            }
+
+            void run()
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (!stop_)
+                {
+                    if (deadlines_.empty())
+                    {
+                        changed_.wait(lock);
+                        continue;
+                    }
+
+                    if (deadlines_.begin()->first > std::chrono::steady_clock::now())
+                    {
+                        changed_.wait_until(lock, deadlines_.begin()->first);
+                        continue;
+                    }
+
+                    lua_sethook(deadlines_.begin()->second->state, &budget_hook, LUA_MASKCOUNT, 1);
+                    deadlines_.erase(deadlines_.begin());
+                }
+            }
+
+            std::mutex mutex_;
+            std::condition_variable changed_;
+            std::multimap<std::chrono::steady_clock::time_point, budget_state *> deadlines_;
+            bool stop_ = false;
+            std::thread thread_;
+        };
+    } // namespace detail
+
+    /**
+     * @brief Applies an execution_budget to all Lua code that runs on a thread while the scope exists. When the budget runs out, the
+     * running code is aborted with an error. script::run_string and the other run functions then return load_result::result::
+     * budget_exceeded, and calling a function reference throws budget_exceeded.
+     *
+     * The budget uses the count hook of the thread. A hook that was set before is replaced while the budget is enforced and restored when
+     * the scope ends. Coroutines created while the scope exists inherit the hook, so they are limited too, and keep it after the scope
+     * ends; it then applies the budget of the enclosing scope, if any, and otherwise does nothing. Coroutines created before the scope have
+     * their own hooks and are not limited. Scopes can be nested; the innermost one applies.
+     *
+     * Usage:
+     *                      execution_budget budget;
+     *                      budget.max_duration = std::chrono::milliseconds(50);
+     *                      budget_scope scope(L, budget);
+     *                      on_request(request);
+     */
+    class budget_scope
+    {
+    public:
+        /**
+         * @brief Construct a new budget_scope object and start the budget.
+         *
+         * @throw invalid_argument If state is null or the granularity is not positive.
+         */
+        budget_scope(lua_State *state, const execution_budget &budget) : lua_state_(state)
+        {
+            if (!lua_state_)
+                throw invalid_argument("state", "cannot be null");
+
+            if (budget.granularity <= 0)
+                throw invalid_argument("budget", "granularity must be positive");
+
+            budget_.state = lua_state_;
+            budget_.max_instructions = budget.max_instructions;
+            budget_.has_deadline = budget.max_duration.count() > 0;
+            budget_.deadline = std::chrono::steady_clock::now() + budget.max_duration;
+            budget_.granularity = budget.granularity;
+            budget_.instructions = 0;
+            budget_.exceeded = false;
+
+            previous_hook_ = lua_gethook(lua_state_);
+            previous_mask_ = lua_gethookmask(lua_state_);
+            previous_count_ = lua_gethookcount(lua_state_);
+            previous_budget_ = detail::active_budget(lua_state_);
+
+            lua_pushlightuserdata(lua_state_, &budget_);
+            lua_rawsetp(lua_state_, LUA_REGISTRYINDEX, detail::budget_key());
+
+            if (budget_.max_instructions == 0 && !budget_.has_deadline)
+                return;
+
+            lua_sethook(lua_state_, &detail::budget_hook, LUA_MASKCOUNT, detail::next_count(budget_));
+            if (budget_.has_deadline)
+                detail::budget_watchdog::get_instance().add(&budget_);
+        }
+
+        ~budget_scope()
+        {
+            if (budget_.has_deadline)
+                detail::budget_watchdog::get_instance().remove(&budget_);
+
+            if (previous_budget_)
+                lua_pushlightuserdata(lua_state_, previous_budget_);
+            else
+                lua_pushnil(lua_state_);
+
+            lua_rawsetp(lua_state_, LUA_REGISTRYINDEX, detail::budget_key());
+            lua_sethook(lua_state_, previous_hook_, previous_mask_, previous_count_);
+
+            // The watchdog drops a budget once it has tightened the hook, which this scope replaced, so the enclosing budget is re-armed
+            // here if its deadline passed while this scope was active.
+            if (previous_budget_ && previous_budget_->has_deadline && std::chrono::steady_clock::now() >= previous_budget_->deadline)
+                lua_sethook(lua_state_, &detail::budget_hook, LUA_MASKCOUNT, 1);
+        }
+
+        budget_scope(const budget_scope &other) = delete;
+        budget_scope &operator=(const budget_scope &other) = delete;
+
+        /// @brief Returns whether the budget has run out.
+        bool is_exceeded() const { return budget_.exceeded; }
+
+        /// @brief Returns the number of instructions counted so far, rounded down to the last check. Only counted with an instruction limit.
+        std::uint64_t get_instructions() const { return budget_.instructions; }
+
+    private:
+        lua_State *lua_state_;
+        detail::budget_state budget_;
+
+        lua_Hook previous_hook_;
+        int previous_mask_;
+        int previous_count_;
+        detail::budget_state *previous_budget_;
+    };
+} // namespace easylua
+
+#endif
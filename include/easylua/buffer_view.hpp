@@ -0,0 +1,380 @@
+#ifndef __EASYLUA_BUFFER_VIEW_H
+#define __EASYLUA_BUFFER_VIEW_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+#include "stack.hpp"
+#include "usertype.hpp"
+
+namespace easylua
+{
+    class buffer_view;
+
+    /**
+     * @brief Owns the right of Lua to read a block of C++ memory. Views created through an owner become stale when the owner is released
+     * or destroyed, and accessing a stale view raises an error instead of reading freed memory.
+     *
+     * The owner must be released on the thread that runs the state, or while no Lua code runs on it.
+     */
+    class buffer_owner
+    {
+    public:
+        buffer_owner() : alive_(std::make_shared<std::atomic<bool>>(true)) {}
+        ~buffer_owner() { release(); }
+
+        buffer_owner(const buffer_owner &other) = delete;
+        buffer_owner &operator=(const buffer_owner &other) = delete;
+
+        /// @brief Makes all views of this owner stale. Call this before the memory is freed or reused.
+        void release() { alive_->store(false, std::memory_order_release); }
+
+        bool is_released() const { return !alive_->load(std::memory_order_acquire); }
+
+        /// @brief Creates a read only view of the given memory.
+        buffer_view view(const void *data, std::size_t size) const;
+
+        /// @brief Creates a view of the given memory that Lua can also write to.
+        buffer_view mutable_view(void *data, std::size_t size) const;
+
+    private:
+        std::shared_ptr<std::atomic<bool>> alive_;
+    };
+
+    /**
+     * @brief A view of a block of C++ memory that can be passed to Lua without copying it.
+     *
+     * Register the type with register_type() before pushing a view. In Lua, positions are 1-based like in the string library:
+     *  - view[i] reads the byte at position i, or nil if i is out of range. view[i] = byte writes it if the view is mutable.
+     *  - #view is the size in bytes.
+     *  - view:u8(i), view:u16(i), view:u32(i), view:f32(i) and view:f64(i) read a little-endian value that starts at position i.
+     *  - view:set_u8(i, value) and the other setters write one, if the view is mutable.
+     *  - view:sub(i [, j]) returns the view of the bytes i to j, which shares the memory and the owner of this view.
+     *  - view:tostring([i [, j]]) and tostring(view) copy the bytes into a Lua string.
+     *
+     * A view without an owner never becomes stale; the caller must then keep the memory alive as long as Lua can reach the view.
+     *
+     * Usage:
+     *                      buffer_view::register_type(L);
+     *                      buffer_owner owner;
+     *                      stack::push(L, owner.view(packet.data(), packet.size()));
+     *                      lua_setglobal(L, "packet");
+     *                      lua.run("length = packet:u16(3)");
+     *                      owner.release();
+     */
+    class buffer_view
+    {
+    public:
+        /// @brief Construct a new buffer_view object that views nothing.
+        buffer_view() = default;
+
+        /// @brief Construct a new read only buffer_view object without an owner.
+        buffer_view(const void *data, std::size_t size) : data_(static_cast<unsigned char *>(const_cast<void *>(data))), size_(size) {}
+
+        /// @brief Construct a new mutable buffer_view object without an owner.
+        static buffer_view writable(void *data, std::size_t size)
+        {
+            buffer_view view(data, size);
+            view.writable_ = true;
+            return view;
+        }
+
+        const unsigned char *data() const { return data_; }
+        std::size_t size() const { return size_; }
+        bool is_writable() const { return writable_; }
+
+        /// @brief Returns whether the memory can still be accessed, that is whether the owner, if any, has not been released.
+        bool is_valid() const { return !alive_ || alive_->load(std::memory_order_acquire); }
+
+        /**
+         * @brief Returns the view of size bytes starting at the 0-based offset.
+         *
+         * @throw invalid_argument If the range is not inside the view.
+         */
+        buffer_view subview(std::size_t offset, std::size_t size) const
+        {
+            if (offset > size_ || size > size_ - offset)
+                throw invalid_argument("offset", "is out of range");
+
+            buffer_view view = *this;
+            view.data_ = data_ + offset;
+            view.size_ = size;
+            return view;
+        }
+
+        /**
+         * @brief Reads a little-endian value at the 0-based offset.
+         *
+         * @tparam T An unsigned integer, float or double.
+         * @throw invalid_operation If the view is stale.
+         * @throw invalid_argument If the value is not inside the view.
+         */
+        template <typename T>
+        T read(std::size_t offset) const
+        {
+            const unsigned char *bytes = access(offset, sizeof(T));
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                using bits_type = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+                const bits_type bits = load<bits_type>(bytes);
+                T value;
+                std::memcpy(&value, &bits, sizeof(T));
+                return value;
+            }
+            else
+                return load<T>(bytes);
+        }
+
+        /**
+         * @brief Writes a little-endian value at the 0-based offset.
+         *
+         * @throw invalid_operation If the view is stale or read only.
+         * @throw invalid_argument If the value is not inside the view.
+         */
+        template <typename T>
+        void write(std::size_t offset, T value) const
+        {
+            if (!writable_)
+                throw invalid_operation("buffer view is read only");
+
+            unsigned char *bytes = access(offset, sizeof(T));
+            if constexpr (std::is_floating_point_v<T>)
+            {
+                using bits_type = std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+                bits_type bits;
+                std::memcpy(&bits, &value, sizeof(T));
+                store(bytes, bits);
+            }
+            else
+                store(bytes, value);
+        }
+
+        /**
+         * @brief Registers the buffer_view usertype with a state. Views can only be pushed to states where the type is registered.
+         *
+         * @param L The Lua state.
+         * @param name The name of the type in Lua.
+         */
+        static void register_type(lua_State *L, const char *name = "buffer_view");
+
+    private:
+        friend class buffer_owner;
+
+        unsigned char *access(std::size_t offset, std::size_t size) const
+        {
+            if (!is_valid())
+                throw invalid_operation("buffer view is no longer valid");
+
+            if (offset > size_ || size > size_ - offset)
+                throw invalid_argument("offset", "is out of range");
+
+            return data_ + offset;
+        }
+
+        // Byte by byte, so that the result does not depend on the endianness or alignment of the host. Compilers turn this into a single
+        // load on little-endian targets.
+        template <typename T>
+        static T load(const unsigned char *bytes)
+        {
+            T value = 0;
+            for (std::size_t i = 0; i < sizeof(T); i++)
+                value |= static_cast<T>(static_cast<T>(bytes[i]) << (8 * i));
+
+            return value;
+        }
+
+        template <typename T>
+        static void store(unsigned char *bytes, T value)
+        {
+            for (std::size_t i = 0; i < sizeof(T); i++)
+                bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+        }
+
+        unsigned char *data_ = nullptr;
+        std::size_t size_ = 0;
+        bool writable_ = false;
+        std::shared_ptr<std::atomic<bool>> alive_;
+    };
+
+    inline buffer_view buffer_owner::view(const void *data, std::size_t size) const
+    {
+        buffer_view view(data, size);
+        view.alive_ = alive_;
+        return view;
+    }
+
+    inline buffer_view buffer_owner::mutable_view(void *data, std::size_t size) const
+    {
+        buffer_view view = buffer_view::writable(data, size);
+        view.alive_ = alive_;
+        return view;
+    }
+
+    namespace detail
+    {
+        /// @brief Converts a 1-based Lua position to a 0-based offset. Positions outside the view map to the size, which fails the range check.
+        inline std::size_t to_offset(const buffer_view &view, lua_Integer position)
+        {
+            if (position < 1 || static_cast<std::size_t>(position) > view.size())
+                return view.size();
+
+            return static_cast<std::size_t>(position - 1);
+        }
+
+        /**
+         * @brief Returns the view that __index or __newindex was called on, or raises a Lua error if the first argument is not a view with
+         * the metatable in upvalue 2. Upvalue 3 tells whether that metatable is the one for pointers.
+         */
+        inline const buffer_view *self_view(lua_State *L)
+        {
+            // The metamethods can be called directly with any value, for example through debug.getmetatable.
+            bool is_view = lua_type(L, 1) == LUA_TUSERDATA && lua_getmetatable(L, 1);
+            if (is_view)
+            {
+                is_view = lua_rawequal(L, -1, lua_upvalueindex(2));
+                lua_pop(L, 1);
+            }
+
+            if (!is_view)
+                luaL_typeerror(L, 1, "buffer_view");
+
+            void *userdata = lua_touserdata(L, 1);
+            if (lua_toboolean(L, lua_upvalueindex(3)))
+                return *static_cast<buffer_view **>(userdata);
+
+            return static_cast<buffer_view *>(userdata);
+        }
+
+        /// @brief __index of buffer views: a byte for an integer key, a method otherwise. Upvalues: methods, metatable, is pointer.
+        inline int buffer_view_index(lua_State *L)
+        {
+            int is_integer = 0;
+            const lua_Integer position = lua_tointegerx(L, 2, &is_integer);
+            if (!is_integer)
+            {
+                lua_pushvalue(L, 2);
+                lua_rawget(L, lua_upvalueindex(1));
+                return 1;
+            }
+
+            const buffer_view *view = self_view(L);
+            if (!view->is_valid())
+                return luaL_error(L, "buffer view is no longer valid");
+
+            if (position < 1 || static_cast<std::size_t>(position) > view->size())
+                lua_pushnil(L);
+            else
+                lua_pushinteger(L, view->data()[position - 1]);
+
+            return 1;
+        }
+
+        /// @brief __newindex of buffer views: writes a byte. Upvalues: methods, metatable, is pointer.
+        inline int buffer_view_newindex(lua_State *L)
+        {
+            const buffer_view *view = self_view(L);
+            const lua_Integer position = luaL_checkinteger(L, 2);
+            const lua_Integer value = luaL_checkinteger(L, 3);
+            if (!view->is_valid())
+                return luaL_error(L, "buffer view is no longer valid");
+
+            if (!view->is_writable())
+                return luaL_error(L, "buffer view is read only");
+
+            if (position < 1 || static_cast<std::size_t>(position) > view->size())
+                return luaL_error(L, "position %d is out of range", static_cast<int>(position));
+
+            const_cast<unsigned char *>(view->data())[position - 1] = static_cast<unsigned char>(value);
+            return 0;
+        }
+
+        /// @brief Converts the 1-based inclusive range i to j of a Lua call to an offset and size, clamped like string.sub.
+        inline std::pair<std::size_t, std::size_t> to_range(const buffer_view &view, std::optional<lua_Integer> first, std::optional<lua_Integer> last)
+        {
+            if (!view.is_valid())
+                throw invalid_operation("buffer view is no longer valid");
+
+            const auto size = static_cast<lua_Integer>(view.size());
+            const lua_Integer i = std::max<lua_Integer>(first.value_or(1), 1);
+            const lua_Integer j = std::min<lua_Integer>(last.value_or(size), size);
+            if (i > j)
+                return {0, 0};
+
+            return {static_cast<std::size_t>(i - 1), static_cast<std::size_t>(j - i + 1)};
+        }
+
+        inline std::string_view to_string_view(const buffer_view &view, std::optional<lua_Integer> first, std::optional<lua_Integer> last)
+        {
+            const auto [offset, size] = to_range(view, first, last);
+            return std::string_view(reinterpret_cast<const char *>(view.data()) + offset, size);
+        }
+    } // namespace detail
+
+    inline void buffer_view::register_type(lua_State *L, const char *name)
+    {
+        usertype<buffer_view>(L, name)
+            .method("u8", [](const buffer_view &view, lua_Integer position)
+                    { return view.read<std::uint8_t>(detail::to_offset(view, position)); })
+            .method("u16", [](const buffer_view &view, lua_Integer position)
+                    { return view.read<std::uint16_t>(detail::to_offset(view, position)); })
+            .method("u32", [](const buffer_view &view, lua_Integer position)
+                    { return static_cast<lua_Integer>(view.read<std::uint32_t>(detail::to_offset(view, position))); })
+            .method("f32", [](const buffer_view &view, lua_Integer position)
+                    { return view.read<float>(detail::to_offset(view, position)); })
+            .method("f64", [](const buffer_view &view, lua_Integer position)
+                    { return view.read<double>(detail::to_offset(view, position)); })
+            .method("set_u8", [](const buffer_view &view, lua_Integer position, lua_Integer value)
+                    { view.write(detail::to_offset(view, position), static_cast<std::uint8_t>(value)); })
+            .method("set_u16", [](const buffer_view &view, lua_Integer position, lua_Integer value)
+                    { view.write(detail::to_offset(view, position), static_cast<std::uint16_t>(value)); })
+            .method("set_u32", [](const buffer_view &view, lua_Integer position, lua_Integer value)
+                    { view.write(detail::to_offset(view, position), static_cast<std::uint32_t>(value)); })
+            .method("set_f32", [](const buffer_view &view, lua_Integer position, double value)
+                    { view.write(detail::to_offset(view, position), static_cast<float>(value)); })
+            .method("set_f64", [](const buffer_view &view, lua_Integer position, double value)
+                    { view.write(detail::to_offset(view, position), value); })
+            .method("sub", [](const buffer_view &view, lua_Integer first, std::optional<lua_Integer> last)
+                    {
+                        const auto [offset, size] = detail::to_range(view, first, last);
+                        return view.subview(offset, size); })
+            .method("tostring", [](const buffer_view &view, std::optional<lua_Integer> first, std::optional<lua_Integer> last)
+                    { return detail::to_string_view(view, first, last); })
+            .metamethod("__tostring", [](const buffer_view &view)
+                        { return detail::to_string_view(view, std::nullopt, std::nullopt); })
+            .metamethod("__len", [](const buffer_view &view)
+                        { return static_cast<lua_Integer>(view.size()); });
+
+        // Integer keys are bytes, so __index and __newindex are replaced with functions that check for them before the methods. Scripts
+        // cannot get or replace the metatables, since a view points into memory that the script does not own.
+        for (const bool pointer : {false, true})
+        {
+            detail::push_metatable<buffer_view>(L, pointer);
+            for (const auto &[field, function] : {std::pair<const char *, lua_CFunction>("__index", &detail::buffer_view_index),
+                                                  std::pair<const char *, lua_CFunction>("__newindex", &detail::buffer_view_newindex)})
+            {
+                lua_getfield(L, -1, "__methods");
+                lua_pushvalue(L, -2);
+                lua_pushboolean(L, pointer);
+                lua_pushcclosure(L, function, 3);
+                lua_setfield(L, -2, field);
+            }
+
+            lua_pushboolean(L, false);
+            lua_setfield(L, -2, "__metatable");
+            lua_pop(L, 1);
+        }
+    }
+} // namespace easylua
+
+#endif
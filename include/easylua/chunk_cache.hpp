@@ -0,0 +1,200 @@
+#ifndef __EASYLUA_CHUNK_CACHE_H
+#define __EASYLUA_CHUNK_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <unordered_map>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+#include "script.hpp"
+
+namespace easylua
+{
+    namespace script
+    {
+        /**
+         * @brief Caches compiled chunks of a Lua state so that loading the same script again does not parse and compile it again.
+         * Chunks loaded from a string are keyed by their contents, chunks loaded from a file are keyed by their path and invalidated when
+         * the modification time or size of the file changes. The compiled functions are kept alive through references in the registry.
+         *
+         * A cache hit pushes the same function object that was pushed for the first load. Main chunks only have the _ENV upvalue, so this
+         * is indistinguishable from a fresh load unless that upvalue is replaced through lua_setupvalue.
+         *
+         * The cache must not outlive the Lua state it was created for.
+         */
+        class chunk_cache
+        {
+        public:
+            /**
+             * @brief Construct a new chunk_cache object
+             *
+             * @param L The Lua state.
+             * @throw invalid_argument If L is null.
+             */
+            explicit chunk_cache(lua_State *L) : lua_state_(L)
+            {
+                if (!lua_state_)
+                    throw invalid_argument("state", "cannot be null");
+            }
+
+            ~chunk_cache()
+            {
+                clear();
+            }
+
+            chunk_cache(const chunk_cache &other) = delete;
+            chunk_cache &operator=(const chunk_cache &other) = delete;
+
+            /**
+             * @brief Loads a script from a string without running it. The compiled function is pushed onto the stack if the load succeeds.
+             *
+             * @param script The script.
+             * @return load_result The result of the load.
+             */
+            load_result load_string(const std::string &script)
+            {
+                const auto it = strings_.find(script);
+                if (it != strings_.end())
+                {
+                    ++hits_;
+                    lua_rawgeti(lua_state_, LUA_REGISTRYINDEX, it->second);
+                    return load_result(load_result::result::ok);
+                }
+
+                ++misses_;
+                const load_result result = script::load_string(lua_state_, script);
+                if (result)
+                    strings_.emplace(script, store());
+
+                return result;
+            }
+
+            /**
+             * @brief Loads a script from a file without running it. The compiled function is pushed onto the stack if the load succeeds.
+             *
+             * @param path The path to the script.
+             * @return load_result The result of the load.
+             * @throw invalid_argument If the path is empty.
+             */
+            load_result load_file(const std::string &path)
+            {
+                if (path.empty())
+                    throw invalid_argument("path", "cannot be empty");
+
+                std::error_code error;
+                const auto modified = std::filesystem::last_write_time(path, error);
+                const auto size = error ? 0 : std::filesystem::file_size(path, error);
+                if (error)
+                {
+                    // Let Lua report the problem with the file.
+                    ++misses_;
+                    return script::load_file(lua_state_, path);
+                }
+
+                const auto it = files_.find(path);
+                if (it != files_.end())
+                {
+                    if (it->second.modified == modified && it->second.size == size)
+                    {
+                        ++hits_;
+                        lua_rawgeti(lua_state_, LUA_REGISTRYINDEX, it->second.reference);
+                        return load_result(load_result::result::ok);
+                    }
+
+                    luaL_unref(lua_state_, LUA_REGISTRYINDEX, it->second.reference);
+                    files_.erase(it);
+                }
+
+                ++misses_;
+                const load_result result = script::load_file(lua_state_, path);
+                if (result)
+                    files_.emplace(path, file_entry{modified, size, store()});
+
+                return result;
+            }
+
+            /**
+             * @brief Runs a script from a string, compiling it only if it is not cached yet.
+             *
+             * @param script The script.
+             * @return load_result The result of the run.
+             */
+            load_result run_string(const std::string &script)
+            {
+                const load_result load_result = load_string(script);
+                if (!load_result)
+                    return load_result;
+
+                const int result = lua_pcall(lua_state_, 0, LUA_MULTRET, 0);
+                return internal::handle_result(lua_state_, result);
+            }
+
+            /**
+             * @brief Runs a script from a file, compiling it only if it is not cached yet or if the file changed.
+             *
+             * @param path The path to the script.
+             * @return load_result The result of the run.
+             * @throw invalid_argument If the path is empty.
+             */
+            load_result run_file(const std::string &path)
+            {
+                const load_result load_result = load_file(path);
+                if (!load_result)
+                    return load_result;
+
+                const int result = lua_pcall(lua_state_, 0, LUA_MULTRET, 0);
+                return internal::handle_result(lua_state_, result);
+            }
+
+            /// @brief Releases all cached chunks. The hit and miss counters are not reset.
+            void clear()
+            {
+                for (const auto &entry : strings_)
+                    luaL_unref(lua_state_, LUA_REGISTRYINDEX, entry.second);
+
+                for (const auto &entry : files_)
+                    luaL_unref(lua_state_, LUA_REGISTRYINDEX, entry.second.reference);
+
+                strings_.clear();
+                files_.clear();
+            }
+
+            /// @brief Returns the number of loads that were served from the cache.
+            std::size_t get_hits() const { return hits_; }
+
+            /// @brief Returns the number of loads that had to compile the script.
+            std::size_t get_misses() const { return misses_; }
+
+            /// @brief Returns the number of cached chunks.
+            std::size_t size() const { return strings_.size() + files_.size(); }
+
+        private:
+            struct file_entry
+            {
+                std::filesystem::file_time_type modified;
+                std::uintmax_t size;
+                int reference;
+            };
+
+            /// @brief Stores the function at the top of the stack in the registry, leaving it on the stack.
+            int store()
+            {
+                lua_pushvalue(lua_state_, -1);
+                return luaL_ref(lua_state_, LUA_REGISTRYINDEX);
+            }
+
+            lua_State *lua_state_;
+            std::unordered_map<std::string, int> strings_;
+            std::unordered_map<std::string, file_entry> files_;
+            std::size_t hits_ = 0;
+            std::size_t misses_ = 0;
+        };
+    } // namespace script
+} // namespace easylua
+
+#endif
@@ -0,0 +1,487 @@
+#ifndef __EASYLUA_COROUTINE_H
+#define __EASYLUA_COROUTINE_H
+
+#include <exception>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define EASYLUA_HAS_COROUTINES 1
+#endif
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+#include "function.hpp"
+#include "reference.hpp"
+#include "stack.hpp"
+
+namespace easylua
+{
+    /// @brief The status of a coroutine, as reported by coroutine.status in Lua.
+    enum class coroutine_status
+    {
+        /// @brief The coroutine has not started yet or is waiting in a yield.
+        suspended,
+        /// @brief The coroutine is running, or has resumed another coroutine.
+        running,
+        /// @brief The coroutine has finished or stopped with an error.
+        dead
+    };
+
+    /**
+     * @brief Represents the result of resuming a coroutine: the values it yielded or returned. Like function_result, this class is meant to
+     * be temporary. The values are popped from the stack of the coroutine when it is destroyed.
+     */
+    class resume_result : public function_result
+    {
+    public:
+        resume_result(lua_State *thread, std::size_t number_of_results, bool finished) : function_result(thread, number_of_results), finished_(finished)
+        {
+        }
+
+        /// @brief Returns whether the coroutine returned, as opposed to yielded.
+        bool is_finished() const { return finished_; }
+
+        /// @brief Returns whether the coroutine yielded and can be resumed again.
+        bool is_yielded() const { return !finished_; }
+
+    private:
+        bool finished_;
+    };
+
+#ifdef EASYLUA_HAS_COROUTINES
+    class script_task;
+#endif
+
+    /**
+     * @brief Holds a Lua coroutine (a thread) through a reference in the registry.
+     *
+     * A coroutine has its own stack but shares the globals and the garbage collector of the state it was created in, so creating one is
+     * cheap compared to creating a state. A coroutine_reference can be moved but not copied.
+     */
+    class coroutine_reference : public safe_reference
+    {
+    public:
+        coroutine_reference(lua_State *state, int index = -1) : safe_reference(state, index, LUA_TTHREAD), thread_(nullptr), finished_(false)
+        {
+            push();
+            thread_ = lua_tothread(lua_state_, -1);
+            lua_pop(lua_state_, 1);
+        }
+
+        coroutine_reference(const coroutine_reference &other) = delete;
+        coroutine_reference &operator=(const coroutine_reference &other) = delete;
+
+        coroutine_reference(coroutine_reference &&other) : safe_reference(std::move(other)), thread_(other.thread_), finished_(other.finished_)
+        {
+            other.thread_ = nullptr;
+        }
+
+        coroutine_reference &operator=(coroutine_reference &&other)
+        {
+            if (this != &other)
+            {
+                safe_reference::operator=(std::move(other));
+                thread_ = other.thread_;
+                finished_ = other.finished_;
+                other.thread_ = nullptr;
+            }
+
+            return *this;
+        }
+
+        /**
+         * @brief Creates a new coroutine that runs the given function.
+         *
+         * @param state The Lua state.
+         * @param index The index of the function on the stack. The function is not removed.
+         * @throw invalid_argument If state is null.
+         * @throw type_error If the value at the given index is not a function.
+         */
+        static coroutine_reference create(lua_State *state, int index = -1)
+        {
+            if (!state)
+                throw invalid_argument("state", "cannot be null");
+
+            if (lua_type(state, index) != LUA_TFUNCTION)
+                throw type_error(index, lua_type(state, index), LUA_TFUNCTION);
+
+            const int function = lua_absindex(state, index);
+            lua_State *thread = lua_newthread(state);
+            lua_pushvalue(state, function);
+            lua_xmove(state, thread, 1);
+            return coroutine_reference(state, -1);
+        }
+
+        /// @brief Returns the Lua thread of the coroutine.
+        lua_State *get_thread() const { return thread_; }
+
+        /**
+         * @brief Returns the status of the coroutine. A coroutine that returned through resume() is dead even while its results are still on
+         * its stack. A coroutine that was resumed from Lua instead is only known to be dead once its stack is empty, as coroutine.status
+         * reports it.
+         */
+        coroutine_status get_status() const
+        {
+            if (finished_)
+                return coroutine_status::dead;
+
+            switch (lua_status(thread_))
+            {
+            case LUA_YIELD:
+                return coroutine_status::suspended;
+            case LUA_OK:
+            {
+                lua_Debug debug;
+                if (lua_getstack(thread_, 0, &debug))
+                    return coroutine_status::running;
+
+                return lua_gettop(thread_) == 0 ? coroutine_status::dead : coroutine_status::suspended;
+            }
+            default:
+                return coroutine_status::dead;
+            }
+        }
+
+        /**
+         * @brief Resumes the coroutine. The first resume starts the function with the arguments. After that, the arguments become the
+         * results of the yield that suspended the coroutine.
+         *
+         * @return resume_result The values that the coroutine yielded or returned.
+         * @throw invalid_operation If the coroutine is not suspended.
+         * @throw runtime_error If the coroutine raises an error. The coroutine is dead afterwards.
+         */
+        template <typename... Args>
+        resume_result resume(Args &&...args)
+        {
+            if (get_status() != coroutine_status::suspended)
+                throw invalid_operation("cannot resume a coroutine that is not suspended");
+
+            int results = 0;
+            const int status = lua_resume(thread_, lua_state_, push_arguments(std::forward<Args>(args)...), &results);
+            finished_ = status != LUA_YIELD;
+            if (status != LUA_OK && status != LUA_YIELD)
+                throw_error();
+
+            return resume_result(thread_, static_cast<std::size_t>(results), status == LUA_OK);
+        }
+
+#ifdef EASYLUA_HAS_COROUTINES
+        /**
+         * @brief Runs the coroutine as a C++20 coroutine. When the script calls a bound C++ function that returns an awaitable, the Lua
+         * coroutine is suspended and the returned script_task awaits the awaitable; once it completes, the Lua coroutine is resumed with
+         * its result. This way many scripts can wait on I/O at the same time on a single thread. Plain yields from the script resume it
+         * right away.
+         *
+         * The task starts immediately, and the arguments are pushed before it first suspends, so they do not need to outlive the call. The
+         * coroutine_reference must outlive the task.
+         */
+        template <typename... Args>
+        script_task resume_async(Args &&...args);
+#endif
+
+    private:
+        template <typename... Args>
+        int push_arguments(Args &&...args)
+        {
+            // The arguments are pushed onto the state of the reference so that references from any thread can be pushed.
+            if constexpr (sizeof...(Args) > 0)
+            {
+                EASYLUA_STACK_CHECK(lua_state_);
+                stack::push(lua_state_, std::forward<Args>(args)...);
+                lua_xmove(lua_state_, thread_, static_cast<int>(sizeof...(Args)));
+            }
+
+            return static_cast<int>(sizeof...(Args));
+        }
+
+        [[noreturn]] void throw_error()
+        {
+            const char *message = lua_tostring(thread_, -1);
+            const std::string error = message ? message : "error object is not a string";
+            lua_pop(thread_, 1);
+            throw runtime_error(error);
+        }
+
+        lua_State *thread_;
+        bool finished_;
+    };
+
+#ifdef EASYLUA_HAS_COROUTINES
+    namespace detail
+    {
+        template <typename A, typename = void>
+        struct is_awaitable : std::false_type
+        {
+        };
+
+        template <typename A>
+        struct is_awaitable<A, std::void_t<decltype(std::declval<A &>().await_ready()), decltype(std::declval<A &>().await_resume())>> : std::true_type
+        {
+        };
+
+        /// @brief An awaitable returned by a bound function, with its type erased, waiting to be awaited by a script_task.
+        class pending_operation
+        {
+        public:
+            virtual ~pending_operation() = default;
+
+            virtual bool await_ready() = 0;
+
+            virtual std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiting) = 0;
+
+            /// @brief Pushes the result of the awaitable onto the stack of the coroutine and returns the number of values pushed.
+            virtual int await_resume(lua_State *L) = 0;
+        };
+
+        template <typename A>
+        class pending_awaitable final : public pending_operation
+        {
+        public:
+            explicit pending_awaitable(A awaitable) : awaitable_(std::move(awaitable)) {}
+
+            bool await_ready() override { return awaitable_.await_ready(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiting) override
+            {
+                using result = decltype(awaitable_.await_suspend(waiting));
+                if constexpr (std::is_void_v<result>)
+                {
+                    awaitable_.await_suspend(waiting);
+                    return std::noop_coroutine();
+                }
+                else if constexpr (std::is_same_v<result, bool>)
+                    return awaitable_.await_suspend(waiting) ? std::noop_coroutine() : waiting;
+                else
+                    return awaitable_.await_suspend(waiting);
+            }
+
+            int await_resume(lua_State *L) override
+            {
+                if constexpr (std::is_void_v<decltype(awaitable_.await_resume())>)
+                {
+                    awaitable_.await_resume();
+                    return 0;
+                }
+                else
+                {
+                    stack::push(L, awaitable_.await_resume());
+                    return 1;
+                }
+            }
+
+        private:
+            A awaitable_;
+        };
+
+        using pending_operation_pointer = std::unique_ptr<pending_operation>;
+
+        /// @brief Returns the pending operation in the userdata at the given index, or null if the value is not one.
+        inline pending_operation *to_pending_operation(lua_State *L, int index)
+        {
+            if (lua_type(L, index) != LUA_TUSERDATA || !lua_getmetatable(L, index))
+                return nullptr;
+
+            lua_rawgetp(L, LUA_REGISTRYINDEX, type_key<pending_operation_pointer>());
+            const bool pending = lua_rawequal(L, -1, -2);
+            lua_pop(L, 2);
+            return pending ? static_cast<pending_operation_pointer *>(lua_touserdata(L, index))->get() : nullptr;
+        }
+
+        /// @brief Awaits a pending_operation from a script_task.
+        struct pending_operation_awaiter
+        {
+            pending_operation &operation;
+
+            bool await_ready() { return operation.await_ready(); }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> waiting) { return operation.await_suspend(waiting); }
+            void await_resume() {}
+        };
+
+        /// @brief Bound functions that return an awaitable yield it, boxed in a userdata, to the script_task that runs the coroutine.
+        template <typename A>
+        struct yield_traits<A, std::enable_if_t<is_awaitable<A>::value>>
+        {
+            static constexpr bool yields = true;
+
+            static int push(lua_State *L, A &&awaitable)
+            {
+                auto *memory = lua_newuserdatauv(L, sizeof(pending_operation_pointer), 0);
+                auto *pointer = new (memory) pending_operation_pointer();
+
+                if (lua_rawgetp(L, LUA_REGISTRYINDEX, type_key<pending_operation_pointer>()) == LUA_TNIL)
+                {
+                    lua_pop(L, 1);
+                    lua_createtable(L, 0, 1);
+                    lua_pushcfunction(L, &destroy_userdata<pending_operation_pointer>);
+                    lua_setfield(L, -2, "__gc");
+                    lua_pushvalue(L, -1);
+                    lua_rawsetp(L, LUA_REGISTRYINDEX, type_key<pending_operation_pointer>());
+                }
+
+                lua_setmetatable(L, -2);
+                *pointer = std::make_unique<pending_awaitable<A>>(std::move(awaitable));
+                return 1;
+            }
+        };
+    } // namespace detail
+
+    /**
+     * @brief A C++20 coroutine that runs a Lua coroutine until it returns. Created by coroutine_reference::resume_async().
+     *
+     * The task can be awaited from another C++ coroutine, or polled with is_done() from an event loop. When it is done, the values that the
+     * Lua coroutine returned are on its stack and can be read once with get_results().
+     */
+    class script_task
+    {
+    public:
+        struct promise_type
+        {
+            lua_State *thread = nullptr;
+            int results = 0;
+            std::exception_ptr exception;
+            std::coroutine_handle<> continuation;
+
+            promise_type() = default;
+
+            template <typename... Args>
+            promise_type(coroutine_reference &coroutine, Args &&...) : thread(coroutine.get_thread())
+            {
+            }
+
+            script_task get_return_object() { return script_task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+
+            std::suspend_never initial_suspend() noexcept { return {}; }
+
+            auto final_suspend() noexcept
+            {
+                struct final_awaiter
+                {
+                    bool await_ready() noexcept { return false; }
+
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept
+                    {
+                        const std::coroutine_handle<> continuation = handle.promise().continuation;
+                        return continuation ? continuation : std::noop_coroutine();
+                    }
+
+                    void await_resume() noexcept {}
+                };
+
+                return final_awaiter{};
+            }
+
+            void return_value(int number_of_results) { results = number_of_results; }
+
+            void unhandled_exception() { exception = std::current_exception(); }
+        };
+
+        ~script_task()
+        {
+            if (handle_)
+                handle_.destroy();
+        }
+
+        script_task(const script_task &other) = delete;
+        script_task &operator=(const script_task &other) = delete;
+
+        script_task(script_task &&other) : handle_(std::exchange(other.handle_, nullptr)) {}
+
+        script_task &operator=(script_task &&other)
+        {
+            std::swap(handle_, other.handle_);
+            return *this;
+        }
+
+        /// @brief Returns whether the Lua coroutine has returned or raised an error.
+        bool is_done() const { return handle_.done(); }
+
+        /**
+         * @brief Returns the values that the Lua coroutine returned. Can only be called once the task is done.
+         *
+         * @throw invalid_operation If the task is not done.
+         * @throw runtime_error If the Lua coroutine raised an error, or the exception thrown by an awaitable.
+         */
+        function_result get_results()
+        {
+            if (!handle_.done())
+                throw invalid_operation("the script has not finished");
+
+            promise_type &promise = handle_.promise();
+            if (promise.exception)
+                std::rethrow_exception(promise.exception);
+
+            return function_result(promise.thread, static_cast<std::size_t>(std::exchange(promise.results, 0)));
+        }
+
+        auto operator co_await() noexcept
+        {
+            struct awaiter
+            {
+                std::coroutine_handle<promise_type> handle;
+
+                bool await_ready() noexcept { return handle.done(); }
+
+                void await_suspend(std::coroutine_handle<> waiting) noexcept { handle.promise().continuation = waiting; }
+
+                void await_resume()
+                {
+                    if (handle.promise().exception)
+                        std::rethrow_exception(handle.promise().exception);
+                }
+            };
+
+            return awaiter{handle_};
+        }
+
+    private:
+        explicit script_task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+        std::coroutine_handle<promise_type> handle_;
+    };
+
+    template <typename... Args>
+    script_task coroutine_reference::resume_async(Args &&...args)
+    {
+        if (get_status() != coroutine_status::suspended)
+            throw invalid_operation("cannot resume a coroutine that is not suspended");
+
+        lua_State *thread = thread_;
+        int arguments = push_arguments(std::forward<Args>(args)...);
+
+        for (;;)
+        {
+            int results = 0;
+            const int status = lua_resume(thread, lua_state_, arguments, &results);
+            finished_ = status != LUA_YIELD;
+            if (status == LUA_OK)
+                co_return results;
+
+            if (status != LUA_YIELD)
+                throw_error();
+
+            detail::pending_operation *operation = results == 1 ? detail::to_pending_operation(thread, -1) : nullptr;
+            if (!operation)
+            {
+                lua_pop(thread, results);
+                arguments = 0;
+                continue;
+            }
+
+            // The userdata stays on the stack of the coroutine while it is awaited, so it cannot be collected.
+            co_await detail::pending_operation_awaiter{*operation};
+            arguments = operation->await_resume(thread);
+        }
+    }
+#endif
+} // namespace easylua
+
+#endif
@@ -1,12 +1,28 @@
 #ifndef __EASYLUA_H
 #define __EASYLUA_H
 
+#include "allocator.hpp"
+#include "budget.hpp"
+#include "buffer_view.hpp"
+#include "chunk_cache.hpp"
+#include "coroutine.hpp"
 #include "exception.hpp"
+#include "expected.hpp"
 #include "function.hpp"
+#include "gc.hpp"
+#include "global.hpp"
+#include "libraries.hpp"
+#include "profiler.hpp"
 #include "script.hpp"
+#include "snapshot.hpp"
 #include "stack.hpp"
+#include "stack_guard.hpp"
 #include "state.hpp"
+#include "state_pool.hpp"
 #include "state_view.hpp"
+#include "string_reference.hpp"
+#include "table.hpp"
 #include "types.hpp"
+#include "usertype.hpp"
 
 #endif
\ No newline at end of file
@@ -15,9 +15,19 @@ namespace easylua
     class type_error : public runtime_error
     {
     public:
-        type_error(int index, int actual_type, int expected_type) : runtime_error("Type mismatch at index " + std::to_string(index) + ": expected " + std::to_string(expected_type) + ", got " + std::to_string(actual_type))
+        type_error(int index, int actual_type, int expected_type) : runtime_error("Type mismatch at index " + std::to_string(index) + ": expected " + std::to_string(expected_type) + ", got " + std::to_string(actual_type)),
+                                                                     index_(index), actual_type_(actual_type), expected_type_(expected_type)
         {
         }
+
+        int get_index() const { return index_; }
+        int get_actual_type() const { return actual_type_; }
+        int get_expected_type() const { return expected_type_; }
+
+    private:
+        int index_;
+        int actual_type_;
+        int expected_type_;
     };
 
     class invalid_argument : public runtime_error
@@ -28,6 +38,15 @@ namespace easylua
         }
     };
 
+    /// @brief Thrown when Lua code is aborted because its execution_budget ran out.
+    class budget_exceeded : public runtime_error
+    {
+    public:
+        budget_exceeded(std::string message) : runtime_error(message)
+        {
+        }
+    };
+
     class invalid_operation : public runtime_error
     {
     public:
@@ -0,0 +1,205 @@
+#ifndef __EASYLUA_EXPECTED_H
+#define __EASYLUA_EXPECTED_H
+
+#include <optional>
+#include <string>
+#include <utility>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+
+namespace easylua
+{
+    /// @brief The kinds of error that the non-throwing functions return.
+    enum class error_code : unsigned char
+    {
+        /// @brief A value does not have the expected type.
+        type_mismatch,
+        /// @brief The stack index 0 was used.
+        invalid_index,
+        /// @brief A called function raised an error.
+        call_failed,
+        /// @brief A called function was aborted by an execution_budget.
+        budget_exceeded
+    };
+
+    /**
+     * @brief The error of a non-throwing operation such as stack::try_get or try_call. A type mismatch only records what went wrong, and its
+     * message is built when message() is called; a failed call copies the message of its error object, so the error stays the same after
+     * other calls fail or the state is closed.
+     */
+    class error
+    {
+    public:
+        static error type_mismatch(int index, int actual_type, int expected_type)
+        {
+            return error(error_code::type_mismatch, index, actual_type, expected_type);
+        }
+
+        static error invalid_index() { return error(error_code::invalid_index, 0, LUA_TNONE, LUA_TNONE); }
+
+        /// @brief An error raised by a called function, with the message of its error object.
+        static error call_failed(std::string message, bool budget_exceeded)
+        {
+            error result(budget_exceeded ? error_code::budget_exceeded : error_code::call_failed, 0, LUA_TNONE, LUA_TNONE);
+            result.message_ = std::move(message);
+            return result;
+        }
+
+        error_code get_code() const { return code_; }
+
+        /// @brief Returns the stack index of a type mismatch.
+        int get_index() const { return index_; }
+
+        /// @brief Returns the type that a mismatched value has, as a LUA_T* constant.
+        int get_actual_type() const { return actual_type_; }
+
+        /// @brief Returns the type that a mismatched value should have had, as a LUA_T* constant.
+        int get_expected_type() const { return expected_type_; }
+
+        /// @brief Returns the message of the error.
+        std::string message() const
+        {
+            switch (code_)
+            {
+            case error_code::type_mismatch:
+                return std::string("Type mismatch at index ") + std::to_string(index_) + ": expected " + type_name(expected_type_) + ", got " +
+                       type_name(actual_type_);
+            case error_code::invalid_index:
+                return "Invalid argument 'index': cannot be 0";
+            default:
+                return message_;
+            }
+        }
+
+        /// @brief Throws the exception that the throwing version of the operation would have thrown.
+        [[noreturn]] void raise() const
+        {
+            switch (code_)
+            {
+            case error_code::type_mismatch:
+                throw type_error(index_, actual_type_, expected_type_);
+            case error_code::invalid_index:
+                throw invalid_argument("index", "cannot be 0");
+            case error_code::budget_exceeded:
+                throw budget_exceeded(message());
+            default:
+                throw runtime_error(message());
+            }
+        }
+
+    private:
+        error(error_code code, int index, int actual_type, int expected_type)
+            : code_(code), index_(index), actual_type_(actual_type), expected_type_(expected_type)
+        {
+        }
+
+        static const char *type_name(int type)
+        {
+            // The names of lua_typename, which needs a state.
+            static const char *const names[] = {"no value", "nil", "boolean", "userdata", "number", "string", "table", "function", "userdata", "thread"};
+            return type >= LUA_TNONE && type < LUA_NUMTYPES ? names[type + 1] : "?";
+        }
+
+        error_code code_;
+        int index_;
+        int actual_type_;
+        int expected_type_;
+        std::string message_;
+    };
+
+    /**
+     * @brief Either a value or an error, like std::expected. It is returned by the non-throwing functions, so a value of the wrong type is
+     * handled without an exception.
+     *
+     * Usage:
+     *                      expected<double> score = stack::try_get<double>(L, -1);
+     *                      if (score)
+     *                          use(*score);
+     *                      else if (score.get_error().get_actual_type() != LUA_TNIL)
+     *                          log(score.get_error().message());
+     */
+    template <typename T>
+    class expected
+    {
+    public:
+        expected(T value) : value_(std::move(value)), error_(error::invalid_index()) {}
+        expected(error error) : error_(error) {}
+
+        bool has_value() const { return value_.has_value(); }
+        explicit operator bool() const { return value_.has_value(); }
+
+        /// @brief Returns the value, or throws the exception of the error.
+        T &value() &
+        {
+            if (!value_)
+                error_.raise();
+
+            return *value_;
+        }
+
+        const T &value() const &
+        {
+            if (!value_)
+                error_.raise();
+
+            return *value_;
+        }
+
+        T &&value() &&
+        {
+            if (!value_)
+                error_.raise();
+
+            return std::move(*value_);
+        }
+
+        /// @brief Returns the value, or the given value if there is an error.
+        template <typename U>
+        T value_or(U &&other) const &
+        {
+            return value_ ? *value_ : static_cast<T>(std::forward<U>(other));
+        }
+
+        T &operator*() & { return *value_; }
+        const T &operator*() const & { return *value_; }
+        T &&operator*() && { return std::move(*value_); }
+        T *operator->() { return &*value_; }
+        const T *operator->() const { return &*value_; }
+
+        /// @brief Returns the error. Only meaningful if there is no value.
+        const error &get_error() const { return error_; }
+
+    private:
+        std::optional<T> value_;
+        error error_;
+    };
+
+    /// @brief The result of an operation that returns nothing, or its error.
+    template <>
+    class expected<void>
+    {
+    public:
+        expected() : has_value_(true), error_(error::invalid_index()) {}
+        expected(error error) : has_value_(false), error_(error) {}
+
+        bool has_value() const { return has_value_; }
+        explicit operator bool() const { return has_value_; }
+
+        /// @brief Throws the exception of the error, if there is one.
+        void value() const
+        {
+            if (!has_value_)
+                error_.raise();
+        }
+
+        const error &get_error() const { return error_; }
+
+    private:
+        bool has_value_;
+        error error_;
+    };
+} // namespace easylua
+
+#endif
@@ -1,11 +1,18 @@
 #ifndef __EASYLUA_FUNCTION_H
 #define __EASYLUA_FUNCTION_H
 
+#include <cstddef>
+#include <string>
+#include <string_view>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 
 #include <lua.hpp>
 
+#include "budget.hpp"
 #include "exception.hpp"
+#include "expected.hpp"
 #include "reference.hpp"
 #include "stack.hpp"
 
@@ -74,6 +81,138 @@ namespace easylua
 
     namespace detail
     {
+        /// @brief Pops the error of a failed call and throws it.
+        [[noreturn]] inline void throw_call_error(lua_State *L)
+        {
+            const char *message = lua_tostring(L, -1);
+            const std::string error_message = message ? message : "error object is not a string";
+            stack::pop(L, 1);
+            if (detail::is_budget_exceeded(L))
+                throw budget_exceeded(error_message);
+
+            throw runtime_error(error_message);
+        }
+
+        /// @brief The number of results a typed call asks for: none for void, one per element for a std::tuple, and one otherwise.
+        template <typename R>
+        struct result_count : std::integral_constant<int, 1>
+        {
+        };
+
+        template <>
+        struct result_count<void> : std::integral_constant<int, 0>
+        {
+        };
+
+        template <typename... T>
+        struct result_count<std::tuple<T...>> : std::integral_constant<int, static_cast<int>(sizeof...(T))>
+        {
+        };
+
+        /// @brief True for result types that refer to a stack slot, which the call pops before returning.
+        template <typename T>
+        static constexpr bool is_borrowed_result_v = is_borrowed_string_v<T> || std::is_base_of_v<unsafe_reference, T>;
+
+        template <typename R>
+        struct has_borrowed_result : std::bool_constant<is_borrowed_result_v<R>>
+        {
+        };
+
+        template <typename... T>
+        struct has_borrowed_result<std::tuple<T...>> : std::bool_constant<(is_borrowed_result_v<T> || ...)>
+        {
+        };
+
+        template <typename R, std::size_t... I>
+        R get_results(lua_State *L, int first, std::index_sequence<I...>)
+        {
+            // Braced initialization reads the results from left to right.
+            return R{stack::get<std::tuple_element_t<I, R>>(L, first + static_cast<int>(I))...};
+        }
+
+        /**
+         * @brief Calls the function that is at the top of the Lua stack, asking for exactly the results that R needs. The results are
+         * decoded in place and popped together with the function. The value at the top is popped also when an exception is thrown.
+         *
+         * @tparam R The type of the result: void, a single value, or a std::tuple of values. Missing results are nil.
+         * @throw type_error If the value at the top of the stack is not a function, or a result is not of the expected type.
+         * @throw budget_exceeded If the function is aborted by an execution_budget.
+         * @throw runtime_error If the function call fails.
+         */
+        template <typename R, typename... Args>
+        R call_typed(lua_State *L, Args &&...args)
+        {
+            static_assert(!has_borrowed_result<R>::value,
+                          "use std::string and safe references for results, the results are popped before returning");
+
+            constexpr int results = result_count<R>::value;
+            const int first = lua_gettop(L);
+            const stack_guard guard(L, first - 1);
+
+            if (!stack::check_type(L, -1, LUA_TFUNCTION))
+                throw type_error(-1, lua_type(L, -1), LUA_TFUNCTION);
+
+            if constexpr (sizeof...(Args) > 0)
+                stack::push(L, std::forward<Args>(args)...);
+
+            if (lua_pcall(L, static_cast<int>(sizeof...(Args)), results, 0) != LUA_OK)
+                throw_call_error(L);
+
+            if constexpr (std::is_void_v<R>)
+                return;
+            else if constexpr (is_specialization_of<R, std::tuple>::value)
+                return get_results<R>(L, first, std::make_index_sequence<results>());
+            else
+                return stack::get<R>(L, first);
+        }
+
+        template <typename R, std::size_t... I>
+        expected<R> try_get_results(lua_State *L, int first, std::index_sequence<I...>)
+        {
+            std::tuple<expected<std::tuple_element_t<I, R>>...> values{stack::try_get<std::tuple_element_t<I, R>>(L, first + static_cast<int>(I))...};
+
+            const error *failure = nullptr;
+            ((failure = (failure || std::get<I>(values)) ? failure : &std::get<I>(values).get_error()), ...);
+            if (failure)
+                return *failure;
+
+            return R{std::move(*std::get<I>(values))...};
+        }
+
+        /**
+         * @brief Like call_typed, but returns errors instead of throwing them: a value that is not a function, an error raised by the
+         * function, or a result of the wrong type. The message of a failed call is copied into the error.
+         */
+        template <typename R, typename... Args>
+        expected<R> try_call_typed(lua_State *L, Args &&...args)
+        {
+            static_assert(!has_borrowed_result<R>::value,
+                          "use std::string and safe references for results, the results are popped before returning");
+
+            constexpr int results = result_count<R>::value;
+            const int first = lua_gettop(L);
+            const stack_guard guard(L, first - 1);
+
+            if (!stack::check_type(L, -1, LUA_TFUNCTION))
+                return error::type_mismatch(-1, lua_type(L, -1), LUA_TFUNCTION);
+
+            if constexpr (sizeof...(Args) > 0)
+                stack::push(L, std::forward<Args>(args)...);
+
+            if (lua_pcall(L, static_cast<int>(sizeof...(Args)), results, 0) != LUA_OK)
+            {
+                const char *message = lua_tostring(L, -1);
+                return error::call_failed(message ? message : "error object is not a string", detail::is_budget_exceeded(L));
+            }
+
+            if constexpr (std::is_void_v<R>)
+                return expected<void>();
+            else if constexpr (is_specialization_of<R, std::tuple>::value)
+                return try_get_results<R>(L, first, std::make_index_sequence<results>());
+            else
+                return stack::try_get<R>(L, first);
+        }
+
         /**
          * @brief Calls the function that is at the top of the Lua stack.
          *
@@ -81,10 +220,11 @@ namespace easylua
          * @param args The arguments to pass to the function.
          * @return function_result The result of calling the function.
          * @throw type_error If the value at the top of the stack is not a function.
+         * @throw budget_exceeded If the function is aborted by an execution_budget.
          * @throw runtime_error If the function call fails.
          */
         template <typename... Args>
-        function_result call_function(lua_State *L, Args... args)
+        function_result call_function(lua_State *L, Args &&...args)
         {
             if (!stack::check_type(L, -1, LUA_TFUNCTION))
                 throw type_error(-1, lua_type(L, -1), LUA_TFUNCTION);
@@ -96,14 +236,10 @@ namespace easylua
 
             // push the arguments
             if constexpr (num_args > 0)
-                stack::push(L, args...);
+                stack::push(L, std::forward<Args>(args)...);
 
             if (lua_pcall(L, num_args, LUA_MULTRET, 0) != 0)
-            {
-                const char *error_message = lua_tostring(L, -1);
-                stack::pop(L, 1);
-                throw runtime_error(error_message);
-            }
+                throw_call_error(L);
 
             const int number_of_results = 1 + stack::get_top(L) - old_stack; // +1 because function was already on the stack
 
@@ -121,10 +257,42 @@ namespace easylua
         }
 
         template <typename... Args>
-        function_result operator()(Args... args)
+        function_result operator()(Args &&...args)
+        {
+            push();
+            return detail::call_function(lua_state_, std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Calls the function with a statically known result type. Unlike operator(), exactly the needed results are requested and
+         * decoded without a function_result in between.
+         *
+         * Usage:
+         *                      int sum = f.call<int>(1, 2);
+         *                      auto [x, y] = f.call<std::tuple<double, double>>(point);
+         */
+        template <typename R, typename... Args>
+        R call(Args &&...args)
         {
+            EASYLUA_STACK_CHECK(lua_state_);
             push();
-            return detail::call_function(lua_state_, args...);
+            return detail::call_typed<R>(lua_state_, std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Like call(), but returns an error instead of throwing when the function raises an error or a result has the wrong type.
+         *
+         * Usage:
+         *                      expected<double> score = f.try_call<double>(request);
+         *                      if (!score)
+         *                          log(score.get_error().message());
+         */
+        template <typename R, typename... Args>
+        expected<R> try_call(Args &&...args)
+        {
+            EASYLUA_STACK_CHECK(lua_state_);
+            push();
+            return detail::try_call_typed<R>(lua_state_, std::forward<Args>(args)...);
         }
     };
 
@@ -136,10 +304,42 @@ namespace easylua
         }
 
         template <typename... Args>
-        function_result operator()(Args... args)
+        function_result operator()(Args &&...args)
+        {
+            push();
+            return detail::call_function(lua_state_, std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Calls the function with a statically known result type. Unlike operator(), exactly the needed results are requested and
+         * decoded without a function_result in between.
+         *
+         * Usage:
+         *                      int sum = f.call<int>(1, 2);
+         *                      auto [x, y] = f.call<std::tuple<double, double>>(point);
+         */
+        template <typename R, typename... Args>
+        R call(Args &&...args)
+        {
+            EASYLUA_STACK_CHECK(lua_state_);
+            push();
+            return detail::call_typed<R>(lua_state_, std::forward<Args>(args)...);
+        }
+
+        /**
+         * @brief Like call(), but returns an error instead of throwing when the function raises an error or a result has the wrong type.
+         *
+         * Usage:
+         *                      expected<double> score = f.try_call<double>(request);
+         *                      if (!score)
+         *                          log(score.get_error().message());
+         */
+        template <typename R, typename... Args>
+        expected<R> try_call(Args &&...args)
         {
+            EASYLUA_STACK_CHECK(lua_state_);
             push();
-            return detail::call_function(lua_state_, args...);
+            return detail::try_call_typed<R>(lua_state_, std::forward<Args>(args)...);
         }
     };
 } // namespace easylua
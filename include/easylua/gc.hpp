@@ -0,0 +1,240 @@
+#ifndef __EASYLUA_GC_H
+#define __EASYLUA_GC_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+
+namespace easylua
+{
+    /// @brief The modes of the garbage collector of Lua 5.4.
+    enum class gc_mode
+    {
+        /// @brief Each cycle marks and sweeps the whole heap, interleaved with the program in steps.
+        incremental,
+        /// @brief Frequent minor collections only traverse young objects, with an occasional major collection.
+        generational
+    };
+
+    /**
+     * @brief Controls the garbage collector of a state. It only holds the state, so it is cheap to create and copy; see state_view::gc().
+     *
+     * Usage:
+     *                      lua.gc().set_incremental(200, 100);
+     *                      lua.gc().stop();
+     *                      ...
+     *                      lua.gc().step(64);
+     */
+    class gc_controller
+    {
+    public:
+        explicit gc_controller(lua_State *state) : lua_state_(state)
+        {
+            if (!lua_state_)
+                throw invalid_argument("state", "cannot be null");
+        }
+
+        /// @brief Stops the automatic collection. Explicit steps and collections still run.
+        void stop() { lua_gc(lua_state_, LUA_GCSTOP); }
+
+        /// @brief Restarts the automatic collection.
+        void restart() { lua_gc(lua_state_, LUA_GCRESTART); }
+
+        /// @brief Returns whether the automatic collection is running.
+        bool is_running() const { return lua_gc(lua_state_, LUA_GCISRUNNING) != 0; }
+
+        /// @brief Runs a full collection cycle.
+        void collect() { lua_gc(lua_state_, LUA_GCCOLLECT); }
+
+        /**
+         * @brief Runs a step of the collector.
+         *
+         * @param size_kb The work of the step, as if this many kilobytes had been allocated. 0 runs a single basic step.
+         * @return true If the step finished a collection cycle.
+         */
+        bool step(int size_kb = 0) { return lua_gc(lua_state_, LUA_GCSTEP, size_kb) != 0; }
+
+        /// @brief Returns the memory in use by the state, in bytes.
+        std::size_t get_memory() const
+        {
+            return static_cast<std::size_t>(lua_gc(lua_state_, LUA_GCCOUNT)) * 1024 + static_cast<std::size_t>(lua_gc(lua_state_, LUA_GCCOUNTB));
+        }
+
+        /**
+         * @brief Switches to the incremental mode and sets its parameters. A parameter of 0 keeps its current value.
+         *
+         * @param pause How long the collector waits before a new cycle, as a percentage of the memory in use after the previous cycle.
+         * 200 waits for the memory to double.
+         * @param step_multiplier How much work a step does relative to the memory allocated since the previous step, as a percentage.
+         * Larger values make the collector more aggressive and the steps longer.
+         * @param step_size The log2 of the number of bytes allocated between two steps.
+         * @return gc_mode The previous mode.
+         */
+        gc_mode set_incremental(int pause = 0, int step_multiplier = 0, int step_size = 0)
+        {
+            return to_mode(lua_gc(lua_state_, LUA_GCINC, pause, step_multiplier, step_size));
+        }
+
+        /**
+         * @brief Switches to the generational mode and sets its parameters. A parameter of 0 keeps its current value. Switching from the
+         * incremental mode runs a full collection.
+         *
+         * @param minor_multiplier How much the memory may grow between minor collections, as a percentage of the memory in use after the
+         * previous major collection.
+         * @param major_multiplier How much the memory may grow before a major collection, as a percentage.
+         * @return gc_mode The previous mode.
+         */
+        gc_mode set_generational(int minor_multiplier = 0, int major_multiplier = 0)
+        {
+            return to_mode(lua_gc(lua_state_, LUA_GCGEN, minor_multiplier, major_multiplier));
+        }
+
+        /**
+         * @brief Switches to the given mode, keeping the parameters of that mode.
+         *
+         * @return gc_mode The previous mode.
+         */
+        gc_mode set_mode(gc_mode mode) { return mode == gc_mode::generational ? set_generational() : set_incremental(); }
+
+    private:
+        static gc_mode to_mode(int mode) { return mode == LUA_GCGEN ? gc_mode::generational : gc_mode::incremental; }
+
+        lua_State *lua_state_;
+    };
+
+    /**
+     * @brief Runs the garbage collector of a state in the gaps of a loop, such as between frames or requests, so that collection work does
+     * not land in the middle of latency-sensitive code.
+     *
+     * The scheduler stops the automatic collection while it exists. Every call to run() performs collector steps until the time budget is
+     * spent or a cycle finishes, and records the time it took. If the budget is too small for the allocation rate of the scripts, memory
+     * grows; get_statistics() and gc_controller::get_memory() show whether the budget keeps up.
+     *
+     * In the generational mode, a step is a whole minor collection and Lua never reports it as the end of a cycle, so run() performs a
+     * single step and counts it as a cycle. The mode is read when the scheduler is created, so it must be set on the state beforehand.
+     *
+     * Usage:
+     *                      gc_scheduler scheduler(lua, std::chrono::microseconds(500));
+     *                      while (running)
+     *                      {
+     *                          update(lua);
+     *                          scheduler.run();
+     *                      }
+     */
+    class gc_scheduler
+    {
+    public:
+        /// @brief Time spent in the collector. The times are measured with std::chrono::steady_clock.
+        struct statistics
+        {
+            /// @brief The number of calls to run().
+            std::uint64_t runs = 0;
+            /// @brief The number of collector steps.
+            std::uint64_t steps = 0;
+            /// @brief The number of collection cycles that were finished.
+            std::uint64_t cycles = 0;
+            /// @brief The total time spent in run().
+            std::chrono::nanoseconds total_time{0};
+            /// @brief The time spent in the last call to run().
+            std::chrono::nanoseconds last_time{0};
+            /// @brief The longest time spent in a single call to run().
+            std::chrono::nanoseconds max_time{0};
+        };
+
+        /**
+         * @brief Construct a new gc_scheduler object and stop the automatic collection of the state.
+         *
+         * @param state The Lua state.
+         * @param budget The time that a call to run() may spend in the collector. A step that has started is always finished, so a call can
+         * exceed the budget by the duration of one step.
+         * @param step_size_kb The work of each step, as in gc_controller::step(). Smaller steps follow the budget more closely. It does not
+         * apply to the generational mode.
+         * @throw invalid_argument If state is null, budget is negative or step_size_kb is negative.
+         */
+        gc_scheduler(lua_State *state, std::chrono::nanoseconds budget, int step_size_kb = 0)
+            : gc_(state), budget_(budget), step_size_kb_(step_size_kb), was_running_(gc_.is_running()), generational_(false)
+        {
+            if (budget_.count() < 0)
+                throw invalid_argument("budget", "cannot be negative");
+
+            if (step_size_kb_ < 0)
+                throw invalid_argument("step_size_kb", "cannot be negative");
+
+            // Lua has no query for the mode, but switching to the incremental mode returns it. Switching a generational state back runs
+            // a full collection, once.
+            generational_ = gc_.set_incremental() == gc_mode::generational;
+            if (generational_)
+                gc_.set_generational();
+
+            gc_.stop();
+        }
+
+        /// @brief Restarts the automatic collection if it was running when the scheduler was created.
+        ~gc_scheduler()
+        {
+            if (was_running_)
+                gc_.restart();
+        }
+
+        gc_scheduler(const gc_scheduler &other) = delete;
+        gc_scheduler &operator=(const gc_scheduler &other) = delete;
+
+        /**
+         * @brief Runs collector steps until the budget is spent or a cycle finishes. In the generational mode, runs one minor collection.
+         *
+         * @return true If a collection cycle finished, which is always the case in the generational mode.
+         */
+        bool run()
+        {
+            const auto start = std::chrono::steady_clock::now();
+            const auto deadline = start + budget_;
+            bool finished = false;
+            auto now = start;
+            do
+            {
+                finished = gc_.step(step_size_kb_) || generational_;
+                statistics_.steps++;
+                now = std::chrono::steady_clock::now();
+            } while (!finished && now < deadline);
+
+            const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(now - start);
+            statistics_.runs++;
+            statistics_.cycles += finished ? 1 : 0;
+            statistics_.total_time += elapsed;
+            statistics_.last_time = elapsed;
+            if (elapsed > statistics_.max_time)
+                statistics_.max_time = elapsed;
+
+            return finished;
+        }
+
+        /// @brief Sets the time that a call to run() may spend in the collector.
+        void set_budget(std::chrono::nanoseconds budget)
+        {
+            if (budget.count() < 0)
+                throw invalid_argument("budget", "cannot be negative");
+
+            budget_ = budget;
+        }
+
+        std::chrono::nanoseconds get_budget() const { return budget_; }
+
+        const statistics &get_statistics() const { return statistics_; }
+
+        void reset_statistics() { statistics_ = statistics(); }
+
+    private:
+        gc_controller gc_;
+        std::chrono::nanoseconds budget_;
+        int step_size_kb_;
+        bool was_running_;
+        bool generational_;
+        statistics statistics_;
+    };
+} // namespace easylua
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef __EASYLUA_GLOBAL_H
+#define __EASYLUA_GLOBAL_H
+
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+#include "stack.hpp"
+
+namespace easylua
+{
+    /**
+     * @brief A handle to a global variable that is bound once and can then be read and written without allocating.
+     *
+     * state["name"] copies the name into a std::string and lua_getglobal hashes it again on every access. A global creates the Lua string
+     * for the name once and keeps it in the registry, so an access is two registry lookups and a table lookup with a precomputed hash. The
+     * value itself is not cached, so a global always reflects the current contents of the global table.
+     *
+     * A global must not outlive the Lua state it was created for.
+     */
+    class global
+    {
+    public:
+        /**
+         * @brief Construct a new global object
+         *
+         * @param state The Lua state.
+         * @param name The name of the global variable.
+         * @throw invalid_argument If state is null.
+         */
+        global(lua_State *state, std::string_view name) : lua_state_(state)
+        {
+            if (!lua_state_)
+                throw invalid_argument("state", "cannot be null");
+
+            lua_pushlstring(lua_state_, name.data(), name.size());
+            name_ = luaL_ref(lua_state_, LUA_REGISTRYINDEX);
+        }
+
+        ~global()
+        {
+            if (lua_state_ && name_ != LUA_NOREF)
+                luaL_unref(lua_state_, LUA_REGISTRYINDEX, name_);
+        }
+
+        global(const global &other) = delete;
+        global &operator=(const global &other) = delete;
+
+        global(global &&other) : lua_state_(other.lua_state_), name_(other.name_)
+        {
+            other.name_ = LUA_NOREF;
+        }
+
+        global &operator=(global &&other)
+        {
+            std::swap(lua_state_, other.lua_state_);
+            std::swap(name_, other.name_);
+            return *this;
+        }
+
+        /// @brief Pushes the value of the global onto the stack.
+        void push() const
+        {
+            lua_rawgeti(lua_state_, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+            lua_rawgeti(lua_state_, LUA_REGISTRYINDEX, name_);
+            lua_gettable(lua_state_, -2);
+            lua_remove(lua_state_, -2);
+        }
+
+        /**
+         * @brief Reads the value of the global. The stack is left unchanged, so a std::string_view or const char * result stays valid only
+         * while the global keeps referring to the same string.
+         *
+         * @tparam T The type of the value.
+         * @throw type_error If the value is not of type T.
+         */
+        template <typename T>
+        T get() const
+        {
+            const stack_guard guard(lua_state_);
+
+            push();
+            return stack::get<T>(lua_state_, -1);
+        }
+
+        /**
+         * @brief Assigns a value to the global.
+         *
+         * @param location Where a stack leak is reported, the caller by default.
+         */
+        template <typename T>
+        void set(T &&value, source_location location = source_location::current()) const
+        {
+            EASYLUA_STACK_CHECK_AT(lua_state_, 0, location);
+            lua_rawgeti(lua_state_, LUA_REGISTRYINDEX, LUA_RIDX_GLOBALS);
+            lua_rawgeti(lua_state_, LUA_REGISTRYINDEX, name_);
+            stack::push(lua_state_, std::forward<T>(value));
+            lua_settable(lua_state_, -3);
+            lua_pop(lua_state_, 1);
+        }
+
+        template <typename T>
+        operator T() const
+        {
+            return get<T>();
+        }
+
+        template <typename T, typename std::enable_if_t<!std::is_same_v<std::decay_t<T>, global>, bool> = true>
+        global &operator=(T &&value)
+        {
+            set(std::forward<T>(value));
+            return *this;
+        }
+
+    private:
+        lua_State *lua_state_;
+        int name_;
+    };
+} // namespace easylua
+
+#endif
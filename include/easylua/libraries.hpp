@@ -0,0 +1,263 @@
+#ifndef __EASYLUA_LIBRARIES_H
+#define __EASYLUA_LIBRARIES_H
+
+#include <iterator>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+
+namespace easylua
+{
+    /// @brief The standard libraries of Lua, as flags that can be combined with |.
+    enum class library : unsigned
+    {
+        none = 0,
+        base = 1u << 0,
+        package = 1u << 1,
+        coroutine = 1u << 2,
+        table = 1u << 3,
+        io = 1u << 4,
+        os = 1u << 5,
+        string = 1u << 6,
+        math = 1u << 7,
+        utf8 = 1u << 8,
+        debug = 1u << 9,
+        all = (1u << 10) - 1
+    };
+
+    constexpr library operator|(library a, library b) { return static_cast<library>(static_cast<unsigned>(a) | static_cast<unsigned>(b)); }
+    constexpr library operator&(library a, library b) { return static_cast<library>(static_cast<unsigned>(a) & static_cast<unsigned>(b)); }
+    constexpr library operator~(library a) { return static_cast<library>(~static_cast<unsigned>(a) & static_cast<unsigned>(library::all)); }
+
+    /// @brief How libraries are opened.
+    enum class library_mode
+    {
+        /// @brief Every library is built immediately, like luaL_openlibs does.
+        eager,
+        /// @brief A library is built the first time a script uses its global, calls a string method, or requires it. The base and package
+        /// libraries are always opened eagerly.
+        lazy
+    };
+
+    namespace detail
+    {
+        struct library_entry
+        {
+            library flag;
+            const char *name;
+            lua_CFunction open;
+        };
+
+        inline constexpr library_entry library_entries[] = {
+            {library::base, LUA_GNAME, luaopen_base},
+            {library::package, LUA_LOADLIBNAME, luaopen_package},
+            {library::coroutine, LUA_COLIBNAME, luaopen_coroutine},
+            {library::table, LUA_TABLIBNAME, luaopen_table},
+            {library::io, LUA_IOLIBNAME, luaopen_io},
+            {library::os, LUA_OSLIBNAME, luaopen_os},
+            {library::string, LUA_STRLIBNAME, luaopen_string},
+            {library::math, LUA_MATHLIBNAME, luaopen_math},
+            {library::utf8, LUA_UTF8LIBNAME, luaopen_utf8},
+            {library::debug, LUA_DBLIBNAME, luaopen_debug},
+        };
+
+        /// @brief Opens the library with the given name if it is still pending, and pushes it. Pushes nil otherwise. Upvalue 1 is the
+        /// table of pending libraries, from name to open function.
+        inline void open_pending_library(lua_State *L, int name)
+        {
+            lua_pushvalue(L, name);
+            if (lua_rawget(L, lua_upvalueindex(1)) != LUA_TFUNCTION)
+                return;
+
+            const lua_CFunction open = lua_tocfunction(L, -1);
+            lua_pop(L, 1);
+
+            lua_pushvalue(L, name);
+            lua_pushnil(L);
+            lua_rawset(L, lua_upvalueindex(1));
+
+            luaL_requiref(L, lua_tostring(L, name), open, 1);
+        }
+
+        /// @brief __index of the global table while libraries are pending. Upvalues: pending libraries.
+        inline int lazy_global(lua_State *L)
+        {
+            if (lua_type(L, 2) != LUA_TSTRING)
+                return 0;
+
+            open_pending_library(L, 2);
+
+            // Once every library is open, missing globals no longer go through this function.
+            lua_pushnil(L);
+            if (lua_next(L, lua_upvalueindex(1)) == 0)
+            {
+                lua_pushnil(L);
+                lua_setmetatable(L, 1);
+            }
+            else
+                lua_pop(L, 2);
+
+            return 1;
+        }
+
+        /// @brief __index of strings while the string library is pending: opens it, which replaces the metatable of strings, and looks up
+        /// the method. Upvalues: pending libraries.
+        inline int lazy_string_method(lua_State *L)
+        {
+            lua_pushliteral(L, LUA_STRLIBNAME);
+            open_pending_library(L, lua_gettop(L));
+            if (!lua_istable(L, -1))
+                return luaL_error(L, "string library is not available");
+
+            lua_pushvalue(L, 2);
+            lua_gettable(L, -2);
+            return 1;
+        }
+
+        /// @brief The arithmetic metamethods of strings, which convert numeric strings: '10' + 1 is 11.
+        inline constexpr const char *string_arithmetic_events[] = {"__add", "__sub", "__mul", "__mod", "__pow", "__div", "__idiv", "__unm"};
+
+        /// @brief Arithmetic metamethod of strings while the string library is pending: opens it, which replaces the metatable of strings,
+        /// and calls the metamethod of the library. Upvalues: pending libraries, event name.
+        inline int lazy_string_arithmetic(lua_State *L)
+        {
+            const int arguments = lua_gettop(L);
+            lua_pushliteral(L, LUA_STRLIBNAME);
+            open_pending_library(L, arguments + 1);
+            lua_settop(L, arguments);
+
+            lua_pushliteral(L, "");
+            if (!lua_getmetatable(L, -1))
+                return luaL_error(L, "attempt to perform arithmetic on a string value");
+
+            lua_pushvalue(L, lua_upvalueindex(2));
+            if (lua_rawget(L, -2) != LUA_TFUNCTION)
+                return luaL_error(L, "attempt to perform arithmetic on a string value");
+
+            lua_replace(L, arguments + 1);
+            lua_pop(L, 1);
+            lua_insert(L, 1);
+            lua_call(L, arguments, 1);
+            return 1;
+        }
+
+        /// @brief package.preload loader of a pending library. Upvalues: pending libraries, name.
+        inline int lazy_require(lua_State *L)
+        {
+            lua_pushvalue(L, lua_upvalueindex(2));
+            open_pending_library(L, lua_gettop(L));
+            return 1;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Opens the selected standard libraries.
+     *
+     * In lazy mode the libraries other than base and package are registered as stubs: an __index metamethod on the global table, a
+     * metatable for strings, and package.preload entries. The stubs build a library the first time it is used, so a state only pays for
+     * what its scripts touch. If the global table already has a metatable, the libraries are opened eagerly instead.
+     *
+     * Pending libraries are only found through the metatable of the global table. rawget(_G, name), pairs(_G) and next(_G) do not see
+     * them until they have been built, and a script that replaces the metatable of _G with setmetatable loses the libraries that are
+     * still pending. Open the libraries eagerly for such scripts.
+     *
+     * @param L The Lua state.
+     * @param libraries The libraries to open.
+     * @param mode Whether to open them now or on first use.
+     * @throw invalid_argument If L is null.
+     */
+    inline void open_libraries(lua_State *L, library libraries, library_mode mode = library_mode::eager)
+    {
+        if (!L)
+            throw invalid_argument("L", "cannot be null");
+
+        const library always_eager = library::base | library::package;
+        lua_pushglobaltable(L);
+        const bool has_metatable = lua_getmetatable(L, -1);
+        lua_pop(L, has_metatable ? 2 : 1);
+        const bool lazy = mode == library_mode::lazy && (libraries & ~always_eager) != library::none && !has_metatable;
+
+        if (!lazy)
+        {
+            for (const detail::library_entry &entry : detail::library_entries)
+            {
+                if ((libraries & entry.flag) != library::none)
+                {
+                    luaL_requiref(L, entry.name, entry.open, 1);
+                    lua_pop(L, 1);
+                }
+            }
+
+            return;
+        }
+
+        for (const detail::library_entry &entry : detail::library_entries)
+        {
+            if ((libraries & entry.flag & always_eager) != library::none)
+            {
+                luaL_requiref(L, entry.name, entry.open, 1);
+                lua_pop(L, 1);
+            }
+        }
+
+        lua_newtable(L); // pending
+        const int pending = lua_gettop(L);
+        for (const detail::library_entry &entry : detail::library_entries)
+        {
+            if ((libraries & entry.flag & ~always_eager) != library::none)
+            {
+                lua_pushcfunction(L, entry.open);
+                lua_setfield(L, pending, entry.name);
+            }
+        }
+
+        lua_pushglobaltable(L);
+        lua_createtable(L, 0, 1);
+        lua_pushvalue(L, pending);
+        lua_pushcclosure(L, &detail::lazy_global, 1);
+        lua_setfield(L, -2, "__index");
+        lua_setmetatable(L, -2);
+        lua_pop(L, 1);
+
+        if ((libraries & library::string) != library::none)
+        {
+            lua_pushliteral(L, "");
+            lua_createtable(L, 0, 1 + static_cast<int>(std::size(detail::string_arithmetic_events)));
+            lua_pushvalue(L, pending);
+            lua_pushcclosure(L, &detail::lazy_string_method, 1);
+            lua_setfield(L, -2, "__index");
+            for (const char *event : detail::string_arithmetic_events)
+            {
+                lua_pushvalue(L, pending);
+                lua_pushstring(L, event);
+                lua_pushcclosure(L, &detail::lazy_string_arithmetic, 2);
+                lua_setfield(L, -2, event);
+            }
+
+            lua_setmetatable(L, -2);
+            lua_pop(L, 1);
+        }
+
+        if ((libraries & library::package) != library::none)
+        {
+            lua_getfield(L, LUA_REGISTRYINDEX, LUA_PRELOAD_TABLE);
+            for (const detail::library_entry &entry : detail::library_entries)
+            {
+                if ((libraries & entry.flag & ~always_eager) != library::none)
+                {
+                    lua_pushvalue(L, pending);
+                    lua_pushstring(L, entry.name);
+                    lua_pushcclosure(L, &detail::lazy_require, 2);
+                    lua_setfield(L, -2, entry.name);
+                }
+            }
+
+            lua_pop(L, 1);
+        }
+
+        lua_pop(L, 1);
+    }
+} // namespace easylua
+
+#endif
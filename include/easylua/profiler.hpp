@@ -0,0 +1,318 @@
+#ifndef __EASYLUA_PROFILER_H
+#define __EASYLUA_PROFILER_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <lua.hpp>
+
+#include "budget.hpp"
+#include "exception.hpp"
+
+namespace easylua
+{
+    /**
+     * @brief A sampling profiler for the Lua code that runs on a state.
+     *
+     * While the profiler runs, a count hook takes a sample every period VM instructions: it walks the Lua call stack and records every
+     * frame as source:line. Samples are aggregated in memory; after the first time a stack is seen, recording it again does not allocate.
+     * The results can be written in the folded-stack format of flamegraph.pl, or as a report of the locations with the most self samples.
+     *
+     * start() and stop() only set the hook, so the profiler can be switched on and off while the program runs; when it is stopped it costs
+     * nothing. While it runs, Lua 5.4 makes every instruction slower because a count hook is set, whatever the period, so a longer
+     * period reduces the cost of sampling but not this overhead.
+     *
+     * Only one profiler can run on a state at a time. It samples the main thread of the state only. A thread has a single hook, so the
+     * profiler does not start while a budget_scope enforces a budget, and a budget_scope created while the profiler runs pauses sampling
+     * until the scope ends. Any other hook is replaced while the profiler runs.
+     *
+     * Usage:
+     *                      profiler profiler(lua, 1000);
+     *                      profiler.start();
+     *                      lua.run(script);
+     *                      profiler.stop();
+     *                      profiler.write_folded(std::cout);
+     */
+    class profiler
+    {
+    public:
+        /// @brief Samples of one location.
+        struct entry
+        {
+            /// @brief The location, as source:line.
+            std::string location;
+            /// @brief The number of samples in which the location was at the top of the stack.
+            std::uint64_t self_samples;
+            /// @brief The number of samples in which the location was anywhere on the stack.
+            std::uint64_t total_samples;
+        };
+
+        /**
+         * @brief Construct a new profiler object. The profiler is not started.
+         *
+         * @param state The Lua state.
+         * @param period The number of VM instructions between two samples.
+         * @param max_depth The maximum number of frames recorded per sample. Deeper stacks are cut off at the root.
+         * @throw invalid_argument If state is null, or period or max_depth is not positive.
+         */
+        profiler(lua_State *state, int period = 1000, int max_depth = 64) : lua_state_(state), period_(period), max_depth_(max_depth)
+        {
+            if (!lua_state_)
+                throw invalid_argument("state", "cannot be null");
+
+            if (period_ <= 0)
+                throw invalid_argument("period", "must be positive");
+
+            if (max_depth_ <= 0)
+                throw invalid_argument("max_depth", "must be positive");
+        }
+
+        ~profiler() { stop(); }
+
+        profiler(const profiler &other) = delete;
+        profiler &operator=(const profiler &other) = delete;
+
+        /**
+         * @brief Starts sampling. Does nothing if the profiler is already running.
+         *
+         * @throw invalid_operation If another profiler is running on the state, or a budget_scope enforces a budget on it.
+         */
+        void start()
+        {
+            if (running_)
+                return;
+
+            if (lua_gethook(lua_state_) == &detail::budget_hook)
+                throw invalid_operation("cannot profile while an execution budget is enforced");
+
+            lua_rawgetp(lua_state_, LUA_REGISTRYINDEX, key());
+            const bool taken = !lua_isnil(lua_state_, -1);
+            lua_pop(lua_state_, 1);
+            if (taken)
+                throw invalid_operation("another profiler is running on this state");
+
+            lua_pushlightuserdata(lua_state_, this);
+            lua_rawsetp(lua_state_, LUA_REGISTRYINDEX, key());
+
+            previous_hook_ = lua_gethook(lua_state_);
+            previous_mask_ = lua_gethookmask(lua_state_);
+            previous_count_ = lua_gethookcount(lua_state_);
+            lua_sethook(lua_state_, &hook, LUA_MASKCOUNT, period_);
+            running_ = true;
+        }
+
+        /**
+         * @brief Stops sampling and restores the hook that was set before start(). The samples are kept. If another hook, such as the one of
+         * a budget_scope, has replaced the hook of the profiler, it is left in place; the hook of the profiler then removes itself the next
+         * time it runs.
+         */
+        void stop()
+        {
+            if (!running_)
+                return;
+
+            if (lua_gethook(lua_state_) == &hook)
+                lua_sethook(lua_state_, previous_hook_, previous_mask_, previous_count_);
+
+            lua_pushnil(lua_state_);
+            lua_rawsetp(lua_state_, LUA_REGISTRYINDEX, key());
+            running_ = false;
+        }
+
+        bool is_running() const { return running_; }
+
+        /// @brief Discards all samples.
+        void reset()
+        {
+            stacks_.clear();
+            locations_.clear();
+            location_ids_.clear();
+            self_samples_.clear();
+            samples_ = 0;
+        }
+
+        /// @brief Returns the number of samples taken.
+        std::uint64_t get_sample_count() const { return samples_; }
+
+        /**
+         * @brief Writes the samples in the folded-stack format that flamegraph.pl reads: one line per distinct stack, with the frames from
+         * the root to the leaf separated by semicolons, followed by the number of samples.
+         */
+        void write_folded(std::ostream &out) const
+        {
+            for (const auto &[stack, count] : stacks_)
+            {
+                for (std::size_t i = 0; i < stack.size(); i++)
+                {
+                    if (i > 0)
+                        out << ';';
+
+                    out << locations_[stack[i]];
+                }
+
+                out << ' ' << count << '\n';
+            }
+        }
+
+        /**
+         * @brief Returns the locations with the most self samples, in descending order.
+         *
+         * @param count The maximum number of locations to return.
+         */
+        std::vector<entry> get_top(std::size_t count) const
+        {
+            std::vector<std::uint64_t> total(locations_.size(), 0);
+            std::vector<std::uint32_t> seen(locations_.size(), 0);
+            std::uint32_t stack_number = 0;
+            for (const auto &[stack, samples] : stacks_)
+            {
+                // A recursive location is counted once per stack.
+                stack_number++;
+                for (const std::uint32_t location : stack)
+                {
+                    if (seen[location] != stack_number)
+                    {
+                        seen[location] = stack_number;
+                        total[location] += samples;
+                    }
+                }
+            }
+
+            std::vector<entry> entries;
+            entries.reserve(locations_.size());
+            for (std::size_t i = 0; i < locations_.size(); i++)
+                entries.push_back(entry{locations_[i], self_samples_[i], total[i]});
+
+            std::sort(entries.begin(), entries.end(), [](const entry &a, const entry &b)
+                      { return a.self_samples != b.self_samples ? a.self_samples > b.self_samples : a.location < b.location; });
+
+            if (entries.size() > count)
+                entries.resize(count);
+
+            return entries;
+        }
+
+        /// @brief Writes a table of the locations with the most self samples.
+        void write_report(std::ostream &out, std::size_t count = 20) const
+        {
+            out << "self%\tself\ttotal\tlocation\n";
+            for (const entry &entry : get_top(count))
+            {
+                const double percentage = samples_ > 0 ? 100.0 * static_cast<double>(entry.self_samples) / static_cast<double>(samples_) : 0.0;
+                out << static_cast<int>(percentage * 10) / 10.0 << '\t' << entry.self_samples << '\t' << entry.total_samples << '\t' << entry.location << '\n';
+            }
+        }
+
+    private:
+        struct stack_hash
+        {
+            std::size_t operator()(const std::vector<std::uint32_t> &stack) const
+            {
+                std::size_t hash = stack.size();
+                for (const std::uint32_t location : stack)
+                    hash ^= std::hash<std::uint32_t>()(location) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+
+                return hash;
+            }
+        };
+
+        static const void *key()
+        {
+            static const char key = 0;
+            return &key;
+        }
+
+        static void hook(lua_State *L, lua_Debug *)
+        {
+            lua_rawgetp(L, LUA_REGISTRYINDEX, key());
+            auto *self = static_cast<profiler *>(lua_touserdata(L, -1));
+            lua_pop(L, 1);
+
+            if (self)
+                self->sample(L);
+            else
+                lua_sethook(L, nullptr, 0, 0);
+        }
+
+        /// @brief Records the current call stack. Must not throw, because it is called from Lua.
+        void sample(lua_State *L) noexcept
+        {
+            try
+            {
+                stack_buffer_.clear();
+                lua_Debug debug;
+                for (int level = 0; level < max_depth_ && lua_getstack(L, level, &debug); level++)
+                {
+                    lua_getinfo(L, "Sl", &debug);
+                    stack_buffer_.push_back(intern(debug));
+                }
+
+                if (stack_buffer_.empty())
+                    return;
+
+                std::reverse(stack_buffer_.begin(), stack_buffer_.end());
+                const auto it = stacks_.find(stack_buffer_);
+                if (it != stacks_.end())
+                    it->second++;
+                else
+                    stacks_.emplace(stack_buffer_, 1);
+
+                self_samples_[stack_buffer_.back()]++;
+                samples_++;
+            }
+            catch (...)
+            {
+                // Dropping a sample is better than aborting the script.
+            }
+        }
+
+        std::uint32_t intern(const lua_Debug &debug)
+        {
+            location_buffer_.assign(debug.short_src);
+            if (debug.currentline > 0)
+            {
+                location_buffer_ += ':';
+                location_buffer_ += std::to_string(debug.currentline);
+            }
+
+            // Semicolons separate frames in the folded format.
+            std::replace(location_buffer_.begin(), location_buffer_.end(), ';', ',');
+
+            const auto it = location_ids_.find(location_buffer_);
+            if (it != location_ids_.end())
+                return it->second;
+
+            const auto id = static_cast<std::uint32_t>(locations_.size());
+            locations_.push_back(location_buffer_);
+            self_samples_.push_back(0);
+            location_ids_.emplace(location_buffer_, id);
+            return id;
+        }
+
+        lua_State *lua_state_;
+        int period_;
+        int max_depth_;
+        bool running_ = false;
+
+        lua_Hook previous_hook_ = nullptr;
+        int previous_mask_ = 0;
+        int previous_count_ = 0;
+
+        std::unordered_map<std::vector<std::uint32_t>, std::uint64_t, stack_hash> stacks_;
+        std::vector<std::string> locations_;
+        std::unordered_map<std::string, std::uint32_t> location_ids_;
+        std::vector<std::uint64_t> self_samples_;
+        std::uint64_t samples_ = 0;
+
+        std::vector<std::uint32_t> stack_buffer_;
+        std::string location_buffer_;
+    };
+} // namespace easylua
+
+#endif
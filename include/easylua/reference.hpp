@@ -1,6 +1,8 @@
 #ifndef __EASYLUA_REFERENCE_H
 #define __EASYLUA_REFERENCE_H
 
+#include <cstddef>
+
 #include <lua.hpp>
 
 #include "exception.hpp"
@@ -40,13 +42,23 @@ namespace easylua
         }
 
     protected:
-        unsafe_reference(lua_State *state, int index, int expected_type) : reference(state, index, expected_type), index_(index)
+        /// @brief The index is converted to an absolute one, so the reference stays valid when values are pushed above it.
+        unsafe_reference(lua_State *state, int index, int expected_type)
+            : reference(state, index, expected_type), index_(lua_absindex(state, index))
         {
         }
 
         int index_;
     };
 
+    /**
+     * @brief Holds a value through a slot in the registry, so that the value stays alive and reachable from anywhere.
+     *
+     * A copy shares the registry slot of the original instead of taking a new one; the slot is released when the last copy is destroyed
+     * or reset. The shared count is only allocated the first time a reference is copied, so references that are never copied cost nothing
+     * extra. Copies must be used from the thread that uses the state, like the state itself. Released slots are recycled by luaL_ref, so
+     * dropping and recreating references does not make the registry grow.
+     */
     class safe_reference : public reference
     {
     public:
@@ -58,70 +70,113 @@ namespace easylua
             lua_rawgeti(lua_state_, LUA_REGISTRYINDEX, reference_);
         }
 
+        /// @brief Returns whether the reference holds a value.
+        bool is_valid() const { return reference_ != LUA_NOREF; }
+
+        /// @brief Drops the value. The registry slot is released if no copy of the reference is left.
+        void reset()
+        {
+            if (reference_ != LUA_NOREF && (!count_ || --*count_ == 0))
+            {
+                luaL_unref(lua_state_, LUA_REGISTRYINDEX, reference_);
+                delete count_;
+            }
+
+            reference_ = LUA_NOREF;
+            count_ = nullptr;
+        }
+
     protected:
+        /**
+         * @brief Construct a new safe_reference object. The value is removed from the stack, wherever it is; the values above it move down.
+         * A value at a pseudo-index, such as an upvalue, is not on the stack and stays where it is.
+         */
         safe_reference(lua_State *state, int index, int expected_type) : reference(state, index, expected_type), reference_(LUA_NOREF)
         {
+            // luaL_ref always takes the value at the top.
+            if (index <= LUA_REGISTRYINDEX)
+                lua_pushvalue(lua_state_, index);
+            else
+                lua_rotate(lua_state_, index, -1);
+
             reference_ = luaL_ref(lua_state_, LUA_REGISTRYINDEX);
         }
 
-        // safe_reference(const safe_reference &other) : reference(other), reference_(LUA_NOREF)
-        // {
-        //     if (other.reference_ != LUA_NOREF)
-        //     {
-        //         lua_rawgeti(lua_state_, LUA_REGISTRYINDEX, other.reference_);
-        //         reference_ = luaL_ref(lua_state_, LUA_REGISTRYINDEX);
-        //     }
-        // }
-
-        // safe_reference(safe_reference &&other) : reference(other), reference_(other.reference_)
-        // {
-        //     other.reference_ = LUA_NOREF;
-        // }
-
-        // safe_reference &operator=(const safe_reference &other)
-        // {
-        //     if (this != &other)
-        //     {
-        //         if (reference_ != LUA_NOREF)
-        //             luaL_unref(lua_state_, LUA_REGISTRYINDEX, reference_);
-
-        //         lua_state_ = other.lua_state_;
-        //         reference_ = LUA_NOREF;
-
-        //         if (other.reference_ != LUA_NOREF)
-        //         {
-        //             lua_rawgeti(lua_state_, LUA_REGISTRYINDEX, other.reference_);
-        //             reference_ = luaL_ref(lua_state_, LUA_REGISTRYINDEX);
-        //         }
-        //     }
-
-        //     return *this;
-        // }
-
-        // safe_reference &operator=(safe_reference &&other)
-        // {
-        //     if (this != &other)
-        //     {
-        //         if (reference_ != LUA_NOREF)
-        //             luaL_unref(lua_state_, LUA_REGISTRYINDEX, reference_);
-
-        //         lua_state_ = other.lua_state_;
-        //         reference_ = other.reference_;
-
-        //         other.reference_ = LUA_NOREF;
-        //     }
-
-        //     return *this;
-        // }
+        safe_reference(const safe_reference &other) : reference(other), reference_(other.reference_), count_(other.share())
+        {
+        }
+
+        safe_reference(safe_reference &&other) : reference(other), reference_(other.reference_), count_(other.count_)
+        {
+            other.reference_ = LUA_NOREF;
+            other.count_ = nullptr;
+        }
+
+        safe_reference &operator=(const safe_reference &other)
+        {
+            if (this != &other)
+            {
+                std::size_t *count = other.share();
+                reset();
+                lua_state_ = other.lua_state_;
+                reference_ = other.reference_;
+                count_ = count;
+            }
+
+            return *this;
+        }
+
+        safe_reference &operator=(safe_reference &&other)
+        {
+            if (this != &other)
+            {
+                reset();
+                lua_state_ = other.lua_state_;
+                reference_ = other.reference_;
+                count_ = other.count_;
+                other.reference_ = LUA_NOREF;
+                other.count_ = nullptr;
+            }
+
+            return *this;
+        }
 
         ~safe_reference()
         {
-            if (reference_ != LUA_NOREF)
-                luaL_unref(lua_state_, LUA_REGISTRYINDEX, reference_);
+            reset();
         }
 
         int reference_;
+
+    private:
+        /// @brief Adds an owner to the slot and returns the shared count, creating it if the slot had a single owner so far.
+        std::size_t *share() const
+        {
+            if (reference_ == LUA_NOREF)
+                return nullptr;
+
+            if (!count_)
+                count_ = new std::size_t(1);
+
+            ++*count_;
+            return count_;
+        }
+
+        mutable std::size_t *count_ = nullptr;
     };
+
+    /**
+     * @brief Resets a range of safe references, such as a cache of callbacks that is being cleared.
+     *
+     * @param first The first reference.
+     * @param last The end of the range.
+     */
+    template <typename Iterator>
+    void reset_references(Iterator first, Iterator last)
+    {
+        for (; first != last; ++first)
+            first->reset();
+    }
 } // namespace easylua
 
 #endif
\ No newline at end of file
@@ -1,10 +1,32 @@
 #ifndef __EASYLUA_SCRIPT_H
 #define __EASYLUA_SCRIPT_H
 
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
 #include <string>
+#include <string_view>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+
+#ifdef __cpp_lib_span
+#include <span>
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define EASYLUA_HAS_MMAP 1
+#endif
 
 #include <lua.hpp>
 
+#include "budget.hpp"
 #include "exception.hpp"
 
 namespace easylua
@@ -21,15 +43,16 @@ namespace easylua
                 runtime_error,
                 memory_error,
                 file_error,
-                error
+                error,
+                budget_exceeded
             };
 
             load_result(result result, std::string error_message = "") : result_(result), error_message_(error_message)
             {
             }
 
-            result get_result() { return result_; }
-            const std::string &get_error_message() { return error_message_; }
+            result get_result() const { return result_; }
+            const std::string &get_error_message() const { return error_message_; }
 
             operator bool() const { return result_ == result::ok; }
 
@@ -38,8 +61,116 @@ namespace easylua
             std::string error_message_;
         };
 
+        /// @brief The kinds of chunks that a load accepts.
+        enum class load_mode
+        {
+            any,
+            text,
+            binary
+        };
+
         namespace internal
         {
+            inline const char *to_string(load_mode mode)
+            {
+                switch (mode)
+                {
+                case load_mode::text:
+                    return "t";
+                case load_mode::binary:
+                    return "b";
+                default:
+                    return "bt";
+                }
+            }
+
+            inline int write_to_string(lua_State *, const void *data, std::size_t size, void *user_data)
+            {
+                try
+                {
+                    static_cast<std::string *>(user_data)->append(static_cast<const char *>(data), size);
+                    return 0;
+                }
+                catch (...)
+                {
+                    return 1;
+                }
+            }
+
+            /// @brief lua_Reader that hands the whole buffer to Lua in a single chunk.
+            inline const char *read_single_chunk(lua_State *, void *user_data, std::size_t *size)
+            {
+                std::string_view &remaining = *static_cast<std::string_view *>(user_data);
+                *size = remaining.size();
+                const char *data = remaining.empty() ? nullptr : remaining.data();
+                remaining = std::string_view();
+                return data;
+            }
+
+#ifdef EASYLUA_HAS_MMAP
+            /// @brief Read-only memory mapping of a whole file.
+            class mapped_file
+            {
+            public:
+                explicit mapped_file(const std::string &path)
+                {
+                    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+                    if (fd < 0)
+                    {
+                        error_ = std::strerror(errno);
+                        return;
+                    }
+
+                    struct stat info;
+                    if (::fstat(fd, &info) != 0)
+                        error_ = std::strerror(errno);
+                    else if (!S_ISREG(info.st_mode))
+                        error_ = "not a regular file";
+                    else
+                    {
+                        valid_ = true;
+                        size_ = static_cast<std::size_t>(info.st_size);
+                        if (size_ > 0)
+                        {
+                            void *data = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+                            if (data == MAP_FAILED)
+                            {
+                                valid_ = false;
+                                error_ = std::strerror(errno);
+                            }
+                            else
+                                data_ = data;
+                        }
+                    }
+
+                    // The mapping stays valid after the descriptor is closed.
+                    ::close(fd);
+                }
+
+                ~mapped_file()
+                {
+                    if (data_)
+                        ::munmap(data_, size_);
+                }
+
+                mapped_file(const mapped_file &other) = delete;
+                mapped_file &operator=(const mapped_file &other) = delete;
+
+                bool is_valid() const { return valid_; }
+
+                /// @brief Returns why the file could not be mapped.
+                const std::string &get_error() const { return error_; }
+
+                std::string_view get_contents() const { return std::string_view(static_cast<const char *>(data_), data_ ? size_ : 0); }
+
+            private:
+                void *data_ = nullptr;
+                std::size_t size_ = 0;
+                bool valid_ = false;
+                std::string error_;
+            };
+#endif
+
             inline load_result handle_result(lua_State *L, int result)
             {
                 if (result == LUA_OK)
@@ -56,6 +187,9 @@ namespace easylua
                 case LUA_ERRFILE:
                     return load_result(load_result::result::file_error, error_message);
                 case LUA_ERRRUN:
+                    if (detail::is_budget_exceeded(L))
+                        return load_result(load_result::result::budget_exceeded, error_message);
+
                     return load_result(load_result::result::runtime_error, error_message);
                 }
 
@@ -89,8 +223,103 @@ namespace easylua
          */
         inline load_result load_string(lua_State *L, const std::string &script)
         {
-            const int result = luaL_loadstring(L, script.c_str());
+            const int result = luaL_loadbufferx(L, script.data(), script.size(), script.c_str(), nullptr);
+            return internal::handle_result(L, result);
+        }
+
+        /**
+         * @brief Loads a chunk from memory without running it and without copying the buffer. The chunk can be source code or bytecode
+         * produced by dump(), depending on the mode.
+         *
+         * @param L The Lua state.
+         * @param buffer The chunk. It only needs to stay valid for the duration of the call.
+         * @param chunkname The name of the chunk, used in error messages and debug information.
+         * @param mode The kinds of chunks that are accepted. Loading bytecode from untrusted sources is not safe.
+         * @return load_result The result of the load.
+         */
+        inline load_result load_buffer(lua_State *L, std::string_view buffer, const char *chunkname = "=(load)", load_mode mode = load_mode::any)
+        {
+            const int result = luaL_loadbufferx(L, buffer.data(), buffer.size(), chunkname, internal::to_string(mode));
+            return internal::handle_result(L, result);
+        }
+
+#ifdef __cpp_lib_span
+        /// @copydoc load_buffer(lua_State *, std::string_view, const char *, load_mode)
+        inline load_result load_buffer(lua_State *L, std::span<const std::byte> buffer, const char *chunkname = "=(load)", load_mode mode = load_mode::any)
+        {
+            return load_buffer(L, std::string_view(reinterpret_cast<const char *>(buffer.data()), buffer.size()), chunkname, mode);
+        }
+#endif
+
+        /**
+         * @brief Loads a script from a file without running it. Unlike load_file(), the file is memory mapped and handed to Lua in a single
+         * chunk, so it is not copied through a stdio buffer. Like luaL_loadfile, a leading UTF-8 byte order mark and a first line starting
+         * with '#' are skipped. On platforms without mmap this is the same as load_file().
+         *
+         * The file stays mapped while it is loaded. If another process truncates it during the load, reading the missing pages raises
+         * SIGBUS, so only use this for files that are not modified in place while the program runs. Files are usually replaced by renaming
+         * a new file over them, which is safe.
+         *
+         * @param L The Lua state.
+         * @param path The path to the script.
+         * @param mode The kinds of chunks that are accepted.
+         * @return load_result The result of the load.
+         * @throw invalid_argument If the path is empty.
+         */
+        inline load_result load_file_mapped(lua_State *L, const std::string &path, load_mode mode = load_mode::any)
+        {
+            if (path.empty())
+                throw invalid_argument("path", "cannot be empty");
+
+#ifdef EASYLUA_HAS_MMAP
+            const internal::mapped_file file(path);
+            if (!file.is_valid())
+            {
+                lua_pushfstring(L, "cannot open %s: %s", path.c_str(), file.get_error().c_str());
+                return internal::handle_result(L, LUA_ERRFILE);
+            }
+
+            std::string_view contents = file.get_contents();
+            if (contents.substr(0, 3) == "\xEF\xBB\xBF")
+                contents.remove_prefix(3);
+
+            // Skip a shebang line but keep its newline so that line numbers stay correct.
+            if (!contents.empty() && contents.front() == '#')
+                contents.remove_prefix(std::min(contents.find('\n'), contents.size()));
+
+            const std::string chunkname = "@" + path;
+            const int result = lua_load(L, &internal::read_single_chunk, &contents, chunkname.c_str(), internal::to_string(mode));
             return internal::handle_result(L, result);
+#else
+            (void)mode;
+            return load_file(L, path);
+#endif
+        }
+
+        /**
+         * @brief Dumps a Lua function as precompiled bytecode, which can be loaded again with load_buffer().
+         *
+         * @param L The Lua state.
+         * @param index The index of the function on the stack.
+         * @param strip Whether to strip debug information from the bytecode.
+         * @return std::string The bytecode.
+         * @throw type_error If the value at the given index is not a function.
+         * @throw runtime_error If the function cannot be dumped, for example because it is a C function.
+         */
+        inline std::string dump(lua_State *L, int index = -1, bool strip = false)
+        {
+            if (lua_type(L, index) != LUA_TFUNCTION)
+                throw type_error(index, lua_type(L, index), LUA_TFUNCTION);
+
+            std::string bytecode;
+            lua_pushvalue(L, index);
+            const int result = lua_dump(L, &internal::write_to_string, &bytecode, strip);
+            lua_pop(L, 1);
+
+            if (result != 0 || bytecode.empty())
+                throw runtime_error("cannot dump function");
+
+            return bytecode;
         }
 
         /**
@@ -127,6 +356,45 @@ namespace easylua
             const int result = lua_pcall(L, 0, LUA_MULTRET, 0);
             return internal::handle_result(L, result);
         }
+
+        /**
+         * @brief Runs a script from a file within an execution budget.
+         *
+         * @param L The Lua state.
+         * @param path The path to the script.
+         * @param budget The limits for running the script. Loading the script does not count towards them.
+         * @return load_result The result of the run, budget_exceeded if the script was aborted.
+         * @throw invalid_argument If the path is empty.
+         */
+        inline load_result run_file(lua_State *L, const std::string &path, const execution_budget &budget)
+        {
+            const load_result load_result = load_file(L, path);
+            if (!load_result)
+                return load_result;
+
+            const budget_scope scope(L, budget);
+            const int result = lua_pcall(L, 0, LUA_MULTRET, 0);
+            return internal::handle_result(L, result);
+        }
+
+        /**
+         * @brief Runs a script from a string within an execution budget.
+         *
+         * @param L The Lua state.
+         * @param script The script.
+         * @param budget The limits for running the script. Loading the script does not count towards them.
+         * @return load_result The result of the run, budget_exceeded if the script was aborted.
+         */
+        inline load_result run_string(lua_State *L, const std::string &script, const execution_budget &budget)
+        {
+            const load_result load_result = load_string(L, script);
+            if (!load_result)
+                return load_result;
+
+            const budget_scope scope(L, budget);
+            const int result = lua_pcall(L, 0, LUA_MULTRET, 0);
+            return internal::handle_result(L, result);
+        }
     }
 
 } // namespace easylua
@@ -0,0 +1,831 @@
+#ifndef __EASYLUA_SNAPSHOT_H
+#define __EASYLUA_SNAPSHOT_H
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+#include "libraries.hpp"
+#include "script.hpp"
+#include "stack_guard.hpp"
+#include "state.hpp"
+
+namespace easylua
+{
+    /// @brief A value that could not be captured in a snapshot.
+    struct snapshot_issue
+    {
+        /// @brief Where the value was found, such as rules.handlers[3] or score<upvalue cache>.
+        std::string path;
+        /// @brief Why it could not be captured.
+        std::string reason;
+    };
+
+    /// @brief Options of state_snapshot.
+    struct snapshot_options
+    {
+        /// @brief The standard libraries that the captured state opened. They are not captured: the values that belong to them are stored
+        /// by name and taken from the libraries of the new state, which opens them again.
+        library libraries = library::all;
+        /// @brief The C functions that may be captured, by name. A C function that is neither in this list nor in a standard library cannot
+        /// be captured.
+        std::vector<std::pair<std::string, lua_CFunction>> functions;
+        /// @brief Whether to strip debug information from the bytecode of functions. Smaller and faster to load, but errors lose their
+        /// line numbers.
+        bool strip = false;
+        /// @brief Whether to throw if some value cannot be captured, instead of leaving it out and reporting it in get_issues().
+        bool strict = false;
+    };
+
+    /**
+     * @brief A copy of the globals of a fully initialized state, from which any number of new states can be built faster than by running
+     * the scripts that initialized it again.
+     *
+     * The snapshot walks every value reachable from the global table. Tables are copied with their metatables, and a table that is reachable
+     * through several paths, or from itself, is restored once with the same sharing. Lua functions are stored as bytecode with their
+     * upvalues; closures that shared an upvalue share it again in the restored state. Restoring loads the bytecode and fills tables directly,
+     * so no script is parsed or run. The bytecode of a function includes the name of its chunk unless it is stripped, so chunks should have
+     * short names, as files do: luaL_dostring names a chunk after its whole source.
+     *
+     * Values of the standard libraries are stored by name, such as string.format, and C functions by their name in
+     * snapshot_options::functions. The libraries of the state are compared with freshly opened ones: fields that scripts added to a library
+     * table or replaced, such as math.pi = 3, are captured like other values, and fields that scripts removed, such as os.execute = nil, are
+     * removed again when the snapshot is restored. Library tables with keys other than strings, such as package.searchers, are not
+     * compared. Userdata, threads, unregistered C functions and C closures with upvalues cannot be captured: they are left out and reported
+     * by get_issues(), or make the capture throw in strict mode. The registry, and so usertypes and references, is not part of the snapshot.
+     * Libraries must be opened eagerly in the captured state.
+     *
+     * Usage:
+     *                      state lua(library::all);
+     *                      lua.run(rules);
+     *                      state_snapshot snapshot(lua);
+     *                      for (const snapshot_issue &issue : snapshot.get_issues())
+     *                          std::cerr << issue.path << ": " << issue.reason << '\n';
+     *
+     *                      state worker = snapshot.instantiate();
+     */
+    class state_snapshot
+    {
+    public:
+        /**
+         * @brief Captures the globals of a state. The state is not modified.
+         *
+         * @param L The Lua state.
+         * @param options The options.
+         * @throw invalid_argument If L is null.
+         * @throw invalid_operation If options.strict is set and some value cannot be captured.
+         */
+        explicit state_snapshot(lua_State *L, snapshot_options options = {}) : options_(std::move(options))
+        {
+            if (!L)
+                throw invalid_argument("L", "cannot be null");
+
+            capturer(L, *this).run();
+
+            if (options_.strict && !issues_.empty())
+            {
+                std::string why = "cannot capture";
+                for (std::size_t i = 0; i < issues_.size(); i++)
+                    why += (i == 0 ? " " : "; ") + issues_[i].path + ": " + issues_[i].reason;
+
+                throw invalid_operation(why);
+            }
+        }
+
+        /// @brief Returns the values that could not be captured.
+        const std::vector<snapshot_issue> &get_issues() const { return issues_; }
+
+        /// @brief Returns whether every value reachable from the globals was captured.
+        bool is_complete() const { return issues_.empty(); }
+
+        /**
+         * @brief Opens the libraries of the snapshot in a state and restores the captured globals into it, including the changes made to
+         * the libraries. L should be a new state: globals that it already has are overwritten when the snapshot has them and kept otherwise.
+         *
+         * @param L The Lua state.
+         * @throw invalid_argument If L is null.
+         * @throw runtime_error If a library value of the snapshot does not exist in L.
+         */
+        void restore(lua_State *L) const
+        {
+            if (!L)
+                throw invalid_argument("L", "cannot be null");
+
+            const stack_guard guard(L);
+            detail::reserve_stack(L, 8);
+            open_libraries(L, options_.libraries);
+
+            lua_createtable(L, static_cast<int>(nodes_.size()), 0);
+            const int objects = lua_gettop(L);
+
+            // Tables and functions are created first, so that cycles can refer to them while they are filled.
+            for (std::size_t id = 0; id < nodes_.size(); id++)
+            {
+                const node &node = nodes_[id];
+                switch (node.type)
+                {
+                case kind::table:
+                    if (id == 0)
+                        lua_pushglobaltable(L);
+                    else
+                        lua_createtable(L, static_cast<int>(node.array_size), static_cast<int>(node.fields.size() - node.array_size));
+                    break;
+                case kind::lua_function:
+                    if (luaL_loadbufferx(L, node.text.data(), node.text.size(), "=snapshot", "b") != LUA_OK)
+                        throw runtime_error(lua_tostring(L, -1));
+                    break;
+                case kind::c_function:
+                    lua_pushcfunction(L, node.function);
+                    break;
+                case kind::library_value:
+                    push_library_value(L, node.text);
+                    if (lua_isnil(L, -1))
+                        throw runtime_error("library value " + node.text + " does not exist");
+                    break;
+                default:
+                    continue;
+                }
+
+                lua_rawseti(L, objects, static_cast<lua_Integer>(id) + 1);
+            }
+
+            for (std::size_t id = 0; id < nodes_.size(); id++)
+            {
+                const node &node = nodes_[id];
+                if (node.type == kind::table || node.type == kind::library_value)
+                {
+                    lua_rawgeti(L, objects, static_cast<lua_Integer>(id) + 1);
+                    for (const auto &[key, value] : node.fields)
+                    {
+                        push_node(L, objects, key);
+                        push_node(L, objects, value);
+                        lua_rawset(L, -3);
+                    }
+
+                    for (const std::string &key : node.removed)
+                    {
+                        lua_pushlstring(L, key.data(), key.size());
+                        lua_pushnil(L);
+                        lua_rawset(L, -3);
+                    }
+
+                    if (node.metatable != npos)
+                    {
+                        push_node(L, objects, node.metatable);
+                        lua_setmetatable(L, -2);
+                    }
+
+                    lua_pop(L, 1);
+                }
+                else if (node.type == kind::lua_function)
+                {
+                    lua_rawgeti(L, objects, static_cast<lua_Integer>(id) + 1);
+                    for (std::size_t i = 0; i < node.upvalues.size(); i++)
+                    {
+                        const upvalue &upvalue = node.upvalues[i];
+                        const int n = static_cast<int>(i) + 1;
+                        if (upvalue.shared_function != npos)
+                        {
+                            lua_rawgeti(L, objects, static_cast<lua_Integer>(upvalue.shared_function) + 1);
+                            lua_upvaluejoin(L, -2, n, -1, upvalue.shared_index);
+                            lua_pop(L, 1);
+                        }
+                        else
+                        {
+                            push_node(L, objects, upvalue.value);
+                            if (!lua_setupvalue(L, -2, n))
+                                lua_pop(L, 1);
+                        }
+                    }
+
+                    lua_pop(L, 1);
+                }
+            }
+        }
+
+        /**
+         * @brief Creates a new state and restores the snapshot into it.
+         *
+         * @throw runtime_error If the snapshot cannot be restored.
+         */
+        state instantiate() const
+        {
+            state lua;
+            restore(lua);
+            return lua;
+        }
+
+    private:
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        enum class kind : unsigned char
+        {
+            nil,
+            boolean,
+            integer,
+            number,
+            string,
+            table,
+            lua_function,
+            c_function,
+            library_value,
+            unsupported
+        };
+
+        struct upvalue
+        {
+            /// @brief The value of the upvalue, or npos for nil.
+            std::size_t value = npos;
+            /// @brief The function whose upvalue this one shares, or npos.
+            std::size_t shared_function = npos;
+            int shared_index = 0;
+        };
+
+        /// @brief A captured value. Values are referred to by their index in nodes_; the global table is node 0.
+        struct node
+        {
+            kind type = kind::nil;
+            bool boolean = false;
+            lua_Integer integer = 0;
+            lua_Number number = 0;
+            /// @brief The contents of a string, the bytecode of a Lua function, or the name of a library value.
+            std::string text;
+            lua_CFunction function = nullptr;
+            /// @brief The fields of a table. For a library table, only the fields that differ from the library.
+            std::vector<std::pair<std::size_t, std::size_t>> fields;
+            /// @brief The library fields that were removed from the global table or a library table.
+            std::vector<std::string> removed;
+            std::size_t array_size = 0;
+            std::size_t metatable = npos;
+            std::vector<upvalue> upvalues;
+        };
+
+        /// @brief Walks the values reachable from the globals of a state. Everything it pushes is popped when it is destroyed.
+        class capturer
+        {
+        public:
+            capturer(lua_State *L, state_snapshot &snapshot) : L_(L), snapshot_(snapshot), guard_(L)
+            {
+                for (const auto &[name, function] : snapshot_.options_.functions)
+                    functions_.emplace(function, name);
+            }
+
+            void run()
+            {
+                detail::reserve_stack(L_, 8);
+                lua_newtable(L_);
+                seen_ = lua_gettop(L_);
+                lua_newtable(L_);
+                library_values_ = lua_gettop(L_);
+                lua_newtable(L_);
+                library_tables_ = lua_gettop(L_);
+                find_library_values();
+
+                lua_pushglobaltable(L_);
+                capture(lua_gettop(L_), std::string());
+                nodes()[0].removed = removed_fields(std::string());
+            }
+
+        private:
+            /**
+             * @brief Finds the values of the standard libraries in the state, by opening the same libraries in a scratch state and walking
+             * both global tables side by side. Library tables are walked through their string keys, once each. A field of the state is
+             * recorded as part of the library when it is still the value that the library defines; fields that are missing are recorded
+             * as removed, and fields that differ are left to be captured like other values.
+             */
+            void find_library_values()
+            {
+                if (snapshot_.options_.libraries == library::none)
+                    return;
+
+                state scratch;
+                open_libraries(scratch, snapshot_.options_.libraries);
+                lua_State *S = scratch;
+                lua_newtable(S); // library table -> name
+                const int scratch_names = lua_gettop(S);
+                lua_newtable(S); // name -> library table
+                const int scratch_tables = lua_gettop(S);
+
+                lua_pushglobaltable(S);
+                lua_pushliteral(S, "");
+                lua_rawset(S, scratch_names);
+                lua_pushliteral(S, "");
+                lua_pushglobaltable(S);
+                lua_rawset(S, scratch_tables);
+                lua_pushliteral(L_, "");
+                lua_pushglobaltable(L_);
+                lua_rawset(L_, library_tables_);
+
+                std::vector<std::string> tables{std::string()};
+                for (std::size_t i = 0; i < tables.size(); i++)
+                {
+                    const std::string name = tables[i];
+                    detail::reserve_stack(S, 8);
+                    detail::reserve_stack(L_, 8);
+                    lua_pushstring(S, name.c_str());
+                    lua_rawget(S, scratch_tables);
+                    const int library = lua_gettop(S);
+                    lua_pushstring(L_, name.c_str());
+                    lua_rawget(L_, library_tables_);
+                    const int table = lua_gettop(L_);
+
+                    lua_pushnil(S);
+                    while (lua_next(S, library) != 0)
+                    {
+                        if (lua_type(S, -2) == LUA_TSTRING)
+                        {
+                            const char *key = lua_tostring(S, -2);
+                            const std::string member = name.empty() ? key : name + "." + key;
+                            lua_pushstring(L_, key);
+                            if (lua_rawget(L_, table) == LUA_TNIL)
+                                removed_[name].push_back(key);
+                            else if (match_library_value(S, scratch_names, scratch_tables, member, name.empty(), tables))
+                                library_fields_.insert(member);
+
+                            lua_pop(L_, 1);
+                        }
+
+                        lua_pop(S, 1);
+                    }
+
+                    lua_settop(S, library - 1);
+                    lua_settop(L_, table - 1);
+                }
+            }
+
+            /**
+             * @brief Returns whether the value at the top of L_ is the library value at the top of S, and records it if it is. A library
+             * table is only walked once, under the first name it is found with; other names, such as package.loaded.string, must refer to
+             * the same table in L_.
+             */
+            bool match_library_value(lua_State *S, int scratch_names, int scratch_tables, const std::string &member, bool global,
+                                     std::vector<std::string> &tables)
+            {
+                switch (lua_type(S, -1))
+                {
+                case LUA_TTABLE:
+                {
+                    lua_pushvalue(S, -1);
+                    if (lua_rawget(S, scratch_names) == LUA_TSTRING)
+                    {
+                        lua_pushstring(L_, lua_tostring(S, -1));
+                        lua_pop(S, 1);
+                        lua_rawget(L_, library_tables_);
+                        const bool same = lua_rawequal(L_, -1, -2);
+                        lua_pop(L_, 1);
+                        return same;
+                    }
+
+                    lua_pop(S, 1);
+                    lua_pushvalue(S, -1);
+                    lua_pushstring(S, member.c_str());
+                    lua_rawset(S, scratch_names);
+
+                    // A script may have replaced a global library with another table; the library itself is still its entry in
+                    // package.loaded, and is walked so that the values it shares with the replacement are found.
+                    lua_pushvalue(L_, -1);
+                    if (global)
+                    {
+                        const int top = lua_gettop(L_);
+                        if (lua_getfield(L_, LUA_REGISTRYINDEX, LUA_LOADED_TABLE) == LUA_TTABLE &&
+                            lua_getfield(L_, -1, member.c_str()) == LUA_TTABLE)
+                            lua_copy(L_, -1, top);
+
+                        lua_settop(L_, top);
+                    }
+
+                    if (!lua_istable(L_, -1) || is_library_value(-1))
+                    {
+                        lua_pop(L_, 1);
+                        return false;
+                    }
+
+                    lua_pushstring(S, member.c_str());
+                    lua_pushvalue(S, -2);
+                    lua_rawset(S, scratch_tables);
+                    lua_pushstring(L_, member.c_str());
+                    lua_pushvalue(L_, -2);
+                    lua_rawset(L_, library_tables_);
+                    add_library_value(member);
+
+                    if (has_string_keys_only(S))
+                        tables.push_back(member);
+                    else
+                        opaque_tables_.insert(member);
+
+                    const bool same = lua_rawequal(L_, -1, -2);
+                    lua_pop(L_, 1);
+                    return same;
+                }
+                case LUA_TFUNCTION:
+                    if (!lua_iscfunction(L_, -1) || lua_tocfunction(L_, -1) != lua_tocfunction(S, -1))
+                        return false;
+
+                    if (!is_library_value(-1))
+                        add_library_value(member);
+
+                    return true;
+                case LUA_TUSERDATA:
+                    return lua_type(L_, -1) == LUA_TUSERDATA;
+                case LUA_TNUMBER:
+                    if (lua_isinteger(S, -1))
+                        lua_pushinteger(L_, lua_tointeger(S, -1));
+                    else
+                        lua_pushnumber(L_, lua_tonumber(S, -1));
+                    break;
+                case LUA_TSTRING:
+                {
+                    std::size_t size;
+                    const char *data = lua_tolstring(S, -1, &size);
+                    lua_pushlstring(L_, data, size);
+                    break;
+                }
+                case LUA_TBOOLEAN:
+                    lua_pushboolean(L_, lua_toboolean(S, -1));
+                    break;
+                default:
+                    return false;
+                }
+
+                const bool same = lua_rawequal(L_, -1, -2) && lua_isinteger(L_, -1) == lua_isinteger(L_, -2);
+                lua_pop(L_, 1);
+                return same;
+            }
+
+            bool is_library_value(int index)
+            {
+                lua_pushvalue(L_, index);
+                const bool found = lua_rawget(L_, library_values_) != LUA_TNIL;
+                lua_pop(L_, 1);
+                return found;
+            }
+
+            /// @brief Records the value at the top of L_ as the library value with the given name.
+            void add_library_value(const std::string &name)
+            {
+                lua_pushvalue(L_, -1);
+                lua_pushstring(L_, name.c_str());
+                lua_rawset(L_, library_values_);
+            }
+
+            static bool has_string_keys_only(lua_State *S)
+            {
+                lua_pushnil(S);
+                while (lua_next(S, -2) != 0)
+                {
+                    if (lua_type(S, -2) != LUA_TSTRING)
+                    {
+                        lua_pop(S, 2);
+                        return false;
+                    }
+
+                    lua_pop(S, 1);
+                }
+
+                return true;
+            }
+
+            std::vector<std::string> removed_fields(const std::string &name) const
+            {
+                const auto it = removed_.find(name);
+                return it != removed_.end() ? it->second : std::vector<std::string>();
+            }
+
+            /// @brief Captures the value at the given absolute index and returns its node, or npos if it cannot be captured.
+            std::size_t capture(int index, const std::string &path)
+            {
+                detail::reserve_stack(L_, 4);
+                const int type = lua_type(L_, index);
+                switch (type)
+                {
+                case LUA_TNIL:
+                    return add(kind::nil);
+                case LUA_TBOOLEAN:
+                {
+                    const std::size_t id = add(kind::boolean);
+                    nodes()[id].boolean = lua_toboolean(L_, index);
+                    return id;
+                }
+                case LUA_TNUMBER:
+                    if (lua_isinteger(L_, index))
+                    {
+                        const std::size_t id = add(kind::integer);
+                        nodes()[id].integer = lua_tointeger(L_, index);
+                        return id;
+                    }
+                    else
+                    {
+                        const std::size_t id = add(kind::number);
+                        nodes()[id].number = lua_tonumber(L_, index);
+                        return id;
+                    }
+                case LUA_TSTRING:
+                {
+                    std::size_t size;
+                    const char *data = lua_tolstring(L_, index, &size);
+                    const std::size_t id = add(kind::string);
+                    nodes()[id].text.assign(data, size);
+                    return id;
+                }
+                case LUA_TTABLE:
+                case LUA_TFUNCTION:
+                    return capture_object(index, path);
+                default:
+                    report(path, std::string(lua_typename(L_, type)) + " values cannot be captured");
+                    return npos;
+                }
+            }
+
+            std::size_t capture_object(int index, const std::string &path)
+            {
+                lua_pushvalue(L_, index);
+                if (lua_rawget(L_, seen_) == LUA_TNUMBER)
+                {
+                    const auto id = static_cast<std::size_t>(lua_tointeger(L_, -1));
+                    lua_pop(L_, 1);
+                    return nodes()[id].type == kind::unsupported ? npos : id;
+                }
+
+                lua_pop(L_, 1);
+
+                const std::size_t id = add(kind::unsupported);
+                lua_pushvalue(L_, index);
+                lua_pushinteger(L_, static_cast<lua_Integer>(id));
+                lua_rawset(L_, seen_);
+
+                lua_pushvalue(L_, index);
+                if (lua_rawget(L_, library_values_) == LUA_TSTRING)
+                {
+                    nodes()[id].type = kind::library_value;
+                    nodes()[id].text = lua_tostring(L_, -1);
+                    lua_pop(L_, 1);
+                    if (lua_istable(L_, index))
+                        capture_library_table(index, id);
+
+                    return id;
+                }
+
+                lua_pop(L_, 1);
+
+                if (lua_istable(L_, index))
+                    return capture_table(index, id, path);
+
+                return capture_function(index, id, path);
+            }
+
+            std::size_t capture_table(int index, std::size_t id, const std::string &path)
+            {
+                nodes()[id].type = kind::table;
+
+                lua_pushnil(L_);
+                while (lua_next(L_, index) != 0)
+                {
+                    const int key = lua_gettop(L_) - 1;
+                    capture_field(key, id, path);
+                    lua_settop(L_, key);
+                }
+
+                capture_metatable(index, id, path);
+                return id;
+            }
+
+            /**
+             * @brief Captures the fields of a library table that differ from the library, and the fields of the library tables inside it.
+             * The other fields are restored by opening the library.
+             */
+            void capture_library_table(int index, std::size_t id)
+            {
+                const std::string name = nodes()[id].text;
+                if (opaque_tables_.count(name) != 0)
+                    return;
+
+                nodes()[id].removed = removed_fields(name);
+
+                lua_pushnil(L_);
+                while (lua_next(L_, index) != 0)
+                {
+                    const int key = lua_gettop(L_) - 1;
+                    if (lua_type(L_, key) == LUA_TSTRING && library_fields_.count(child_path(name, key)) != 0)
+                    {
+                        if (lua_istable(L_, key + 1))
+                            capture(key + 1, child_path(name, key));
+                    }
+                    else
+                        capture_field(key, id, name);
+
+                    lua_settop(L_, key);
+                }
+
+                capture_metatable(index, id, name);
+            }
+
+            /// @brief Captures the key at the given index and the value above it as a field of the table node.
+            void capture_field(int key, std::size_t id, const std::string &path)
+            {
+                const std::string child = child_path(path, key);
+                const std::size_t key_id = capture(key, child + "<key>");
+                const std::size_t value_id = key_id != npos ? capture(key + 1, child) : npos;
+                if (value_id != npos)
+                {
+                    nodes()[id].fields.emplace_back(key_id, value_id);
+                    if (nodes()[key_id].type == kind::integer)
+                        nodes()[id].array_size++;
+                }
+            }
+
+            void capture_metatable(int index, std::size_t id, const std::string &path)
+            {
+                if (lua_getmetatable(L_, index))
+                {
+                    nodes()[id].metatable = capture(lua_gettop(L_), path + "<metatable>");
+                    lua_pop(L_, 1);
+                }
+            }
+
+            std::size_t capture_function(int index, std::size_t id, const std::string &path)
+            {
+                if (lua_iscfunction(L_, index))
+                {
+                    const lua_CFunction function = lua_tocfunction(L_, index);
+                    const auto it = functions_.find(function);
+                    if (it == functions_.end())
+                    {
+                        report(path, "C function is not registered");
+                        return npos;
+                    }
+
+                    if (lua_getupvalue(L_, index, 1))
+                    {
+                        lua_pop(L_, 1);
+                        report(path, "C closure " + it->second + " has upvalues");
+                        return npos;
+                    }
+
+                    nodes()[id].type = kind::c_function;
+                    nodes()[id].function = function;
+                    nodes()[id].text = it->second;
+                    return id;
+                }
+
+                std::string bytecode;
+                lua_pushvalue(L_, index);
+                const int result = lua_dump(L_, &script::internal::write_to_string, &bytecode, snapshot_.options_.strip);
+                lua_pop(L_, 1);
+                if (result != 0 || bytecode.empty())
+                {
+                    report(path, "function cannot be dumped");
+                    return npos;
+                }
+
+                nodes()[id].type = kind::lua_function;
+                nodes()[id].text = std::move(bytecode);
+
+                for (int i = 1;; i++)
+                {
+                    const char *name = lua_getupvalue(L_, index, i);
+                    if (!name)
+                        break;
+
+                    upvalue upvalue;
+                    const auto [it, inserted] = upvalues_.try_emplace(lua_upvalueid(L_, index, i), id, i);
+                    if (inserted)
+                        upvalue.value = capture(lua_gettop(L_), path + "<upvalue " + (*name ? name : "?") + ">");
+                    else
+                    {
+                        upvalue.shared_function = it->second.first;
+                        upvalue.shared_index = it->second.second;
+                    }
+
+                    nodes()[id].upvalues.push_back(upvalue);
+                    lua_pop(L_, 1);
+                }
+
+                return id;
+            }
+
+            std::string child_path(const std::string &path, int key) const
+            {
+                switch (lua_type(L_, key))
+                {
+                case LUA_TSTRING:
+                {
+                    // lua_tostring does not convert the key, since it is already a string.
+                    const char *name = lua_tostring(L_, key);
+                    return path.empty() ? name : path + "." + name;
+                }
+                case LUA_TNUMBER:
+                    if (lua_isinteger(L_, key))
+                        return path + "[" + std::to_string(lua_tointeger(L_, key)) + "]";
+
+                    return path + "[" + std::to_string(lua_tonumber(L_, key)) + "]";
+                default:
+                    return path + "[" + luaL_typename(L_, key) + "]";
+                }
+            }
+
+            std::size_t add(kind type)
+            {
+                nodes().emplace_back();
+                nodes().back().type = type;
+                return nodes().size() - 1;
+            }
+
+            void report(const std::string &path, std::string reason)
+            {
+                snapshot_.issues_.push_back(snapshot_issue{path.empty() ? LUA_GNAME : path, std::move(reason)});
+            }
+
+            std::vector<node> &nodes() { return snapshot_.nodes_; }
+
+            lua_State *L_;
+            state_snapshot &snapshot_;
+            const stack_guard guard_;
+            int seen_ = 0;
+            /// @brief Library value -> name, for the tables and functions that are still those of the libraries.
+            int library_values_ = 0;
+            /// @brief Name -> library table, for the library tables that are walked.
+            int library_tables_ = 0;
+            std::unordered_map<lua_CFunction, std::string> functions_;
+            /// @brief The names of the library fields that still hold the value of the library, such as string.format.
+            std::unordered_set<std::string> library_fields_;
+            /// @brief The library tables that have other keys than strings, which are not compared.
+            std::unordered_set<std::string> opaque_tables_;
+            /// @brief The library fields that are missing, by the name of their table; the global table is "".
+            std::unordered_map<std::string, std::vector<std::string>> removed_;
+            std::unordered_map<void *, std::pair<std::size_t, int>> upvalues_;
+        };
+
+        /// @brief Pushes the library value with the given name, such as print, string.format or package.loaded, or nil if it does not exist.
+        static void push_library_value(lua_State *L, const std::string &name)
+        {
+            lua_pushglobaltable(L);
+            std::size_t start = 0;
+            for (;;)
+            {
+                if (!lua_istable(L, -1))
+                {
+                    lua_pop(L, 1);
+                    lua_pushnil(L);
+                    return;
+                }
+
+                const std::size_t dot = name.find('.', start);
+                const std::size_t end = dot == std::string::npos ? name.size() : dot;
+                lua_pushlstring(L, name.data() + start, end - start);
+                lua_rawget(L, -2);
+                lua_remove(L, -2);
+                if (dot == std::string::npos)
+                    return;
+
+                start = dot + 1;
+            }
+        }
+
+        void push_node(lua_State *L, int objects, std::size_t id) const
+        {
+            if (id == npos)
+            {
+                lua_pushnil(L);
+                return;
+            }
+
+            const node &node = nodes_[id];
+            switch (node.type)
+            {
+            case kind::boolean:
+                lua_pushboolean(L, node.boolean);
+                break;
+            case kind::integer:
+                lua_pushinteger(L, node.integer);
+                break;
+            case kind::number:
+                lua_pushnumber(L, node.number);
+                break;
+            case kind::string:
+                lua_pushlstring(L, node.text.data(), node.text.size());
+                break;
+            case kind::table:
+            case kind::lua_function:
+            case kind::c_function:
+            case kind::library_value:
+                lua_rawgeti(L, objects, static_cast<lua_Integer>(id) + 1);
+                break;
+            default:
+                lua_pushnil(L);
+                break;
+            }
+        }
+
+        snapshot_options options_;
+        std::vector<node> nodes_;
+        std::vector<snapshot_issue> issues_;
+    };
+} // namespace easylua
+
+#endif
@@ -1,20 +1,207 @@
 #ifndef __EASYLUA_STACK_H
 #define __EASYLUA_STACK_H
 
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <array>
+#include <initializer_list>
+#include <map>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if __has_include(<version>)
+#include <version>
+#endif
+
+#ifdef __cpp_lib_span
+#include <span>
+#endif
+
 #include <lua.hpp>
 
 #include "exception.hpp"
+#include "expected.hpp"
 #include "reference.hpp"
+#include "stack_guard.hpp"
 #include "types.hpp"
 
 namespace easylua
 {
-    // TODO should this throw an exception or return an optional<T>?
+    namespace detail
+    {
+        template <typename F, typename = void>
+        struct function_traits;
+
+        template <typename T>
+        struct is_tuple : std::false_type
+        {
+        };
+
+        template <typename... T>
+        struct is_tuple<std::tuple<T...>> : std::true_type
+        {
+        };
+
+        /// @brief True if T is a specialization of the class template Template.
+        template <typename T, template <typename...> class Template>
+        struct is_specialization_of : std::false_type
+        {
+        };
+
+        template <template <typename...> class Template, typename... Args>
+        struct is_specialization_of<Template<Args...>, Template> : std::true_type
+        {
+        };
+
+        /**
+         * @brief Tells whether a bound function that returns T yields its coroutine rather than returning, and pushes the values that it
+         * yields. Specialized for easylua::yield, and for awaitables in coroutine.hpp.
+         */
+        template <typename T, typename = void>
+        struct yield_traits
+        {
+            static constexpr bool yields = false;
+        };
+
+        template <typename... T>
+        struct yield_traits<yield<T...>>
+        {
+            static constexpr bool yields = true;
+
+            static int push(lua_State *L, yield<T...> &&value);
+        };
+
+        template <typename T>
+        struct is_std_array : std::false_type
+        {
+        };
+
+        template <typename T, std::size_t N>
+        struct is_std_array<std::array<T, N>> : std::true_type
+        {
+        };
+
+        template <typename T>
+        struct is_span : std::false_type
+        {
+        };
+
+#ifdef __cpp_lib_span
+        template <typename T, std::size_t Extent>
+        struct is_span<std::span<T, Extent>> : std::true_type
+        {
+        };
+#endif
+
+        /// @brief True for containers that are converted to and from Lua tables with integer keys 1 to n.
+        template <typename T>
+        static constexpr bool is_sequence_v = is_specialization_of<T, std::vector>::value || is_std_array<T>::value || is_span<T>::value;
+
+        /// @brief True for containers that are converted to and from Lua tables with arbitrary keys.
+        template <typename T>
+        static constexpr bool is_associative_v = is_specialization_of<T, std::map>::value || is_specialization_of<T, std::unordered_map>::value;
+
+        /// @brief True for std::pair and std::tuple, which are converted to and from Lua tables with integer keys 1 to n.
+        template <typename T>
+        static constexpr bool is_product_v = is_specialization_of<T, std::pair>::value || is_tuple<T>::value;
+
+        /// @brief True for C++ functions, member functions and callable objects that can be bound as Lua functions.
+        template <typename T, typename = void>
+        struct is_native_function : std::bool_constant<(std::is_pointer_v<T> && std::is_function_v<std::remove_pointer_t<T>>) || std::is_member_function_pointer_v<T>>
+        {
+        };
+
+        template <typename T>
+        struct is_native_function<T, std::void_t<decltype(&T::operator())>> : std::true_type
+        {
+        };
+
+        /// @brief True for pointers to class types. They are pushed as full userdata with the pointer metatable of the type.
+        template <typename T>
+        static constexpr bool is_object_pointer_v = std::is_pointer_v<T> && std::is_class_v<std::remove_pointer_t<T>>;
+
+        /// @brief True for class types that have no built-in conversion and are therefore passed to Lua as usertypes.
+        template <typename T>
+        static constexpr bool is_usertype_v = std::is_class_v<T> && !std::is_same_v<T, std::string> && !std::is_same_v<T, std::string_view> &&
+                                              !std::is_same_v<T, nil_t> && !std::is_base_of_v<reference, T> && !is_sequence_v<T> &&
+                                              !is_associative_v<T> && !is_product_v<T> && !is_specialization_of<T, std::optional>::value &&
+                                              !is_native_function<T>::value;
+
+        template <typename F, typename U>
+        void push_native_function(lua_State *L, U &&function);
+
+        template <typename T>
+        T *to_object(lua_State *L, int index);
+
+        template <typename T, typename U>
+        void push_object(lua_State *L, U &&object);
+
+        template <typename T>
+        void push_object_pointer(lua_State *L, T *object);
+
+        template <typename E>
+        E get_element(lua_State *L, int table, lua_Integer key);
+
+        template <typename T, std::size_t... I>
+        T get_elements(lua_State *L, int table, std::index_sequence<I...>);
+
+        template <typename Container, typename Element>
+        void push_element(lua_State *L, Element &element);
+
+        /// @brief True for the containers that stack::get reads from tables.
+        template <typename T>
+        static constexpr bool is_readable_container_v = is_specialization_of<T, std::vector>::value || is_std_array<T>::value || is_associative_v<T> ||
+                                                        is_product_v<T>;
+
+        /// @brief True for types that point into a Lua string, which dangle once the string is popped.
+        template <typename T>
+        static constexpr bool is_borrowed_string_v = std::is_same_v<T, std::string_view> || std::is_same_v<T, const char *>;
+
+        /// @brief The Lua type that stack::get<T> requires at the top level, or LUA_TNONE if it does not require one.
+        template <typename T>
+        constexpr int required_type()
+        {
+            if constexpr (std::is_same_v<T, bool>)
+                return LUA_TBOOLEAN;
+            else if constexpr (std::is_integral_v<T> || std::is_floating_point_v<T>)
+                return LUA_TNUMBER;
+            else if constexpr (std::is_same_v<T, const char *> || std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
+                return LUA_TSTRING;
+            else if constexpr (std::is_same_v<T, nil_t>)
+                return LUA_TNIL;
+            else if constexpr (std::is_same_v<T, lua_CFunction>)
+                return LUA_TFUNCTION;
+            else if constexpr (is_readable_container_v<T>)
+                return LUA_TTABLE;
+            else
+                return LUA_TNONE;
+        }
+    } // namespace detail
+
     namespace stack
     {
         /**
          * @brief get the value at the given index on the stack.
          *
+         * Strings keep their length, including embedded zeros. A std::string_view or const char * result does not allocate and points into
+         * the Lua string. It remains valid as long as the string is anchored: while it stays in the same stack slot, or while a reference
+         * to it (such as a safe_string_reference) is alive.
+         *
+         * Tables can be read into std::vector, std::array, std::pair and std::tuple from the keys 1 to n, and into std::map and
+         * std::unordered_map from all their keys. A std::vector is reserved up front from the length of the table. std::optional is empty
+         * for nil or a missing argument.
+         *
+         * A pointer to a class type is read from a userdata of that type, whether it holds the object or a pointer to it, and is null for
+         * nil. Light userdata and userdata of other types are rejected.
+         *
          * @tparam T The type of the value to get.
          * @param L The Lua state.
          * @param index The index of the value on the stack.
@@ -49,10 +236,16 @@ namespace easylua
             }
             else if constexpr (std::is_same_v<T, const char *> || std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>)
             {
-                if (lua_type(L, index) == LUA_TSTRING)
-                    return lua_tostring(L, index);
+                // Only actual strings are accepted, so lua_tolstring never converts (and allocates) in place.
+                if (lua_type(L, index) != LUA_TSTRING)
+                    throw type_error(index, lua_type(L, index), LUA_TSTRING);
 
-                throw type_error(index, lua_type(L, index), LUA_TSTRING);
+                std::size_t length = 0;
+                const char *data = lua_tolstring(L, index, &length);
+                if constexpr (std::is_same_v<T, const char *>)
+                    return data;
+                else
+                    return T(data, length);
             }
             else if constexpr (std::is_same_v<T, nil_t>)
             {
@@ -61,10 +254,80 @@ namespace easylua
 
                 throw type_error(index, lua_type(L, index), LUA_TNIL);
             }
-            else if constexpr (std::is_base_of_v<unsafe_reference, T> || std::is_base_of_v<safe_reference, T>)
+            else if constexpr (std::is_base_of_v<unsafe_reference, T>)
             {
                 return T(L, index);
             }
+            else if constexpr (std::is_base_of_v<safe_reference, T>)
+            {
+                // The reference takes the copy, so the stack is left unchanged. The guard pops the copy if its type is wrong.
+                const stack_guard guard(L);
+                lua_pushvalue(L, index);
+                return T(L, -1);
+            }
+            else if constexpr (detail::is_specialization_of<T, std::optional>::value)
+            {
+                if (lua_isnoneornil(L, index))
+                    return std::nullopt;
+
+                return T(get<typename T::value_type>(L, index));
+            }
+            else if constexpr (detail::is_specialization_of<T, std::vector>::value || detail::is_std_array<T>::value)
+            {
+                if (lua_type(L, index) != LUA_TTABLE)
+                    throw type_error(index, lua_type(L, index), LUA_TTABLE);
+
+                const stack_guard guard(L);
+                const int table = lua_absindex(L, index);
+                const int top = lua_gettop(L);
+                T result{};
+                if constexpr (detail::is_std_array<T>::value)
+                {
+                    for (std::size_t i = 0; i < result.size(); i++)
+                    {
+                        lua_rawgeti(L, table, static_cast<lua_Integer>(i + 1));
+                        result[i] = get<typename T::value_type>(L, -1);
+                        lua_settop(L, top);
+                    }
+                }
+                else
+                {
+                    const std::size_t size = lua_rawlen(L, table);
+                    result.reserve(size);
+                    for (std::size_t i = 1; i <= size; i++)
+                    {
+                        lua_rawgeti(L, table, static_cast<lua_Integer>(i));
+                        result.push_back(get<typename T::value_type>(L, -1));
+                        lua_settop(L, top);
+                    }
+                }
+
+                return result;
+            }
+            else if constexpr (detail::is_associative_v<T>)
+            {
+                if (lua_type(L, index) != LUA_TTABLE)
+                    throw type_error(index, lua_type(L, index), LUA_TTABLE);
+
+                const stack_guard guard(L);
+                const int table = lua_absindex(L, index);
+                T result;
+                lua_pushnil(L);
+                while (lua_next(L, table) != 0)
+                {
+                    result.emplace(get<typename T::key_type>(L, -2), get<typename T::mapped_type>(L, -1));
+                    lua_pop(L, 1);
+                }
+
+                return result;
+            }
+            else if constexpr (detail::is_product_v<T>)
+            {
+                if (lua_type(L, index) != LUA_TTABLE)
+                    throw type_error(index, lua_type(L, index), LUA_TTABLE);
+
+                return detail::get_elements<T>(L, lua_absindex(L, index), std::make_index_sequence<std::tuple_size_v<T>>());
+            }
             else if constexpr (std::is_same_v<T, lua_CFunction>)
             {
                 if (lua_type(L, index) == LUA_TFUNCTION)
@@ -72,10 +335,113 @@ namespace easylua
 
                 throw type_error(index, lua_type(L, index), LUA_TFUNCTION);
             }
+            else if constexpr (detail::is_object_pointer_v<T>)
+            {
+                // Light userdata carries no type, so only userdata with the metatable of the type are accepted.
+                if (lua_isnoneornil(L, index))
+                    return nullptr;
+
+                if (auto *object = detail::to_object<std::remove_cv_t<std::remove_pointer_t<T>>>(L, index))
+                    return object;
+
+                throw type_error(index, lua_type(L, index), LUA_TUSERDATA);
+            }
+            else if constexpr (detail::is_usertype_v<T>)
+            {
+                if (T *object = detail::to_object<T>(L, index))
+                    return *object;
+
+                throw type_error(index, lua_type(L, index), LUA_TUSERDATA);
+            }
             else
                 static_assert(!sizeof(T *), "Unsupported type");
         }
 
+        /**
+         * @brief get the value at the given index on the stack, or an error if it does not have the right type. Unlike get(), a type
+         * mismatch is returned rather than thrown, so reading a value that is often of another type (such as "a number or nil") costs no
+         * exception and no allocation. The conversions are those of get().
+         *
+         * Scalars, strings, std::optional, pointers and usertypes are checked without exceptions. Containers and references check their
+         * top-level type first; a mismatch inside a container, or in the constructor of a reference, is caught and returned.
+         *
+         * Usage:
+         *                      if (expected<double> score = stack::try_get<double>(L, -1))
+         *                          total += *score;
+         *
+         * @tparam T The type of the value to get.
+         * @param L The Lua state.
+         * @param index The index of the value on the stack.
+         * @return expected<T> The value, or the error.
+         */
+        template <typename T>
+        expected<T> try_get(lua_State *L, int index = -1)
+        {
+            if (index == 0)
+                return error::invalid_index();
+
+            const int type = lua_type(L, index);
+            if constexpr (detail::is_specialization_of<T, std::optional>::value)
+            {
+                if (type == LUA_TNONE || type == LUA_TNIL)
+                    return T();
+
+                expected<typename T::value_type> value = try_get<typename T::value_type>(L, index);
+                if (!value)
+                    return value.get_error();
+
+                return T(std::move(*value));
+            }
+            else if constexpr (detail::is_object_pointer_v<T>)
+            {
+                if (type == LUA_TNONE || type == LUA_TNIL)
+                    return static_cast<T>(nullptr);
+
+                if (auto *object = detail::to_object<std::remove_cv_t<std::remove_pointer_t<T>>>(L, index))
+                    return static_cast<T>(object);
+
+                return error::type_mismatch(index, type, LUA_TUSERDATA);
+            }
+            else if constexpr (detail::is_usertype_v<T>)
+            {
+                if (T *object = detail::to_object<T>(L, index))
+                    return *object;
+
+                return error::type_mismatch(index, type, LUA_TUSERDATA);
+            }
+            else if constexpr (detail::is_readable_container_v<T> || std::is_base_of_v<reference, T>)
+            {
+                constexpr int required = detail::required_type<T>();
+                if (required != LUA_TNONE && type != required)
+                    return error::type_mismatch(index, type, required);
+
+                try
+                {
+                    return get<T>(L, index);
+                }
+                catch (const type_error &e)
+                {
+                    return error::type_mismatch(e.get_index(), e.get_actual_type(), e.get_expected_type());
+                }
+            }
+            else
+            {
+                constexpr int required = detail::required_type<T>();
+                if (type != required)
+                    return error::type_mismatch(index, type, required);
+
+                // The type is known to match, so numbers and booleans are converted without checking it again.
+                if constexpr (std::is_same_v<T, bool>)
+                    return static_cast<bool>(lua_toboolean(L, index));
+                else if constexpr (std::is_integral_v<T>)
+                    return static_cast<T>(lua_tointeger(L, index));
+                else if constexpr (std::is_floating_point_v<T>)
+                    return static_cast<T>(lua_tonumber(L, index));
+                else
+                    return get<T>(L, index);
+            }
+        }
+
         template <typename... T, typename std::enable_if_t<(sizeof...(T) >= 2), bool> = true>
         std::tuple<T...> get(lua_State *L)
         {
@@ -84,42 +450,93 @@ namespace easylua
         }
 
         /**
-         * @brief push the given value onto the stack.
+         * @brief push the given value onto the stack. The value is taken by forwarding reference, so strings and references are not copied,
+         * and objects that are moved into Lua (usertypes, bound callables) are constructed in place from the argument.
+         *
+         * Containers are pushed as tables that are created at their final size: std::vector, std::array, std::span, std::pair and
+         * std::tuple as sequences, std::map and std::unordered_map with their own keys. An empty std::optional is pushed as nil.
          *
          * @tparam T The type of the value to set.
          * @param L The Lua state.
          * @param value The value to set.
          */
         template <typename T>
-        void push(lua_State *L, T value)
+        void push(lua_State *L, T &&value)
         {
-            if constexpr (std::is_same_v<T, const char *>)
+            using type = std::decay_t<T>;
+
+            if constexpr (std::is_same_v<type, const char *> || std::is_same_v<type, char *>)
                 lua_pushstring(L, value);
-            else if constexpr (std::is_same_v<T, std::string>)
-                lua_pushstring(L, value.c_str());
-            else if constexpr (std::is_same_v<T, std::string_view>)
+            else if constexpr (std::is_same_v<type, std::string> || std::is_same_v<type, std::string_view>)
                 lua_pushlstring(L, value.data(), value.size());
-            else if constexpr (std::is_same_v<T, bool>)
+            else if constexpr (std::is_same_v<type, bool>)
                 lua_pushboolean(L, value);
-            else if constexpr (std::is_integral_v<T> || std::is_same_v<T, lua_Integer>)
+            else if constexpr (std::is_integral_v<type> || std::is_same_v<type, lua_Integer>)
                 lua_pushinteger(L, value);
-            else if constexpr (std::is_floating_point_v<T> || std::is_same_v<T, lua_Number>)
+            else if constexpr (std::is_floating_point_v<type> || std::is_same_v<type, lua_Number>)
                 lua_pushnumber(L, value);
-            else if constexpr (std::is_same_v<T, nil_t>)
+            else if constexpr (std::is_same_v<type, nil_t>)
                 lua_pushnil(L);
-            else if constexpr (std::is_base_of_v<unsafe_reference, T> || std::is_base_of_v<safe_reference, T>)
+            else if constexpr (std::is_base_of_v<unsafe_reference, type> || std::is_base_of_v<safe_reference, type>)
                 value.push();
-            else if constexpr (std::is_same_v<T, lua_CFunction>)
+            else if constexpr (detail::is_specialization_of<type, std::optional>::value)
+            {
+                if (value)
+                    push(L, *std::forward<T>(value));
+                else
+                    lua_pushnil(L);
+            }
+            else if constexpr (detail::is_sequence_v<type>)
+            {
+                // Nested containers use two slots per level.
+                detail::reserve_stack(L, 2);
+                lua_createtable(L, static_cast<int>(value.size()), 0);
+                lua_Integer key = 1;
+                for (auto &&element : value)
+                {
+                    detail::push_element<T>(L, element);
+                    lua_rawseti(L, -2, key++);
+                }
+            }
+            else if constexpr (detail::is_associative_v<type>)
+            {
+                detail::reserve_stack(L, 3);
+                lua_createtable(L, 0, static_cast<int>(value.size()));
+                for (auto &&element : value)
+                {
+                    push(L, static_cast<const typename type::key_type &>(element.first));
+                    detail::push_element<T>(L, element.second);
+                    lua_rawset(L, -3);
+                }
+            }
+            else if constexpr (detail::is_product_v<type>)
+            {
+                detail::reserve_stack(L, 2);
+                lua_createtable(L, static_cast<int>(std::tuple_size_v<type>), 0);
+                std::apply([L](auto &&...elements)
+                           {
+                               lua_Integer key = 0;
+                               ((push(L, std::forward<decltype(elements)>(elements)), lua_rawseti(L, -2, ++key)), ...); },
+                           std::forward<T>(value));
+            }
+            else if constexpr (std::is_same_v<type, lua_CFunction> || std::is_convertible_v<type, lua_CFunction>)
                 lua_pushcfunction(L, value);
+            else if constexpr (detail::is_object_pointer_v<type>)
+                detail::push_object_pointer(L, const_cast<std::remove_cv_t<std::remove_pointer_t<type>> *>(value));
+            else if constexpr (detail::is_native_function<type>::value)
+                detail::push_native_function<type>(L, std::forward<T>(value));
+            else if constexpr (detail::is_usertype_v<type>)
+                detail::push_object<type>(L, std::forward<T>(value));
             else
                 static_assert(!sizeof(T *), "Unsupported type");
         }
 
         template <typename Arg, typename... Args>
-        void push(lua_State *L, Arg arg, Args... args)
+        void push(lua_State *L, Arg &&arg, Args &&...args)
         {
-            push(L, arg);
-            push(L, args...);
+            detail::reserve_stack(L, 1 + static_cast<int>(sizeof...(Args)));
+            push(L, std::forward<Arg>(arg));
+            (push(L, std::forward<Args>(args)), ...);
         }
 
         /**
@@ -151,6 +568,367 @@ namespace easylua
             return lua_gettop(L);
         }
     } // namespace stack
+
+    namespace detail
+    {
+        template <typename R, typename... Args>
+        struct function_traits<R(Args...)>
+        {
+            using class_type = void;
+            using return_type = R;
+            using argument_types = std::tuple<Args...>;
+        };
+
+        template <typename R, typename... Args>
+        struct function_traits<R(Args...) noexcept> : function_traits<R(Args...)>
+        {
+        };
+
+        template <typename R, typename... Args>
+        struct function_traits<R (*)(Args...)> : function_traits<R(Args...)>
+        {
+        };
+
+        template <typename R, typename... Args>
+        struct function_traits<R (*)(Args...) noexcept> : function_traits<R(Args...)>
+        {
+        };
+
+#define EASYLUA_MEMBER_FUNCTION_TRAITS(qualifiers)                      \
+    template <typename R, typename C, typename... Args>                 \
+    struct function_traits<R (C::*)(Args...) qualifiers>                \
+        : function_traits<R(Args...)>                                   \
+    {                                                                   \
+        using class_type = C;                                           \
+    };                                                                  \
+    template <typename R, typename C, typename... Args>                 \
+    struct function_traits<R (C::*)(Args...) qualifiers noexcept>       \
+        : function_traits<R(Args...)>                                   \
+    {                                                                   \
+        using class_type = C;                                           \
+    };
+
+        EASYLUA_MEMBER_FUNCTION_TRAITS()
+        EASYLUA_MEMBER_FUNCTION_TRAITS(const)
+        EASYLUA_MEMBER_FUNCTION_TRAITS(&)
+        EASYLUA_MEMBER_FUNCTION_TRAITS(const &)
+
+#undef EASYLUA_MEMBER_FUNCTION_TRAITS
+
+        /// @brief Traits of a callable object are the traits of its call operator, without the class.
+        template <typename F>
+        struct function_traits<F, std::void_t<decltype(&F::operator())>> : function_traits<decltype(&F::operator())>
+        {
+            using class_type = void;
+        };
+
+        /// @brief The alignment that Lua guarantees for the memory of a full userdata.
+        static constexpr std::size_t userdata_alignment = alignof(void *) < alignof(lua_Number) ? alignof(lua_Number) : alignof(void *);
+
+        /// @brief Returns a unique key per type, used to store per-type data such as metatables in the registry.
+        template <typename T>
+        const void *type_key()
+        {
+            static const char key = 0;
+            return &key;
+        }
+
+        template <typename T>
+        int destroy_userdata(lua_State *L)
+        {
+            static_cast<T *>(lua_touserdata(L, 1))->~T();
+            return 0;
+        }
+
+        /**
+         * @brief Describes how an argument of a bound function is read from the stack. Arguments are copied into a local value, except for
+         * references to usertypes which refer to the object in the userdata.
+         */
+        template <typename Arg, typename = void>
+        struct argument
+        {
+            using storage_type = std::decay_t<Arg>;
+
+            static storage_type &unwrap(storage_type &value) { return value; }
+        };
+
+        template <typename Arg>
+        struct argument<Arg, std::enable_if_t<std::is_lvalue_reference_v<Arg> && is_usertype_v<std::remove_cv_t<std::remove_reference_t<Arg>>>>>
+        {
+            using storage_type = std::remove_reference_t<Arg> *;
+
+            static std::remove_reference_t<Arg> &unwrap(storage_type value)
+            {
+                if (!value)
+                    throw invalid_argument("object", "cannot be null");
+
+                return *value;
+            }
+        };
+
+        /**
+         * @brief Calls a bound function with arguments read from the Lua stack and pushes its results.
+         *
+         * @return int The number of results pushed onto the stack.
+         */
+        template <typename F, std::size_t... I>
+        int invoke_native_function(lua_State *L, F &function, std::index_sequence<I...>)
+        {
+            using traits = function_traits<F>;
+            using class_type = typename traits::class_type;
+            using return_type = typename traits::return_type;
+            using arguments = typename traits::argument_types;
+            using storage = std::tuple<typename argument<std::tuple_element_t<I, arguments>>::storage_type...>;
+
+            // Member functions take the object as the first argument.
+            constexpr int first = std::is_void_v<class_type> ? 1 : 2;
+
+            // Braced initialization reads the arguments from left to right.
+            storage values{stack::get<std::tuple_element_t<I, storage>>(L, first + static_cast<int>(I))...};
+
+            const auto call = [&]() -> decltype(auto)
+            {
+                if constexpr (std::is_void_v<class_type>)
+                    return function(argument<std::tuple_element_t<I, arguments>>::unwrap(std::get<I>(values))...);
+                else
+                {
+                    class_type *self = stack::get<class_type *>(L, 1);
+                    if (!self)
+                        throw invalid_argument("self", "cannot be null");
+
+                    return (self->*function)(argument<std::tuple_element_t<I, arguments>>::unwrap(std::get<I>(values))...);
+                }
+            };
+
+            if constexpr (std::is_void_v<return_type>)
+            {
+                call();
+                return 0;
+            }
+            else if constexpr (yield_traits<std::decay_t<return_type>>::yields)
+            {
+                return yield_traits<std::decay_t<return_type>>::push(L, call());
+            }
+            else if constexpr (is_tuple<std::decay_t<return_type>>::value)
+            {
+                std::apply([L](auto &&...results)
+                           { (stack::push(L, std::forward<decltype(results)>(results)), ...); },
+                           call());
+                return static_cast<int>(std::tuple_size_v<std::decay_t<return_type>>);
+            }
+            else
+            {
+                stack::push(L, call());
+                return 1;
+            }
+        }
+
+        /**
+         * @brief lua_CFunction that calls the bound function stored in its first upvalue. C++ exceptions are converted into Lua errors, which
+         * are raised only after all C++ objects of the call have been destroyed.
+         */
+        template <typename F>
+        int native_function_entry(lua_State *L)
+        {
+            int results = -1;
+            char message[256];
+            {
+                try
+                {
+                    F &function = *static_cast<F *>(lua_touserdata(L, lua_upvalueindex(1)));
+                    results = invoke_native_function(L, function, std::make_index_sequence<std::tuple_size_v<typename function_traits<F>::argument_types>>());
+                }
+                catch (const std::exception &e)
+                {
+                    std::strncpy(message, e.what(), sizeof(message) - 1);
+                    message[sizeof(message) - 1] = '\0';
+                }
+                catch (...)
+                {
+                    std::strncpy(message, "unknown C++ exception", sizeof(message));
+                }
+            }
+
+            // Yielding, like raising an error, does not return, so it is only done once no C++ objects are left.
+            if (results >= 0)
+            {
+                if constexpr (yield_traits<std::decay_t<typename function_traits<F>::return_type>>::yields)
+                    return lua_yield(L, results);
+                else
+                    return results;
+            }
+
+            lua_pushstring(L, message);
+            return lua_error(L);
+        }
+
+        /**
+         * @brief Pushes a C++ function, member function or callable object as a Lua function. The callable is stored in a userdata upvalue,
+         * so pushing allocates once but calling does not allocate. Member functions take the object as the first argument.
+         */
+        template <typename F, typename U>
+        void push_native_function(lua_State *L, U &&function)
+        {
+            static_assert(alignof(F) <= userdata_alignment, "Callable is over-aligned for a Lua userdata");
+
+            void *memory = lua_newuserdatauv(L, sizeof(F), 0);
+            new (memory) F(std::forward<U>(function));
+
+            if constexpr (!std::is_trivially_destructible_v<F>)
+            {
+                if (lua_rawgetp(L, LUA_REGISTRYINDEX, type_key<F>()) == LUA_TNIL)
+                {
+                    lua_pop(L, 1);
+                    lua_createtable(L, 0, 1);
+                    lua_pushcfunction(L, &destroy_userdata<F>);
+                    lua_setfield(L, -2, "__gc");
+                    lua_pushvalue(L, -1);
+                    lua_rawsetp(L, LUA_REGISTRYINDEX, type_key<F>());
+                }
+
+                lua_setmetatable(L, -2);
+            }
+
+            lua_pushcclosure(L, &native_function_entry<F>, 1);
+        }
+
+        /**
+         * @brief Pushes the metatable of a usertype, creating it with default contents if the type has not been used in this state yet.
+         * Objects stored in place and pointers to objects have separate metatables that share their methods, which is how to_object tells
+         * them apart.
+         *
+         * @param pointer Whether to push the metatable for pointers rather than for objects stored in place.
+         */
+        template <typename T>
+        void push_metatable(lua_State *L, bool pointer)
+        {
+            const void *key = pointer ? type_key<T *>() : type_key<T>();
+            if (lua_rawgetp(L, LUA_REGISTRYINDEX, key) != LUA_TNIL)
+                return;
+
+            lua_pop(L, 1);
+            lua_newtable(L); // methods
+
+            for (const bool is_pointer : {false, true})
+            {
+                lua_createtable(L, 0, 3);
+                lua_pushvalue(L, -2);
+                lua_setfield(L, -2, "__index");
+                lua_pushvalue(L, -2);
+                lua_setfield(L, -2, "__methods");
+
+                if constexpr (!std::is_trivially_destructible_v<T>)
+                {
+                    if (!is_pointer)
+                    {
+                        lua_pushcfunction(L, &destroy_userdata<T>);
+                        lua_setfield(L, -2, "__gc");
+                    }
+                }
+
+                lua_rawsetp(L, LUA_REGISTRYINDEX, is_pointer ? type_key<T *>() : type_key<T>());
+            }
+
+            lua_pop(L, 1);
+            lua_rawgetp(L, LUA_REGISTRYINDEX, key);
+        }
+
+        /**
+         * @brief Returns the object of type T in the userdata at the given index, whether it is stored in place or as a pointer.
+         *
+         * @return T* The object, or null if the value is not a userdata of type T.
+         */
+        template <typename T>
+        T *to_object(lua_State *L, int index)
+        {
+            void *userdata = lua_touserdata(L, index);
+            if (!userdata || lua_type(L, index) != LUA_TUSERDATA || !lua_getmetatable(L, index))
+                return nullptr;
+
+            T *object = nullptr;
+            lua_rawgetp(L, LUA_REGISTRYINDEX, type_key<T>());
+            if (lua_rawequal(L, -1, -2))
+                object = static_cast<T *>(userdata);
+            else
+            {
+                lua_pop(L, 1);
+                lua_rawgetp(L, LUA_REGISTRYINDEX, type_key<T *>());
+                if (lua_rawequal(L, -1, -2))
+                    object = *static_cast<T **>(userdata);
+            }
+
+            lua_pop(L, 2);
+            return object;
+        }
+
+        /// @brief Pushes an object as a full userdata that holds the object in place.
+        template <typename T, typename U>
+        void push_object(lua_State *L, U &&object)
+        {
+            static_assert(alignof(T) <= userdata_alignment, "Type is over-aligned for a Lua userdata");
+
+            void *memory = lua_newuserdatauv(L, sizeof(T), 0);
+            new (memory) T(std::forward<U>(object));
+            push_metatable<T>(L, false);
+            lua_setmetatable(L, -2);
+        }
+
+        /**
+         * @brief Pushes a pointer to an object as a full userdata with the pointer metatable of T, so that it can only be read back as a T
+         * and its methods can be called from Lua if T is registered as a usertype. A null pointer is pushed as nil. The object is not owned
+         * by Lua and must outlive all uses.
+         */
+        template <typename T>
+        void push_object_pointer(lua_State *L, T *object)
+        {
+            if (!object)
+            {
+                lua_pushnil(L);
+                return;
+            }
+
+            *static_cast<T **>(lua_newuserdatauv(L, sizeof(T *), 0)) = object;
+            push_metatable<T>(L, true);
+            lua_setmetatable(L, -2);
+        }
+
+        /// @brief Reads table[key] for the table at the given absolute index, without calling metamethods.
+        template <typename E>
+        E get_element(lua_State *L, int table, lua_Integer key)
+        {
+            const stack_guard guard(L);
+            lua_rawgeti(L, table, key);
+            return stack::get<E>(L, -1);
+        }
+
+        template <typename T, std::size_t... I>
+        T get_elements(lua_State *L, int table, std::index_sequence<I...>)
+        {
+            // Braced initialization reads the elements from left to right.
+            return T{get_element<std::tuple_element_t<I, T>>(L, table, static_cast<lua_Integer>(I + 1))...};
+        }
+
+        /// @brief Pushes an element of a container, moving it if the container is an rvalue that owns its elements.
+        template <typename Container, typename Element>
+        void push_element(lua_State *L, Element &element)
+        {
+            if constexpr (std::is_same_v<std::decay_t<Container>, std::vector<bool>>)
+                lua_pushboolean(L, static_cast<bool>(element));
+            else if constexpr (std::is_lvalue_reference_v<Container> || is_span<std::decay_t<Container>>::value)
+                stack::push(L, static_cast<const Element &>(element));
+            else
+                stack::push(L, std::move(element));
+        }
+
+        template <typename... T>
+        int yield_traits<yield<T...>>::push(lua_State *L, yield<T...> &&value)
+        {
+            std::apply([L](auto &&...values)
+                       { (stack::push(L, std::move(values)), ...); },
+                       value.get_values());
+            return static_cast<int>(sizeof...(T));
+        }
+    } // namespace detail
 } // namespace easylua
 
 #endif
\ No newline at end of file
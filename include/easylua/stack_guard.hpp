@@ -0,0 +1,219 @@
+#ifndef __EASYLUA_STACK_GUARD_H
+#define __EASYLUA_STACK_GUARD_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdio>
+#include <exception>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+
+/**
+ * @brief Set to 1 to enable the stack leak checks of EASYLUA_STACK_CHECK, or to 0 to disable them. By default they are enabled unless
+ * NDEBUG is defined.
+ */
+#ifndef EASYLUA_STACK_CHECKS
+#ifdef NDEBUG
+#define EASYLUA_STACK_CHECKS 0
+#else
+#define EASYLUA_STACK_CHECKS 1
+#endif
+#endif
+
+namespace easylua
+{
+    /**
+     * @brief Restores the top of the stack when it goes out of scope, also when an exception is thrown. Values that were pushed in the
+     * scope are popped.
+     *
+     * Usage:
+     *                      {
+     *                          stack_guard guard(L);
+     *                          lua_getglobal(L, "config");
+     *                          read_config(L);
+     *                      }
+     */
+    class stack_guard
+    {
+    public:
+        explicit stack_guard(lua_State *state) : lua_state_(state), top_(lua_gettop(state)) {}
+
+        /// @brief Construct a new stack_guard object that restores the given top, which may be below the current one.
+        stack_guard(lua_State *state, int top) : lua_state_(state), top_(top) {}
+        ~stack_guard() { lua_settop(lua_state_, top_); }
+
+        stack_guard(const stack_guard &other) = delete;
+        stack_guard &operator=(const stack_guard &other) = delete;
+
+        /// @brief Returns the top that is restored.
+        int get_top() const { return top_; }
+
+    private:
+        lua_State *lua_state_;
+        int top_;
+    };
+
+    /**
+     * @brief A location in the source code, like std::source_location in C++20. Library functions that check the stack take it as a
+     * default argument, so that a leak they find is reported at the code that called them.
+     */
+    struct source_location
+    {
+        /// @brief Returns the location of the caller when used as a default argument.
+        static constexpr source_location current(const char *file = __builtin_FILE(), int line = __builtin_LINE(),
+                                                 const char *function = __builtin_FUNCTION())
+        {
+            return source_location{file, line, function};
+        }
+
+        const char *file;
+        int line;
+        const char *function;
+    };
+
+    /// @brief Describes a scope that did not leave the stack as it should have.
+    struct stack_leak
+    {
+        const char *file;
+        int line;
+        const char *function;
+        /// @brief The top the scope should have left.
+        int expected_top;
+        /// @brief The top the scope actually left.
+        int actual_top;
+    };
+
+    using stack_leak_handler = void (*)(const stack_leak &leak);
+
+    namespace detail
+    {
+        inline void report_stack_leak(const stack_leak &leak)
+        {
+            std::fprintf(stderr, "easylua: stack leak in %s at %s:%d: expected top %d, got %d\n", leak.function, leak.file, leak.line,
+                         leak.expected_top, leak.actual_top);
+            assert(!"stack leak");
+        }
+
+        inline std::atomic<stack_leak_handler> &leak_handler()
+        {
+            static std::atomic<stack_leak_handler> handler{&report_stack_leak};
+            return handler;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Sets the function that is called when a stack_check finds a leak. The default handler prints the leak to stderr and asserts.
+     *
+     * @param handler The new handler, or null to restore the default handler.
+     * @return stack_leak_handler The previous handler.
+     */
+    inline stack_leak_handler set_stack_leak_handler(stack_leak_handler handler)
+    {
+        return detail::leak_handler().exchange(handler ? handler : &detail::report_stack_leak);
+    }
+
+    /**
+     * @brief Checks that the stack has grown by exactly the expected number of values when it goes out of scope, and reports a leak to the
+     * stack leak handler otherwise. Unlike stack_guard it does not change the stack. It is usually created through EASYLUA_STACK_CHECK,
+     * which records the call site and compiles to nothing when the checks are disabled.
+     */
+    class stack_check
+    {
+    public:
+        stack_check(lua_State *state, int expected_growth, const char *file, int line, const char *function)
+            : lua_state_(state), expected_top_(lua_gettop(state) + expected_growth), file_(file), line_(line), function_(function)
+        {
+        }
+
+        stack_check(lua_State *state, int expected_growth, const source_location &location)
+            : stack_check(state, expected_growth, location.file, location.line, location.function)
+        {
+        }
+
+        ~stack_check()
+        {
+            // An exception leaves the stack in whatever state it was in when it was thrown.
+            if (std::uncaught_exceptions() > uncaught_exceptions_)
+                return;
+
+            const int top = lua_gettop(lua_state_);
+            if (top != expected_top_)
+                detail::leak_handler().load()(stack_leak{file_, line_, function_, expected_top_, top});
+        }
+
+        stack_check(const stack_check &other) = delete;
+        stack_check &operator=(const stack_check &other) = delete;
+
+    private:
+        lua_State *lua_state_;
+        int expected_top_;
+        const char *file_;
+        int line_;
+        const char *function_;
+        int uncaught_exceptions_ = std::uncaught_exceptions();
+    };
+
+    namespace detail
+    {
+        /**
+         * @brief Makes sure that the stack has room for count more values.
+         *
+         * @throw runtime_error If the stack cannot grow that much.
+         */
+        inline void reserve_stack(lua_State *L, int count)
+        {
+            if (!lua_checkstack(L, count))
+                throw runtime_error("stack overflow");
+        }
+    } // namespace detail
+} // namespace easylua
+
+#define EASYLUA_STACK_CHECK_CONCAT_(a, b) a##b
+#define EASYLUA_STACK_CHECK_NAME_(line) EASYLUA_STACK_CHECK_CONCAT_(easylua_stack_check_, line)
+
+/**
+ * @brief Checks that the enclosing scope leaves the stack of L grown by the given number of values (0 if omitted), and reports the file,
+ * line and function of the check otherwise.
+ *
+ * The library checks the wrapper paths that do not restore the stack with a stack_guard: assigning globals, typed calls through function
+ * references, table::size and pushing the arguments of a coroutine. global::set and table::size take a source_location and report a leak
+ * at the code that called them. Operators and functions with variadic arguments cannot take a default argument after them, so
+ * lua["name"] = value, call(), try_call() and resume() report the check inside the library header; the function name, or a check in your
+ * own function around the call, locates the caller.
+ *
+ * Usage:
+ *                      void update(lua_State *L)
+ *                      {
+ *                          EASYLUA_STACK_CHECK(L);
+ *                          ...
+ *                      }
+ */
+#if EASYLUA_STACK_CHECKS
+#define EASYLUA_STACK_CHECK_2_(L, growth) const ::easylua::stack_check EASYLUA_STACK_CHECK_NAME_(__LINE__)((L), (growth), __FILE__, __LINE__, __func__)
+#else
+#define EASYLUA_STACK_CHECK_2_(L, growth) static_cast<void>(0)
+#endif
+
+/**
+ * @brief Like EASYLUA_STACK_CHECK, but reports a leak at the given source_location, which is usually a default argument of the enclosing
+ * function.
+ *
+ * Usage:
+ *                      void update(lua_State *L, easylua::source_location location = easylua::source_location::current())
+ *                      {
+ *                          EASYLUA_STACK_CHECK_AT(L, 0, location);
+ *                          ...
+ *                      }
+ */
+#if EASYLUA_STACK_CHECKS
+#define EASYLUA_STACK_CHECK_AT(L, growth, location) const ::easylua::stack_check EASYLUA_STACK_CHECK_NAME_(__LINE__)((L), (growth), (location))
+#else
+#define EASYLUA_STACK_CHECK_AT(L, growth, location) static_cast<void>(location)
+#endif
+#define EASYLUA_STACK_CHECK_1_(L) EASYLUA_STACK_CHECK_2_(L, 0)
+#define EASYLUA_STACK_CHECK_SELECT_(_1, _2, macro, ...) macro
+#define EASYLUA_STACK_CHECK(...) EASYLUA_STACK_CHECK_SELECT_(__VA_ARGS__, EASYLUA_STACK_CHECK_2_, EASYLUA_STACK_CHECK_1_, )(__VA_ARGS__)
+
+#endif
@@ -1,8 +1,12 @@
 #ifndef __EASYLUA_STATE_H
 #define __EASYLUA_STATE_H
 
+#include <memory>
+#include <type_traits>
+
 #include <lua.hpp>
 
+#include "allocator.hpp"
 #include "state_view.hpp"
 
 namespace easylua
@@ -15,6 +19,33 @@ namespace easylua
             // TODO set panic?
         }
 
+        /**
+         * @brief Construct a new state and open the given standard libraries.
+         *
+         * Usage:
+         *                      state sandbox(library::base | library::string | library::math, library_mode::lazy);
+         *
+         * @param libraries The libraries to open.
+         * @param mode Whether to build the libraries now or the first time they are used.
+         */
+        explicit state(library libraries, library_mode mode = library_mode::eager) : state()
+        {
+            open_libraries(libraries, mode);
+        }
+
+        /**
+         * @brief Construct a new state that allocates all of its memory through the given allocator.
+         *
+         * @tparam Allocator The type of the allocator. The allocator is called through this type, so declaring it final avoids a virtual call
+         * for every allocation.
+         * @param allocator The allocator. The state takes ownership of it and destroys it after the Lua state is closed.
+         * @throw invalid_argument If allocator is null or if the Lua state could not be created.
+         */
+        template <typename Allocator, typename std::enable_if_t<std::is_base_of_v<easylua::allocator, Allocator>, bool> = true>
+        explicit state(std::unique_ptr<Allocator> allocator) : state_view(new_state(allocator.get())), allocator_(std::move(allocator))
+        {
+        }
+
         ~state()
         {
             if (lua_state_)
@@ -26,7 +57,7 @@ namespace easylua
         state(const state &other) = delete;
         state &operator=(const state &other) = delete;
 
-        state(state &&other) : state_view(other.lua_state_)
+        state(state &&other) : state_view(other.lua_state_), allocator_(std::move(other.allocator_))
         {
             other.lua_state_ = nullptr;
         }
@@ -34,9 +65,29 @@ namespace easylua
         state &operator=(state &&other)
         {
             std::swap(lua_state_, other.lua_state_);
+            std::swap(allocator_, other.allocator_);
             return *this;
         }
+
+        /// @brief Returns the allocator of this state, or null if the state uses the default allocator of luaL_newstate.
+        easylua::allocator *get_allocator() const { return allocator_.get(); }
+
+        /// @brief Returns the allocator of this state if it is of type Allocator, or null otherwise.
+        template <typename Allocator>
+        Allocator *get_allocator() const { return dynamic_cast<Allocator *>(allocator_.get()); }
+
+    private:
+        template <typename Allocator>
+        static lua_State *new_state(Allocator *allocator)
+        {
+            if (!allocator)
+                throw invalid_argument("allocator", "cannot be null");
+
+            return lua_newstate(&detail::allocate<Allocator>, allocator);
+        }
+
+        std::unique_ptr<easylua::allocator> allocator_;
     };
 } // namespace easylua
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,395 @@
+#ifndef __EASYLUA_STATE_POOL_H
+#define __EASYLUA_STATE_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+#include "state.hpp"
+
+namespace easylua
+{
+    /**
+     * @brief A fixed set of states that are created up front and shared between threads.
+     *
+     * Every state is built once by a setup function, which typically opens libraries and runs scripts. A thread borrows a state through a
+     * lease, which returns the state to the pool when it is destroyed. Only one thread uses a state at a time.
+     *
+     * Claiming a free state is lock-free: each thread starts searching at a slot derived from its id, so a thread tends to get the same
+     * state back and threads rarely contend for the same slot. A mutex and condition variable are only used when the pool is exhausted.
+     *
+     * Usage:
+     *                      state_pool pool(8, [&](state &lua) { luaL_openlibs(lua); lua.run(rules); });
+     *                      {
+     *                          auto lease = pool.acquire();
+     *                          lease->run("score(request)");
+     *                      }
+     */
+    class state_pool
+    {
+    public:
+        /// @brief What happens to a state when its lease is returned.
+        enum class reset_mode
+        {
+            /// @brief The state is returned as it is.
+            none,
+            /// @brief The stack is cleared and a full garbage collection cycle is run.
+            collect_garbage,
+            /// @brief The stack is cleared and every global is set back to the value it had after setup. This is a shallow reset: changes
+            /// inside tables that existed after setup, such as a modified field of a library table, are kept.
+            restore_globals
+        };
+
+        /// @brief Counters of a pool. They are updated with relaxed atomics and are meant for monitoring.
+        struct metrics
+        {
+            /// @brief The number of leases handed out.
+            std::uint64_t acquisitions = 0;
+            /// @brief The number of acquisitions that found no free state, and either waited or failed.
+            std::uint64_t exhaustions = 0;
+            /// @brief The number of timed or non-blocking acquisitions that failed.
+            std::uint64_t failures = 0;
+            /// @brief The total time spent waiting for a free state.
+            std::chrono::nanoseconds total_wait{0};
+            /// @brief The longest time a single acquisition waited for a free state.
+            std::chrono::nanoseconds max_wait{0};
+        };
+
+        using setup_function = std::function<void(state &)>;
+
+        /**
+         * @brief A state borrowed from a pool. The state is returned to the pool when the lease is destroyed.
+         */
+        class lease
+        {
+        public:
+            ~lease() { release(); }
+
+            lease(const lease &other) = delete;
+            lease &operator=(const lease &other) = delete;
+
+            lease(lease &&other) : pool_(other.pool_), slot_(other.slot_)
+            {
+                other.pool_ = nullptr;
+            }
+
+            lease &operator=(lease &&other)
+            {
+                if (this != &other)
+                {
+                    release();
+                    pool_ = other.pool_;
+                    slot_ = other.slot_;
+                    other.pool_ = nullptr;
+                }
+
+                return *this;
+            }
+
+            state &get() const { return pool_->slots_[slot_]->lua; }
+            state &operator*() const { return get(); }
+            state *operator->() const { return &get(); }
+
+            operator lua_State *() const { return get().get_state(); }
+
+        private:
+            friend class state_pool;
+
+            lease(state_pool *pool, std::size_t slot) : pool_(pool), slot_(slot) {}
+
+            void release()
+            {
+                if (pool_)
+                    pool_->release(slot_);
+
+                pool_ = nullptr;
+            }
+
+            state_pool *pool_;
+            std::size_t slot_;
+        };
+
+        /**
+         * @brief Construct a new state_pool object and build all of its states.
+         *
+         * @param size The number of states.
+         * @param setup Called once for every state, from the constructing thread. An exception thrown by it is passed on to the caller.
+         * @param mode What happens to a state when its lease is returned.
+         * @throw invalid_argument If size is 0.
+         */
+        state_pool(std::size_t size, const setup_function &setup, reset_mode mode = reset_mode::none) : mode_(mode)
+        {
+            if (size == 0)
+                throw invalid_argument("size", "cannot be 0");
+
+            slots_.reserve(size);
+            for (std::size_t i = 0; i < size; i++)
+            {
+                auto slot = std::make_unique<state_slot>();
+                if (setup)
+                    setup(slot->lua);
+
+                lua_settop(slot->lua, 0);
+                if (mode_ == reset_mode::restore_globals)
+                    slot->globals = snapshot_globals(slot->lua);
+
+                slots_.push_back(std::move(slot));
+            }
+
+            available_.store(size, std::memory_order_relaxed);
+        }
+
+        /// @brief All leases must have been returned before the pool is destroyed.
+        ~state_pool() = default;
+
+        state_pool(const state_pool &other) = delete;
+        state_pool &operator=(const state_pool &other) = delete;
+
+        /**
+         * @brief Borrows a state, waiting until one is free.
+         */
+        lease acquire()
+        {
+            if (const auto slot = try_claim())
+                return lease(this, *slot);
+
+            return wait_for_slot(std::nullopt).value();
+        }
+
+        /**
+         * @brief Borrows a state if one is free.
+         *
+         * @return std::optional<lease> The lease, or nothing if all states are in use.
+         */
+        std::optional<lease> try_acquire()
+        {
+            if (const auto slot = try_claim())
+                return lease(this, *slot);
+
+            exhaustions_.fetch_add(1, std::memory_order_relaxed);
+            failures_.fetch_add(1, std::memory_order_relaxed);
+            return std::nullopt;
+        }
+
+        /**
+         * @brief Borrows a state, waiting at most the given time for one to become free.
+         *
+         * @return std::optional<lease> The lease, or nothing if no state became free in time.
+         */
+        template <typename Rep, typename Period>
+        std::optional<lease> try_acquire_for(std::chrono::duration<Rep, Period> timeout)
+        {
+            if (const auto slot = try_claim())
+                return lease(this, *slot);
+
+            return wait_for_slot(std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout));
+        }
+
+        /// @brief Returns the number of states in the pool.
+        std::size_t size() const { return slots_.size(); }
+
+        /// @brief Returns the number of states that are not leased. The value may be outdated by the time it is used.
+        std::size_t available() const { return available_.load(std::memory_order_relaxed); }
+
+        metrics get_metrics() const
+        {
+            metrics result;
+            result.acquisitions = acquisitions_.load(std::memory_order_relaxed);
+            result.exhaustions = exhaustions_.load(std::memory_order_relaxed);
+            result.failures = failures_.load(std::memory_order_relaxed);
+            result.total_wait = std::chrono::nanoseconds(total_wait_.load(std::memory_order_relaxed));
+            result.max_wait = std::chrono::nanoseconds(max_wait_.load(std::memory_order_relaxed));
+            return result;
+        }
+
+    private:
+        // Each slot is on its own cache line so that claiming one does not slow down threads that use its neighbours.
+        struct alignas(64) state_slot
+        {
+            state lua;
+            std::atomic<bool> busy{false};
+            int globals = LUA_NOREF;
+        };
+
+        /// @brief Copies the global table into a table in the registry and returns its reference.
+        static int snapshot_globals(lua_State *L)
+        {
+            lua_newtable(L);
+            lua_pushglobaltable(L);
+            lua_pushnil(L);
+            while (lua_next(L, -2) != 0)
+            {
+                lua_pushvalue(L, -2);
+                lua_insert(L, -2);
+                lua_rawset(L, -5);
+            }
+
+            lua_pop(L, 1);
+            return luaL_ref(L, LUA_REGISTRYINDEX);
+        }
+
+        /// @brief Sets every global back to its value in the snapshot, and removes globals that are not in it.
+        static void restore_globals(lua_State *L, int snapshot)
+        {
+            lua_rawgeti(L, LUA_REGISTRYINDEX, snapshot);
+            lua_pushglobaltable(L);
+
+            // Assigning to fields that already exist is allowed while traversing a table with lua_next.
+            lua_pushnil(L);
+            while (lua_next(L, -2) != 0)
+            {
+                lua_pushvalue(L, -2);
+                lua_rawget(L, -5);
+                if (!lua_rawequal(L, -1, -2))
+                {
+                    lua_pushvalue(L, -3);
+                    lua_insert(L, -2);
+                    lua_rawset(L, -5);
+                    lua_pop(L, 1);
+                }
+                else
+                    lua_pop(L, 2);
+            }
+
+            // Globals that were removed or set to nil.
+            lua_pushnil(L);
+            while (lua_next(L, -3) != 0)
+            {
+                lua_pushvalue(L, -2);
+                if (lua_rawget(L, -4) == LUA_TNIL)
+                {
+                    lua_pop(L, 1);
+                    lua_pushvalue(L, -2);
+                    lua_insert(L, -2);
+                    lua_rawset(L, -4);
+                }
+                else
+                    lua_pop(L, 2);
+            }
+
+            lua_pop(L, 2);
+        }
+
+        /// @brief The first slot that this thread tries, so that a thread tends to reuse the same state.
+        std::size_t preferred_slot() const
+        {
+            static thread_local const std::size_t thread_hash = std::hash<std::thread::id>()(std::this_thread::get_id());
+            return thread_hash % slots_.size();
+        }
+
+        std::optional<std::size_t> try_claim()
+        {
+            const std::size_t size = slots_.size();
+            const std::size_t first = preferred_slot();
+            for (std::size_t i = 0; i < size; i++)
+            {
+                const std::size_t slot = (first + i) % size;
+                bool expected = false;
+                if (!slots_[slot]->busy.load() && slots_[slot]->busy.compare_exchange_strong(expected, true))
+                {
+                    available_.fetch_sub(1, std::memory_order_relaxed);
+                    acquisitions_.fetch_add(1, std::memory_order_relaxed);
+                    return slot;
+                }
+            }
+
+            return std::nullopt;
+        }
+
+        std::optional<lease> wait_for_slot(std::optional<std::chrono::steady_clock::time_point> deadline)
+        {
+            exhaustions_.fetch_add(1, std::memory_order_relaxed);
+            const auto start = std::chrono::steady_clock::now();
+
+            std::optional<std::size_t> slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                waiters_++;
+                while (!(slot = try_claim()))
+                {
+                    if (!deadline)
+                        released_.wait(lock);
+                    else if (released_.wait_until(lock, *deadline) == std::cv_status::timeout)
+                    {
+                        slot = try_claim();
+                        break;
+                    }
+                }
+                waiters_--;
+            }
+
+            record_wait(std::chrono::steady_clock::now() - start);
+
+            if (!slot)
+            {
+                failures_.fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+
+            return lease(this, *slot);
+        }
+
+        void record_wait(std::chrono::steady_clock::duration duration)
+        {
+            const auto wait = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+            total_wait_.fetch_add(wait, std::memory_order_relaxed);
+
+            std::uint64_t max = max_wait_.load(std::memory_order_relaxed);
+            while (wait > max && !max_wait_.compare_exchange_weak(max, wait, std::memory_order_relaxed))
+            {
+            }
+        }
+
+        void release(std::size_t slot)
+        {
+            state_slot &released = *slots_[slot];
+            lua_State *L = released.lua;
+            lua_settop(L, 0);
+
+            if (mode_ == reset_mode::collect_garbage)
+                lua_gc(L, LUA_GCCOLLECT, 0);
+            else if (mode_ == reset_mode::restore_globals)
+                restore_globals(L, released.globals);
+
+            available_.fetch_add(1, std::memory_order_relaxed);
+            released.busy.store(false);
+
+            // A waiter registers itself before it looks for a free slot, so either it sees this slot or this sees the waiter. The lock makes
+            // sure that the waiter is actually waiting before it is notified.
+            if (waiters_.load() > 0)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                released_.notify_one();
+            }
+        }
+
+        std::vector<std::unique_ptr<state_slot>> slots_;
+        reset_mode mode_;
+        std::atomic<std::size_t> available_{0};
+
+        std::mutex mutex_;
+        std::condition_variable released_;
+        std::atomic<std::size_t> waiters_{0};
+
+        std::atomic<std::uint64_t> acquisitions_{0};
+        std::atomic<std::uint64_t> exhaustions_{0};
+        std::atomic<std::uint64_t> failures_{0};
+        std::atomic<std::uint64_t> total_wait_{0};
+        std::atomic<std::uint64_t> max_wait_{0};
+    };
+} // namespace easylua
+
+#endif
@@ -1,12 +1,19 @@
 #ifndef __EASYLUA_STATE_VIEW_H
 #define __EASYLUA_STATE_VIEW_H
 
+#include <string>
+#include <type_traits>
+
 #include <lua.hpp>
 
 #include "exception.hpp"
+#include "gc.hpp"
+#include "global.hpp"
+#include "libraries.hpp"
 #include "reference.hpp"
 #include "script.hpp"
 #include "stack.hpp"
+#include "table.hpp"
 
 namespace easylua
 {
@@ -19,22 +26,24 @@ namespace easylua
                 throw invalid_argument("state", "cannot be null");
         }
 
-        state_view(const state_view &other) = delete;
-        state_view(state_view &&other)
-        {
-            std::swap(lua_state_, other.lua_state_);
-        }
-        state_view &operator=(const state_view &other) = delete;
-        state_view &operator=(state_view &&other)
-        {
-            std::swap(lua_state_, other.lua_state_);
-            return *this;
-        }
+        state_view(const state_view &other) = default;
+        state_view(state_view &&other) = default;
+        state_view &operator=(const state_view &other) = default;
+        state_view &operator=(state_view &&other) = default;
 
         lua_State *get_state() const { return lua_state_; }
 
         operator lua_State *() const { return lua_state_; }
 
+        /// @brief Opens the given standard libraries. See easylua::open_libraries.
+        void open_libraries(library libraries, library_mode mode = library_mode::eager)
+        {
+            easylua::open_libraries(lua_state_, libraries, mode);
+        }
+
+        /// @brief Returns a controller for the garbage collector of the state.
+        gc_controller gc() const { return gc_controller(lua_state_); }
+
         script::load_result load(const std::string &code)
         {
             return script::load_string(lua_state_, code);
@@ -55,6 +64,16 @@ namespace easylua
             return script::run_file(lua_state_, filename);
         }
 
+        script::load_result run(const std::string &code, const execution_budget &budget)
+        {
+            return script::run_string(lua_state_, code, budget);
+        }
+
+        script::load_result run_file(const std::string &filename, const execution_budget &budget)
+        {
+            return script::run_file(lua_state_, filename, budget);
+        }
+
         class get_result
         {
         public:
@@ -67,17 +86,32 @@ namespace easylua
             get_result &operator=(const get_result &other) = delete;
             get_result &operator=(get_result &&other) = delete;
 
+            /**
+             * @brief Reads the global. The stack is left unchanged, except for an unsafe reference, which refers to the value that is left
+             * at the top of the stack. As with global::get, a std::string_view or const char * result stays valid only while the global keeps
+             * referring to the same string.
+             */
             template <typename T>
             operator T() const
             {
-                lua_getglobal(lua_state_, name_.c_str());
-                return stack::get<T>(lua_state_, -1);
+                if constexpr (std::is_base_of_v<unsafe_reference, T>)
+                {
+                    lua_getglobal(lua_state_, name_.c_str());
+                    return stack::get<T>(lua_state_, -1);
+                }
+                else
+                {
+                    const stack_guard guard(lua_state_);
+                    lua_getglobal(lua_state_, name_.c_str());
+                    return stack::get<T>(lua_state_, -1);
+                }
             }
 
             template <typename T>
-            void operator=(T value) const
+            void operator=(T &&value) const
             {
-                stack::push<T>(lua_state_, std::forward<T>(value));
+                EASYLUA_STACK_CHECK(lua_state_);
+                stack::push(lua_state_, std::forward<T>(value));
                 lua_setglobal(lua_state_, name_.c_str());
             }
 
@@ -98,6 +132,30 @@ namespace easylua
             return get_result(lua_state_, name);
         }
 
+        /**
+         * @brief Binds a handle to a global variable. Unlike operator[], accessing the global through the handle does not allocate or hash
+         * the name again, which makes it the better choice for globals that are accessed repeatedly.
+         *
+         * @param name The name of the global variable.
+         * @return global The handle.
+         */
+        global get_global(std::string_view name) const
+        {
+            return global(lua_state_, name);
+        }
+
+        /**
+         * @brief Creates a new table, preallocated for the given number of array elements and other keys.
+         *
+         * @param array_size The number of elements that will be stored at keys 1 to n.
+         * @param hash_size The number of other keys that will be stored.
+         * @return safe_table_reference A reference to the table.
+         */
+        safe_table_reference create_table(int array_size = 0, int hash_size = 0) const
+        {
+            return safe_table_reference::create(lua_state_, array_size, hash_size);
+        }
+
     protected:
         lua_State *lua_state_;
     };
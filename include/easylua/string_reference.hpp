@@ -0,0 +1,60 @@
+#ifndef __EASYLUA_STRING_REFERENCE_H
+#define __EASYLUA_STRING_REFERENCE_H
+
+#include <cstddef>
+#include <string_view>
+
+#include <lua.hpp>
+
+#include "reference.hpp"
+
+namespace easylua
+{
+    /**
+     * @brief Represents a Lua string on the stack. The view returned by get() does not copy the string and stays valid while the string
+     * remains in its stack slot.
+     */
+    class unsafe_string_reference : public unsafe_reference
+    {
+    public:
+        unsafe_string_reference(lua_State *state, int index = -1) : unsafe_reference(state, index, LUA_TSTRING)
+        {
+            std::size_t length = 0;
+            const char *data = lua_tolstring(state, index, &length);
+            view_ = std::string_view(data, length);
+        }
+
+        std::string_view get() const { return view_; }
+
+        operator std::string_view() const { return view_; }
+
+    private:
+        std::string_view view_;
+    };
+
+    /**
+     * @brief Holds a Lua string through a reference in the registry. The view returned by get() does not copy the string and stays valid
+     * for the lifetime of the reference, because Lua does not move strings while they are reachable.
+     */
+    class safe_string_reference : public safe_reference
+    {
+    public:
+        safe_string_reference(lua_State *state, int index = -1) : safe_reference(state, index, LUA_TSTRING)
+        {
+            push();
+            std::size_t length = 0;
+            const char *data = lua_tolstring(lua_state_, -1, &length);
+            view_ = std::string_view(data, length);
+            lua_pop(lua_state_, 1);
+        }
+
+        std::string_view get() const { return view_; }
+
+        operator std::string_view() const { return view_; }
+
+    private:
+        std::string_view view_;
+    };
+} // namespace easylua
+
+#endif
@@ -0,0 +1,233 @@
+#ifndef __EASYLUA_TABLE_H
+#define __EASYLUA_TABLE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+#include "reference.hpp"
+#include "stack.hpp"
+
+namespace easylua
+{
+    namespace detail
+    {
+        template <typename K>
+        static constexpr bool is_integer_key_v = std::is_integral_v<std::decay_t<K>> && !std::is_same_v<std::decay_t<K>, bool>;
+
+        template <typename K>
+        static constexpr bool is_string_key_v = std::is_same_v<std::decay_t<K>, const char *> || std::is_same_v<std::decay_t<K>, char *>;
+
+        /// @brief Pushes table[key] for the table at the given absolute index, calling metamethods.
+        template <typename K>
+        void get_field(lua_State *L, int table, K &&key)
+        {
+            if constexpr (is_integer_key_v<K>)
+                lua_geti(L, table, static_cast<lua_Integer>(key));
+            else if constexpr (is_string_key_v<K>)
+                lua_getfield(L, table, key);
+            else
+            {
+                stack::push(L, std::forward<K>(key));
+                lua_gettable(L, table);
+            }
+        }
+
+        /// @brief Sets table[key] to the value at the top of the stack and pops it, calling metamethods.
+        template <typename K>
+        void set_field(lua_State *L, int table, K &&key)
+        {
+            if constexpr (is_integer_key_v<K>)
+                lua_seti(L, table, static_cast<lua_Integer>(key));
+            else if constexpr (is_string_key_v<K>)
+                lua_setfield(L, table, key);
+            else
+            {
+                stack::push(L, std::forward<K>(key));
+                lua_insert(L, -2);
+                lua_settable(L, table);
+            }
+        }
+
+        /**
+         * @brief The table operations shared by unsafe_table_reference and safe_table_reference. Every operation pushes the table, works on
+         * it and restores the stack, so a reference can be used from anywhere.
+         *
+         * @tparam Reference unsafe_reference or safe_reference.
+         */
+        template <typename Reference>
+        class basic_table_reference : public Reference
+        {
+        public:
+            /**
+             * @brief Reads table[key], calling the __index metamethod if there is one. A std::string_view or const char * result points into
+             * a string that is kept alive by the table, so it stays valid while the table keeps referring to it.
+             *
+             * @tparam T The type of the value.
+             * @param key The key. Integers and C strings use lua_geti and lua_getfield, so they are not pushed separately.
+             * @throw type_error If the value is not of type T.
+             */
+            template <typename T, typename K>
+            T get(K &&key) const
+            {
+                const stack_guard guard(this->lua_state_);
+                this->push();
+                get_field(this->lua_state_, lua_gettop(this->lua_state_), std::forward<K>(key));
+                return stack::get<T>(this->lua_state_, -1);
+            }
+
+            /**
+             * @brief Assigns table[key] = value, calling the __newindex metamethod if there is one.
+             */
+            template <typename K, typename V>
+            void set(K &&key, V &&value) const
+            {
+                const stack_guard guard(this->lua_state_);
+                this->push();
+                const int table = lua_gettop(this->lua_state_);
+                stack::push(this->lua_state_, std::forward<V>(value));
+                set_field(this->lua_state_, table, std::forward<K>(key));
+            }
+
+            /**
+             * @brief Reads table[index] without calling metamethods. This is the fastest way to read the array part of a table.
+             *
+             * @throw type_error If the value is not of type T.
+             */
+            template <typename T>
+            T raw_get(lua_Integer index) const
+            {
+                const stack_guard guard(this->lua_state_);
+                this->push();
+                lua_rawgeti(this->lua_state_, -1, index);
+                return stack::get<T>(this->lua_state_, -1);
+            }
+
+            /**
+             * @brief Assigns table[index] = value without calling metamethods. This is the fastest way to fill the array part of a table.
+             */
+            template <typename V>
+            void raw_set(lua_Integer index, V &&value) const
+            {
+                const stack_guard guard(this->lua_state_);
+                this->push();
+                stack::push(this->lua_state_, std::forward<V>(value));
+                lua_rawseti(this->lua_state_, -2, index);
+            }
+
+            /**
+             * @brief Returns the length of the table without calling the __len metamethod, like rawlen(t).
+             *
+             * @param location Where a stack leak is reported, the caller by default.
+             */
+            std::size_t size(source_location location = source_location::current()) const
+            {
+                EASYLUA_STACK_CHECK_AT(this->lua_state_, 0, location);
+                this->push();
+                const std::size_t size = lua_rawlen(this->lua_state_, -1);
+                lua_pop(this->lua_state_, 1);
+                return size;
+            }
+
+            /// @brief Returns whether table[key] is not nil, without calling metamethods.
+            template <typename K>
+            bool contains(K &&key) const
+            {
+                const stack_guard guard(this->lua_state_);
+                this->push();
+                stack::push(this->lua_state_, std::forward<K>(key));
+                return lua_rawget(this->lua_state_, -2) != LUA_TNIL;
+            }
+
+            /**
+             * @brief Calls function(key, value) for every entry of the table, in the order of lua_next. The entries are read from the stack
+             * with stack::get, so iterating does not allocate unless K or V do. The table must not get new keys while it is iterated.
+             *
+             * Usage:
+             *                      table.for_each<std::string_view, int>([](std::string_view key, int value) { ... });
+             *
+             * @tparam K The type of the keys.
+             * @tparam V The type of the values.
+             * @throw type_error If a key or value does not have the given type.
+             */
+            template <typename K, typename V, typename F>
+            void for_each(F &&function) const
+            {
+                const stack_guard guard(this->lua_state_);
+                this->push();
+                const int table = lua_gettop(this->lua_state_);
+
+                lua_pushnil(this->lua_state_);
+                while (lua_next(this->lua_state_, table) != 0)
+                {
+                    function(stack::get<K>(this->lua_state_, -2), stack::get<V>(this->lua_state_, -1));
+                    lua_settop(this->lua_state_, table + 1);
+                }
+            }
+
+        protected:
+            basic_table_reference(lua_State *state, int index) : Reference(state, index, LUA_TTABLE)
+            {
+            }
+        };
+    } // namespace detail
+
+    /** Represents a Lua table on the stack. */
+    class unsafe_table_reference : public detail::basic_table_reference<unsafe_reference>
+    {
+    public:
+        unsafe_table_reference(lua_State *state, int index = -1) : basic_table_reference(state, index)
+        {
+        }
+
+        /**
+         * @brief Pushes a new table onto the stack and returns a reference to it. The sizes are hints that preallocate the table, so filling
+         * it does not rehash as it grows.
+         *
+         * @param state The Lua state.
+         * @param array_size The number of elements that will be stored at keys 1 to n.
+         * @param hash_size The number of other keys that will be stored.
+         */
+        static unsafe_table_reference create(lua_State *state, int array_size = 0, int hash_size = 0)
+        {
+            if (!state)
+                throw invalid_argument("state", "cannot be null");
+
+            lua_createtable(state, array_size, hash_size);
+            return unsafe_table_reference(state, -1);
+        }
+    };
+
+    /** Holds a Lua table through a reference in the registry. */
+    class safe_table_reference : public detail::basic_table_reference<safe_reference>
+    {
+    public:
+        safe_table_reference(lua_State *state, int index = -1) : basic_table_reference(state, index)
+        {
+        }
+
+        /**
+         * @brief Creates a new table and returns a reference to it. The stack is left unchanged. The sizes are hints that preallocate the
+         * table, so filling it does not rehash as it grows.
+         *
+         * @param state The Lua state.
+         * @param array_size The number of elements that will be stored at keys 1 to n.
+         * @param hash_size The number of other keys that will be stored.
+         */
+        static safe_table_reference create(lua_State *state, int array_size = 0, int hash_size = 0)
+        {
+            if (!state)
+                throw invalid_argument("state", "cannot be null");
+
+            lua_createtable(state, array_size, hash_size);
+            return safe_table_reference(state, -1);
+        }
+    };
+} // namespace easylua
+
+#endif
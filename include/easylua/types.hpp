@@ -2,6 +2,8 @@
 #define __EASYLUA_TYPES_H
 
 #include <cstddef>
+#include <tuple>
+#include <utility>
 
 namespace easylua
 {
@@ -12,6 +14,25 @@ namespace easylua
     };
 
     static constexpr nil_t nil;
+
+    /**
+     * @brief Returned by a bound C++ function to yield the coroutine that called it instead of returning. The values are passed to the
+     * resumer, and the values that the coroutine is resumed with become the results of the call.
+     *
+     * Usage:
+     *                      stack::push(L, [](int x) { return yield(x, x * 2); });
+     */
+    template <typename... T>
+    class yield
+    {
+    public:
+        explicit yield(T... values) : values_(std::move(values)...) {}
+
+        std::tuple<T...> &get_values() { return values_; }
+
+    private:
+        std::tuple<T...> values_;
+    };
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,269 @@
+#ifndef __EASYLUA_USERTYPE_H
+#define __EASYLUA_USERTYPE_H
+
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include <lua.hpp>
+
+#include "exception.hpp"
+#include "stack.hpp"
+
+namespace easylua
+{
+    namespace detail
+    {
+        /// @brief __index for usertypes with properties. Methods are looked up first, then property getters. Upvalues: methods, getters.
+        inline int index_with_properties(lua_State *L)
+        {
+            lua_pushvalue(L, 2);
+            if (lua_rawget(L, lua_upvalueindex(1)) != LUA_TNIL)
+                return 1;
+
+            lua_pop(L, 1);
+            lua_pushvalue(L, 2);
+            if (lua_rawget(L, lua_upvalueindex(2)) == LUA_TNIL)
+                return 1;
+
+            lua_pushvalue(L, 1);
+            lua_call(L, 1, 1);
+            return 1;
+        }
+
+        /// @brief __newindex for usertypes with properties. Upvalues: setters.
+        inline int newindex_with_properties(lua_State *L)
+        {
+            lua_pushvalue(L, 2);
+            if (lua_rawget(L, lua_upvalueindex(1)) == LUA_TNIL)
+                return luaL_error(L, "no writable property '%s'", lua_type(L, 2) == LUA_TSTRING ? lua_tostring(L, 2) : "?");
+
+            lua_pushvalue(L, 1);
+            lua_pushvalue(L, 3);
+            lua_call(L, 2, 0);
+            return 0;
+        }
+    } // namespace detail
+
+    /**
+     * @brief Registers a C++ class with a Lua state so that its objects can be used from Lua.
+     *
+     * Registration is done once per state. The methods, properties and metamethods are stored in metatables in the registry, which every
+     * object of the type shares. Objects pushed by value are stored in place in a full userdata and destroyed by the garbage collector.
+     * Objects pushed by pointer are not owned by Lua. Methods are found through the __index table of the metatable, so calling one from Lua
+     * is a table lookup followed by a call into the bound C++ function.
+     *
+     * Usage:
+     *                      usertype<point>(L, "point")
+     *                          .constructor<double, double>()
+     *                          .property("x", &point::x)
+     *                          .method("length", &point::length)
+     *                          .metamethod("__add", [](const point &a, const point &b) { return a + b; });
+     *
+     * @tparam T The class to register.
+     */
+    template <typename T>
+    class usertype
+    {
+    public:
+        /**
+         * @brief Construct a new usertype object. Creates the metatables of the type if they do not exist yet, and a global table with the
+         * given name that holds the constructors.
+         *
+         * @param state The Lua state.
+         * @param name The name of the type in Lua.
+         * @throw invalid_argument If state or name is null.
+         */
+        usertype(lua_State *state, const char *name) : lua_state_(state), name_(name ? name : "")
+        {
+            if (!lua_state_)
+                throw invalid_argument("state", "cannot be null");
+
+            if (!name)
+                throw invalid_argument("name", "cannot be null");
+
+            for (const bool pointer : {false, true})
+            {
+                detail::push_metatable<T>(lua_state_, pointer);
+                lua_pushstring(lua_state_, name_.c_str());
+                lua_setfield(lua_state_, -2, "__name");
+                lua_pop(lua_state_, 1);
+            }
+
+            if (lua_getglobal(lua_state_, name_.c_str()) != LUA_TTABLE)
+            {
+                lua_pop(lua_state_, 1);
+                lua_newtable(lua_state_);
+                lua_pushvalue(lua_state_, -1);
+                lua_setglobal(lua_state_, name_.c_str());
+            }
+
+            lua_pop(lua_state_, 1);
+        }
+
+        /**
+         * @brief Registers a constructor that creates an object from the given argument types, callable from Lua as name.new(...).
+         *
+         * @tparam Args The argument types of the constructor.
+         * @param name The name of the function in the global table of the type.
+         */
+        template <typename... Args>
+        usertype &constructor(const char *name = "new")
+        {
+            lua_getglobal(lua_state_, name_.c_str());
+            stack::push(lua_state_, [](Args... args) -> T
+                        { return T(std::move(args)...); });
+            lua_setfield(lua_state_, -2, name);
+            lua_pop(lua_state_, 1);
+            return *this;
+        }
+
+        /**
+         * @brief Registers a method. The function can be a member function of T or any function or callable object that takes a T as its
+         * first argument. From Lua it is called as object:name(...).
+         */
+        template <typename F>
+        usertype &method(const char *name, F function)
+        {
+            push_table("__methods");
+            stack::push(lua_state_, std::move(function));
+            lua_setfield(lua_state_, -2, name);
+            lua_pop(lua_state_, 1);
+            return *this;
+        }
+
+        /**
+         * @brief Registers a function in the global table of the type, callable from Lua as name.function(...).
+         */
+        template <typename F>
+        usertype &static_function(const char *name, F function)
+        {
+            lua_getglobal(lua_state_, name_.c_str());
+            stack::push(lua_state_, std::move(function));
+            lua_setfield(lua_state_, -2, name);
+            lua_pop(lua_state_, 1);
+            return *this;
+        }
+
+        /**
+         * @brief Registers a property backed by a data member. The property is read only if the member is const.
+         */
+        template <typename M, typename std::enable_if_t<!std::is_function_v<M>, bool> = true>
+        usertype &property(const char *name, M T::*member)
+        {
+            add_accessor("__getters", name, [member](const T &object) -> M
+                         { return object.*member; });
+
+            if constexpr (!std::is_const_v<M>)
+                add_accessor("__setters", name, [member](T &object, M value)
+                             { object.*member = std::move(value); });
+
+            return *this;
+        }
+
+        /**
+         * @brief Registers a read only property backed by a getter, which is a member function of T or a function that takes a T.
+         */
+        template <typename Getter>
+        usertype &property(const char *name, Getter getter)
+        {
+            add_accessor("__getters", name, std::move(getter));
+            return *this;
+        }
+
+        /**
+         * @brief Registers a property backed by a getter and a setter, which are member functions of T or functions that take a T as their
+         * first argument.
+         */
+        template <typename Getter, typename Setter>
+        usertype &property(const char *name, Getter getter, Setter setter)
+        {
+            add_accessor("__getters", name, std::move(getter));
+            add_accessor("__setters", name, std::move(setter));
+            return *this;
+        }
+
+        /**
+         * @brief Registers a metamethod such as __add, __eq, __lt, __len, __call or __tostring.
+         *
+         * @throw invalid_argument If the metamethod is one that the usertype manages itself.
+         */
+        template <typename F>
+        usertype &metamethod(const char *name, F function)
+        {
+            const std::string_view event = name;
+            if (event == "__gc" || event == "__index" || event == "__newindex" || event == "__name")
+                throw invalid_argument("name", "is managed by the usertype");
+
+            stack::push(lua_state_, std::move(function));
+            for (const bool pointer : {false, true})
+            {
+                detail::push_metatable<T>(lua_state_, pointer);
+                lua_pushvalue(lua_state_, -2);
+                lua_setfield(lua_state_, -2, name);
+                lua_pop(lua_state_, 1);
+            }
+
+            lua_pop(lua_state_, 1);
+            return *this;
+        }
+
+    private:
+        /// @brief Pushes the table with the given name from the metatable of the type, creating it if needed.
+        void push_table(const char *table)
+        {
+            detail::push_metatable<T>(lua_state_, false);
+            if (lua_getfield(lua_state_, -1, table) != LUA_TTABLE)
+            {
+                lua_pop(lua_state_, 1);
+                lua_newtable(lua_state_);
+                for (const bool pointer : {false, true})
+                {
+                    detail::push_metatable<T>(lua_state_, pointer);
+                    lua_pushvalue(lua_state_, -2);
+                    lua_setfield(lua_state_, -2, table);
+                    lua_pop(lua_state_, 1);
+                }
+            }
+
+            lua_remove(lua_state_, -2);
+        }
+
+        template <typename F>
+        void add_accessor(const char *table, const char *name, F function)
+        {
+            push_table(table);
+            stack::push(lua_state_, std::move(function));
+            lua_setfield(lua_state_, -2, name);
+            lua_pop(lua_state_, 1);
+
+            install_property_handlers();
+        }
+
+        /// @brief Replaces the plain __index table with functions that also look up properties.
+        void install_property_handlers()
+        {
+            for (const bool pointer : {false, true})
+            {
+                detail::push_metatable<T>(lua_state_, pointer);
+
+                push_table("__methods");
+                push_table("__getters");
+                lua_pushcclosure(lua_state_, &detail::index_with_properties, 2);
+                lua_setfield(lua_state_, -2, "__index");
+
+                push_table("__setters");
+                lua_pushcclosure(lua_state_, &detail::newindex_with_properties, 1);
+                lua_setfield(lua_state_, -2, "__newindex");
+
+                lua_pop(lua_state_, 1);
+            }
+        }
+
+        lua_State *lua_state_;
+        std::string name_;
+    };
+} // namespace easylua
+
+#endif
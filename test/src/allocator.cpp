@@ -0,0 +1,215 @@
+#include <easylua/state.hpp>
+
+#include <cstring>
+#include <limits>
+#include <memory_resource>
+
+#include <gtest/gtest.h>
+
+using namespace easylua;
+
+static constexpr const char *allocating_script = R"(
+t = {}
+for i = 1, 1000 do
+    t[i] = { value = i, name = "name" .. i }
+end
+sum = 0
+for i = 1, #t do
+    sum = sum + t[i].value
+end
+)";
+
+static void run_allocating_script(state &lua)
+{
+    ASSERT_TRUE(lua.run(allocating_script));
+    int sum = lua["sum"];
+    EXPECT_EQ(500500, sum);
+}
+
+TEST(allocator, state_constructor_throws_on_null_allocator)
+{
+    EXPECT_THROW(state(std::unique_ptr<pool_allocator>()), invalid_argument);
+}
+
+TEST(allocator, state_default_allocator)
+{
+    state lua(std::make_unique<default_allocator>());
+    EXPECT_NE(nullptr, lua.get_allocator());
+    run_allocating_script(lua);
+}
+
+TEST(allocator, state_pool_allocator)
+{
+    state lua(std::make_unique<pool_allocator>());
+    run_allocating_script(lua);
+}
+
+TEST(allocator, state_arena_allocator)
+{
+    state lua(std::make_unique<arena_allocator>(1024));
+    run_allocating_script(lua);
+}
+
+TEST(allocator, state_memory_resource_allocator)
+{
+    std::pmr::unsynchronized_pool_resource resource;
+    state lua(std::make_unique<memory_resource_allocator>(&resource));
+    run_allocating_script(lua);
+}
+
+TEST(allocator, state_without_allocator)
+{
+    state lua;
+    EXPECT_EQ(nullptr, lua.get_allocator());
+}
+
+TEST(allocator, move_keeps_allocator)
+{
+    state lua(std::make_unique<pool_allocator>());
+    allocator *alloc = lua.get_allocator();
+    state lua2(std::move(lua));
+    EXPECT_EQ(alloc, lua2.get_allocator());
+    run_allocating_script(lua2);
+}
+
+TEST(allocator, pool_allocator_throws_on_small_chunk)
+{
+    EXPECT_THROW(pool_allocator(16), invalid_argument);
+}
+
+TEST(allocator, pool_allocator_reuses_freed_blocks)
+{
+    pool_allocator alloc;
+    void *a = alloc.reallocate(nullptr, 0, 24);
+    ASSERT_NE(nullptr, a);
+    EXPECT_EQ(nullptr, alloc.reallocate(a, 24, 0));
+    EXPECT_EQ(a, alloc.reallocate(nullptr, 0, 30));
+}
+
+TEST(allocator, pool_allocator_preserves_contents)
+{
+    pool_allocator alloc;
+    char *a = static_cast<char *>(alloc.reallocate(nullptr, 0, 8));
+    std::memcpy(a, "abcdefg", 8);
+    char *b = static_cast<char *>(alloc.reallocate(a, 8, 1024));
+    EXPECT_STREQ("abcdefg", b);
+    char *c = static_cast<char *>(alloc.reallocate(b, 1024, 40));
+    EXPECT_STREQ("abcdefg", c);
+    alloc.reallocate(c, 40, 0);
+}
+
+TEST(allocator, pool_allocator_shrink_never_fails)
+{
+    // No chunk of this size can be allocated, so every pooled allocation fails.
+    pool_allocator alloc(std::numeric_limits<std::size_t>::max() / 2);
+    EXPECT_EQ(nullptr, alloc.reallocate(nullptr, 0, 16));
+
+    char *a = static_cast<char *>(alloc.reallocate(nullptr, 0, 1024));
+    ASSERT_NE(nullptr, a);
+    std::memcpy(a, "abcdefg", 8);
+    EXPECT_EQ(a, alloc.reallocate(a, 1024, 100));
+    EXPECT_STREQ("abcdefg", a);
+    EXPECT_EQ(nullptr, alloc.reallocate(a, 100, 0));
+    EXPECT_EQ(a, alloc.reallocate(nullptr, 0, 100));
+    alloc.reallocate(a, 100, 0);
+}
+
+TEST(allocator, arena_allocator_grows_last_block_in_place)
+{
+    arena_allocator alloc;
+    void *a = alloc.reallocate(nullptr, 0, 16);
+    EXPECT_EQ(a, alloc.reallocate(a, 16, 64));
+}
+
+TEST(allocator, arena_allocator_preserves_contents)
+{
+    arena_allocator alloc(64);
+    char *a = static_cast<char *>(alloc.reallocate(nullptr, 0, 8));
+    std::memcpy(a, "abcdefg", 8);
+    alloc.reallocate(nullptr, 0, 16);
+    char *b = static_cast<char *>(alloc.reallocate(a, 8, 256));
+    EXPECT_STREQ("abcdefg", b);
+}
+
+TEST(allocator, memory_resource_allocator_throws_on_null_resource)
+{
+    EXPECT_THROW(memory_resource_allocator(nullptr), invalid_argument);
+}
+
+TEST(allocator, memory_resource_allocator_reports_failure)
+{
+    std::pmr::monotonic_buffer_resource resource(std::pmr::null_memory_resource());
+    memory_resource_allocator alloc(&resource);
+    EXPECT_EQ(nullptr, alloc.reallocate(nullptr, 0, 16));
+}
+
+TEST(allocator, tracking_allocator_throws_on_null_allocator)
+{
+    EXPECT_THROW(tracking_allocator(tracking_allocator::no_limit, nullptr), invalid_argument);
+}
+
+TEST(allocator, tracking_allocator_counts)
+{
+    tracking_allocator alloc;
+    void *a = alloc.reallocate(nullptr, 0, 100);
+    void *b = alloc.reallocate(nullptr, 0, 50);
+    EXPECT_EQ(150, alloc.get_live_bytes());
+    EXPECT_EQ(2, alloc.get_allocation_count());
+
+    a = alloc.reallocate(a, 100, 20);
+    EXPECT_EQ(70, alloc.get_live_bytes());
+    EXPECT_EQ(150, alloc.get_peak_bytes());
+
+    alloc.reallocate(a, 20, 0);
+    alloc.reallocate(b, 50, 0);
+    EXPECT_EQ(0, alloc.get_live_bytes());
+    EXPECT_EQ(150, alloc.get_peak_bytes());
+    EXPECT_EQ(2, alloc.get_allocation_count());
+
+    alloc.reset_peak();
+    EXPECT_EQ(0, alloc.get_peak_bytes());
+}
+
+TEST(allocator, tracking_allocator_enforces_limit)
+{
+    tracking_allocator alloc(100);
+    void *a = alloc.reallocate(nullptr, 0, 80);
+    ASSERT_NE(nullptr, a);
+    EXPECT_EQ(nullptr, alloc.reallocate(nullptr, 0, 40));
+    EXPECT_EQ(nullptr, alloc.reallocate(a, 80, 120));
+    EXPECT_EQ(2, alloc.get_failed_allocation_count());
+    EXPECT_EQ(80, alloc.get_live_bytes());
+
+    // Shrinking is always allowed
+    a = alloc.reallocate(a, 80, 10);
+    EXPECT_NE(nullptr, a);
+    alloc.reallocate(a, 10, 0);
+}
+
+TEST(allocator, state_tracking_allocator)
+{
+    state lua(std::make_unique<tracking_allocator>());
+    tracking_allocator *tracker = lua.get_allocator<tracking_allocator>();
+    ASSERT_NE(nullptr, tracker);
+
+    const std::size_t before = tracker->get_live_bytes();
+    EXPECT_GT(before, 0);
+    run_allocating_script(lua);
+    EXPECT_GT(tracker->get_live_bytes(), before);
+    EXPECT_GE(tracker->get_peak_bytes(), tracker->get_live_bytes());
+    EXPECT_EQ(nullptr, lua.get_allocator<pool_allocator>());
+}
+
+TEST(allocator, state_memory_limit_returns_memory_error)
+{
+    state lua(std::make_unique<tracking_allocator>(256 * 1024));
+    const script::load_result result = lua.run("t = {} for i = 1, 1e7 do t[i] = i end");
+    EXPECT_EQ(script::load_result::result::memory_error, result.get_result());
+
+    // The state remains usable after the limit was hit
+    ASSERT_TRUE(lua.run("t = nil"));
+    lua_gc(lua, LUA_GCCOLLECT);
+    ASSERT_TRUE(lua.run("x = 5"));
+    int x = lua["x"];
+    EXPECT_EQ(5, x);
+}
@@ -0,0 +1,209 @@
+#include <easylua/budget.hpp>
+#include <easylua/function.hpp>
+#include <easylua/script.hpp>
+#include <easylua/state.hpp>
+
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+class Budget : public ::testing::Test
+{
+public:
+    Budget()
+    {
+        L = luaL_newstate();
+        if (!L)
+            throw std::runtime_error("Could not create Lua state");
+
+        luaL_openlibs(L);
+    }
+
+    ~Budget() { lua_close(L); }
+
+protected:
+    lua_State *L;
+};
+
+using namespace easylua;
+
+TEST_F(Budget, constructor_throws_on_invalid_arguments)
+{
+    execution_budget budget;
+    EXPECT_THROW(budget_scope(nullptr, budget), invalid_argument);
+
+    budget.granularity = 0;
+    EXPECT_THROW(budget_scope(L, budget), invalid_argument);
+}
+
+TEST_F(Budget, run_string_within_budget)
+{
+    execution_budget budget;
+    budget.max_instructions = 100000;
+    const script::load_result result = script::run_string(L, "x = 0 for i = 1, 100 do x = x + i end", budget);
+    EXPECT_TRUE(result);
+
+    lua_getglobal(L, "x");
+    EXPECT_EQ(5050, lua_tointeger(L, -1));
+}
+
+TEST_F(Budget, run_string_exceeds_instructions)
+{
+    execution_budget budget;
+    budget.max_instructions = 10000;
+    const script::load_result result = script::run_string(L, "while true do end", budget);
+    EXPECT_EQ(script::load_result::result::budget_exceeded, result.get_result());
+}
+
+TEST_F(Budget, run_string_exceeds_deadline)
+{
+    execution_budget budget;
+    budget.max_duration = std::chrono::milliseconds(10);
+    const auto start = std::chrono::steady_clock::now();
+    const script::load_result result = script::run_string(L, "while true do end", budget);
+    EXPECT_EQ(script::load_result::result::budget_exceeded, result.get_result());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST_F(Budget, deadline_applies_to_coroutines)
+{
+    execution_budget budget;
+    budget.max_duration = std::chrono::milliseconds(10);
+    budget_scope scope(L, budget);
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_NE(LUA_OK, luaL_dostring(L, "coroutine.wrap(function() while true do end end)()"));
+    EXPECT_TRUE(scope.is_exceeded());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST_F(Budget, instruction_limit_applies_to_coroutines)
+{
+    execution_budget budget;
+    budget.max_instructions = 10000;
+    const script::load_result result = script::run_string(L, "local co = coroutine.create(function() while true do end end) "
+                                                             "assert(coroutine.resume(co))", budget);
+    EXPECT_EQ(script::load_result::result::budget_exceeded, result.get_result());
+}
+
+TEST_F(Budget, deadline_with_instruction_limit)
+{
+    execution_budget budget;
+    budget.max_instructions = 1'000'000'000'000;
+    budget.max_duration = std::chrono::milliseconds(10);
+    const script::load_result result = script::run_string(L, "while true do end", budget);
+    EXPECT_EQ(script::load_result::result::budget_exceeded, result.get_result());
+}
+
+TEST_F(Budget, instruction_limit_is_exact)
+{
+    execution_budget budget;
+    budget.max_instructions = 1500;
+    budget.granularity = 1000;
+    budget_scope scope(L, budget);
+    EXPECT_NE(LUA_OK, luaL_dostring(L, "while true do end"));
+    EXPECT_TRUE(scope.is_exceeded());
+    EXPECT_EQ(1500u, scope.get_instructions());
+}
+
+TEST_F(Budget, pcall_cannot_catch_budget_error)
+{
+    execution_budget budget;
+    budget.max_instructions = 10000;
+    const script::load_result result = script::run_string(L, "while true do pcall(function() while true do end end) end", budget);
+    EXPECT_EQ(script::load_result::result::budget_exceeded, result.get_result());
+}
+
+TEST_F(Budget, other_errors_are_runtime_errors)
+{
+    execution_budget budget;
+    budget.max_instructions = 10000;
+    const script::load_result result = script::run_string(L, "error('failed')", budget);
+    EXPECT_EQ(script::load_result::result::runtime_error, result.get_result());
+}
+
+TEST_F(Budget, function_call_throws_budget_exceeded)
+{
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "function spin() while true do end end function add(a, b) return a + b end"));
+    lua_getglobal(L, "spin");
+    safe_function_reference spin(L);
+    lua_getglobal(L, "add");
+    safe_function_reference add(L);
+
+    execution_budget budget;
+    budget.max_instructions = 10000;
+    budget_scope scope(L, budget);
+
+    int sum = add(1, 2);
+    EXPECT_EQ(3, sum);
+    EXPECT_THROW(spin(), budget_exceeded);
+}
+
+TEST_F(Budget, scope_restores_previous_hook)
+{
+    static int calls = 0;
+    lua_sethook(L, [](lua_State *, lua_Debug *)
+                { calls++; },
+                LUA_MASKCOUNT, 1);
+
+    {
+        execution_budget budget;
+        budget.max_instructions = 100;
+        budget_scope scope(L, budget);
+        EXPECT_NE(LUA_OK, luaL_dostring(L, "while true do end"));
+    }
+
+    EXPECT_EQ(LUA_MASKCOUNT, lua_gethookmask(L));
+    EXPECT_EQ(1, lua_gethookcount(L));
+
+    calls = 0;
+    EXPECT_EQ(LUA_OK, luaL_dostring(L, "local x = 1"));
+    EXPECT_GT(calls, 0);
+    EXPECT_TRUE(script::run_string(L, "local x = 1"));
+}
+
+TEST_F(Budget, nested_scopes)
+{
+    execution_budget outer_budget;
+    outer_budget.max_instructions = 1000000;
+    budget_scope outer(L, outer_budget);
+    {
+        execution_budget inner_budget;
+        inner_budget.max_instructions = 1000;
+        budget_scope inner(L, inner_budget);
+        EXPECT_NE(LUA_OK, luaL_dostring(L, "while true do end"));
+        EXPECT_TRUE(inner.is_exceeded());
+    }
+
+    EXPECT_FALSE(outer.is_exceeded());
+    EXPECT_EQ(LUA_OK, luaL_dostring(L, "for i = 1, 100 do end"));
+}
+
+TEST_F(Budget, outer_deadline_that_passes_in_inner_scope)
+{
+    execution_budget outer_budget;
+    outer_budget.max_duration = std::chrono::milliseconds(10);
+    outer_budget.granularity = 1'000'000'000;
+    budget_scope outer(L, outer_budget);
+    {
+        execution_budget inner_budget;
+        inner_budget.max_instructions = 1'000'000'000'000;
+        budget_scope inner(L, inner_budget);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+
+    EXPECT_EQ(&detail::budget_hook, lua_gethook(L));
+    EXPECT_EQ(1, lua_gethookcount(L));
+    EXPECT_NE(LUA_OK, luaL_dostring(L, "local x = 1"));
+    EXPECT_TRUE(outer.is_exceeded());
+}
+
+TEST_F(Budget, state_run)
+{
+    state lua;
+    execution_budget budget;
+    budget.max_instructions = 1000;
+    EXPECT_EQ(script::load_result::result::budget_exceeded, lua.run("while true do end", budget).get_result());
+    EXPECT_TRUE(lua.run("x = 1", budget));
+}
@@ -0,0 +1,187 @@
+#include <easylua/buffer_view.hpp>
+#include <easylua/state.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include <gtest/gtest.h>
+
+class BufferView : public ::testing::Test
+{
+public:
+    BufferView()
+    {
+        L = luaL_newstate();
+        if (!L)
+            throw std::runtime_error("Could not create Lua state");
+
+        luaL_openlibs(L);
+        easylua::buffer_view::register_type(L);
+    }
+
+    ~BufferView() { lua_close(L); }
+
+protected:
+    template <typename T>
+    T run(const char *expression)
+    {
+        const std::string code = std::string("return ") + expression;
+        if (luaL_dostring(L, code.c_str()) != LUA_OK)
+            throw std::runtime_error(lua_tostring(L, -1));
+
+        T result = easylua::stack::get<T>(L, -1);
+        lua_pop(L, 1);
+        return result;
+    }
+
+    std::string error(const char *code)
+    {
+        EXPECT_NE(LUA_OK, luaL_dostring(L, code));
+        std::string message = lua_tostring(L, -1);
+        lua_pop(L, 1);
+        return message;
+    }
+
+    lua_State *L;
+};
+
+using namespace easylua;
+
+static const std::array<unsigned char, 12> packet = {0x01, 0x34, 0x12, 0x78, 0x56, 0x34, 0x12, 0x00, 0x00, 0x80, 0x3f, 0xff};
+
+TEST_F(BufferView, indexed_access)
+{
+    stack::push(L, buffer_view(packet.data(), packet.size()));
+    lua_setglobal(L, "view");
+
+    EXPECT_EQ(12, run<int>("#view"));
+    EXPECT_EQ(0x01, run<int>("view[1]"));
+    EXPECT_EQ(0xff, run<int>("view[12]"));
+    EXPECT_TRUE(run<bool>("view[0] == nil and view[13] == nil"));
+}
+
+TEST_F(BufferView, typed_reads_are_little_endian)
+{
+    stack::push(L, buffer_view(packet.data(), packet.size()));
+    lua_setglobal(L, "view");
+
+    EXPECT_EQ(0x01, run<int>("view:u8(1)"));
+    EXPECT_EQ(0x1234, run<int>("view:u16(2)"));
+    EXPECT_EQ(0x12345678, run<lua_Integer>("view:u32(4)"));
+    EXPECT_EQ(1.0, run<double>("view:f32(8)"));
+    EXPECT_NE(std::string::npos, error("return view:u32(10)").find("out of range"));
+}
+
+TEST_F(BufferView, f64)
+{
+    const double value = 3.25;
+    std::array<unsigned char, 8> bytes;
+    std::memcpy(bytes.data(), &value, sizeof(value));
+    stack::push(L, buffer_view(bytes.data(), bytes.size()));
+    lua_setglobal(L, "view");
+
+    EXPECT_EQ(3.25, run<double>("view:f64(1)"));
+}
+
+TEST_F(BufferView, sub_shares_memory)
+{
+    std::array<unsigned char, 4> bytes = {1, 2, 3, 4};
+    stack::push(L, buffer_view::writable(bytes.data(), bytes.size()));
+    lua_setglobal(L, "view");
+
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "part = view:sub(2, 3)"));
+    EXPECT_EQ(2, run<int>("#part"));
+    EXPECT_EQ(2, run<int>("part[1]"));
+    EXPECT_EQ(0x0302, run<int>("part:u16(1)"));
+    EXPECT_EQ(2, run<int>("#view:sub(3)"));
+    EXPECT_EQ(0, run<int>("#view:sub(4, 2)"));
+
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "part[2] = 42"));
+    EXPECT_EQ(42, bytes[2]);
+}
+
+TEST_F(BufferView, tostring)
+{
+    const std::string text = "hello world";
+    stack::push(L, buffer_view(text.data(), text.size()));
+    lua_setglobal(L, "view");
+
+    EXPECT_EQ("hello world", run<std::string>("tostring(view)"));
+    EXPECT_EQ("world", run<std::string>("view:tostring(7)"));
+    EXPECT_EQ("ell", run<std::string>("view:tostring(2, 4)"));
+}
+
+TEST_F(BufferView, writes)
+{
+    std::array<unsigned char, 8> bytes{};
+    stack::push(L, buffer_view::writable(bytes.data(), bytes.size()));
+    lua_setglobal(L, "view");
+
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "view[1] = 7 view:set_u16(2, 0x1234) view:set_f32(5, 1.0)"));
+    EXPECT_EQ(7, bytes[0]);
+    EXPECT_EQ(0x34, bytes[1]);
+    EXPECT_EQ(0x12, bytes[2]);
+    EXPECT_EQ(0x3f, bytes[7]);
+    EXPECT_NE(std::string::npos, error("view[9] = 1").find("out of range"));
+}
+
+TEST_F(BufferView, read_only_view_rejects_writes)
+{
+    std::array<unsigned char, 4> bytes{};
+    stack::push(L, buffer_view(bytes.data(), bytes.size()));
+    lua_setglobal(L, "view");
+
+    EXPECT_NE(std::string::npos, error("view[1] = 1").find("read only"));
+    EXPECT_NE(std::string::npos, error("view:set_u8(1, 1)").find("read only"));
+    EXPECT_EQ(0, bytes[0]);
+}
+
+TEST_F(BufferView, stale_view_is_caught)
+{
+    std::array<unsigned char, 4> bytes = {1, 2, 3, 4};
+    {
+        buffer_owner owner;
+        stack::push(L, owner.view(bytes.data(), bytes.size()));
+        lua_setglobal(L, "view");
+        ASSERT_EQ(LUA_OK, luaL_dostring(L, "part = view:sub(2)"));
+        EXPECT_EQ(1, run<int>("view[1]"));
+    }
+
+    EXPECT_NE(std::string::npos, error("return view[1]").find("no longer valid"));
+    EXPECT_NE(std::string::npos, error("return view:u8(1)").find("no longer valid"));
+    EXPECT_NE(std::string::npos, error("return part:tostring()").find("no longer valid"));
+    EXPECT_NE(std::string::npos, error("return view:sub(1)").find("no longer valid"));
+}
+
+TEST_F(BufferView, metatable_is_locked)
+{
+    stack::push(L, buffer_view(packet.data(), packet.size()));
+    lua_setglobal(L, "view");
+
+    EXPECT_FALSE(run<bool>("getmetatable(view)"));
+    EXPECT_EQ(0x01, run<int>("view[1]"));
+}
+
+TEST_F(BufferView, metamethods_check_self)
+{
+    stack::push(L, buffer_view(packet.data(), packet.size()));
+    lua_setglobal(L, "view");
+
+    EXPECT_NE(std::string::npos, error("return debug.getmetatable(view).__index({}, 1)").find("buffer_view expected"));
+    EXPECT_NE(std::string::npos, error("debug.getmetatable(view).__newindex(io.stdout, 1, 1)").find("buffer_view expected"));
+    EXPECT_EQ(0x01, run<int>("debug.getmetatable(view).__index(view, 1)"));
+}
+
+TEST_F(BufferView, get_from_stack)
+{
+    buffer_owner owner;
+    stack::push(L, owner.view(packet.data(), packet.size()));
+    const buffer_view view = stack::get<buffer_view>(L, -1);
+    EXPECT_EQ(packet.data(), view.data());
+    EXPECT_EQ(0x1234, view.read<std::uint16_t>(1));
+    owner.release();
+    EXPECT_FALSE(view.is_valid());
+    EXPECT_THROW(view.read<std::uint8_t>(0), invalid_operation);
+}
@@ -0,0 +1,109 @@
+#include <easylua/chunk_cache.hpp>
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+#include <gtest/gtest.h>
+
+class ChunkCache : public ::testing::Test
+{
+public:
+    ChunkCache()
+    {
+        L = luaL_newstate();
+        if (!L)
+            throw std::runtime_error("Could not create Lua state");
+    }
+
+    ~ChunkCache() { lua_close(L); }
+
+protected:
+    lua_State *L;
+};
+
+using namespace easylua;
+
+static void write_file(const std::filesystem::path &path, const std::string &contents)
+{
+    std::ofstream file(path, std::ios::trunc);
+    file << contents;
+}
+
+TEST_F(ChunkCache, constructor_throws_on_null_state)
+{
+    EXPECT_THROW(script::chunk_cache(nullptr), invalid_argument);
+}
+
+TEST_F(ChunkCache, load_string_hits_after_first_load)
+{
+    script::chunk_cache cache(L);
+    ASSERT_TRUE(cache.load_string("return 1"));
+    const void *first = lua_topointer(L, -1);
+    ASSERT_TRUE(cache.load_string("return 1"));
+    EXPECT_EQ(first, lua_topointer(L, -1));
+
+    EXPECT_EQ(1, cache.get_hits());
+    EXPECT_EQ(1, cache.get_misses());
+    EXPECT_EQ(1, cache.size());
+}
+
+TEST_F(ChunkCache, load_string_does_not_cache_errors)
+{
+    script::chunk_cache cache(L);
+    EXPECT_EQ(script::load_result::result::syntax_error, cache.load_string("function").get_result());
+    EXPECT_EQ(script::load_result::result::syntax_error, cache.load_string("function").get_result());
+    EXPECT_EQ(0, cache.get_hits());
+    EXPECT_EQ(2, cache.get_misses());
+    EXPECT_EQ(0, cache.size());
+}
+
+TEST_F(ChunkCache, run_string_runs_cached_chunk)
+{
+    script::chunk_cache cache(L);
+    ASSERT_TRUE(cache.run_string("counter = (counter or 0) + 1"));
+    ASSERT_TRUE(cache.run_string("counter = (counter or 0) + 1"));
+
+    lua_getglobal(L, "counter");
+    EXPECT_EQ(2, lua_tointeger(L, -1));
+    EXPECT_EQ(1, cache.get_hits());
+}
+
+TEST_F(ChunkCache, clear_releases_chunks)
+{
+    script::chunk_cache cache(L);
+    ASSERT_TRUE(cache.load_string("return 1"));
+    cache.clear();
+    EXPECT_EQ(0, cache.size());
+    ASSERT_TRUE(cache.load_string("return 1"));
+    EXPECT_EQ(2, cache.get_misses());
+}
+
+TEST_F(ChunkCache, load_file_invalidates_on_change)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "easylua_chunk_cache_test.lua";
+    write_file(path, "value = 1");
+
+    script::chunk_cache cache(L);
+    ASSERT_TRUE(cache.run_file(path.string()));
+    ASSERT_TRUE(cache.run_file(path.string()));
+    EXPECT_EQ(1, cache.get_hits());
+
+    write_file(path, "value = 22");
+    std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::seconds(1));
+    ASSERT_TRUE(cache.run_file(path.string()));
+    EXPECT_EQ(2, cache.get_misses());
+    EXPECT_EQ(1, cache.size());
+
+    lua_getglobal(L, "value");
+    EXPECT_EQ(22, lua_tointeger(L, -1));
+
+    std::filesystem::remove(path);
+}
+
+TEST_F(ChunkCache, load_file_missing_file)
+{
+    script::chunk_cache cache(L);
+    EXPECT_EQ(script::load_result::result::file_error, cache.load_file("does_not_exist.lua").get_result());
+    EXPECT_EQ(0, cache.size());
+}
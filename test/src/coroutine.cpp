@@ -0,0 +1,261 @@
+#include <easylua/coroutine.hpp>
+
+#include <cstdint>
+#include <map>
+#include <queue>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class Coroutine : public ::testing::Test
+{
+public:
+    Coroutine()
+    {
+        L = luaL_newstate();
+        if (!L)
+            throw std::runtime_error("Could not create Lua state");
+
+        luaL_requiref(L, LUA_GNAME, luaopen_base, 1);
+        luaL_requiref(L, LUA_COLIBNAME, luaopen_coroutine, 1);
+        lua_settop(L, 0);
+    }
+
+    ~Coroutine() { lua_close(L); }
+
+protected:
+    easylua::coroutine_reference load(const char *script)
+    {
+        if (luaL_loadstring(L, script) != LUA_OK)
+            throw std::runtime_error(lua_tostring(L, -1));
+
+        easylua::coroutine_reference coroutine = easylua::coroutine_reference::create(L);
+        lua_pop(L, 1);
+        return coroutine;
+    }
+
+    lua_State *L;
+};
+
+using namespace easylua;
+
+TEST_F(Coroutine, create_throws_on_wrong_type)
+{
+    lua_pushinteger(L, 1);
+    EXPECT_THROW(coroutine_reference::create(L), type_error);
+    EXPECT_THROW(coroutine_reference(L, -1), type_error);
+    EXPECT_THROW(coroutine_reference::create(nullptr), invalid_argument);
+}
+
+TEST_F(Coroutine, resume)
+{
+    coroutine_reference coroutine = load("local a, b = ... local c = coroutine.yield(a + b) return c * 2, 'done'");
+    EXPECT_EQ(coroutine_status::suspended, coroutine.get_status());
+    EXPECT_EQ(0, lua_gettop(L));
+
+    {
+        resume_result result = coroutine.resume(1, 2);
+        EXPECT_TRUE(result.is_yielded());
+        int sum = result;
+        EXPECT_EQ(3, sum);
+    }
+
+    EXPECT_EQ(coroutine_status::suspended, coroutine.get_status());
+
+    {
+        resume_result result = coroutine.resume(5);
+        EXPECT_TRUE(result.is_finished());
+        std::tuple<int, std::string> values = result;
+        EXPECT_EQ(10, std::get<0>(values));
+        EXPECT_EQ("done", std::get<1>(values));
+    }
+
+    EXPECT_EQ(coroutine_status::dead, coroutine.get_status());
+    EXPECT_THROW(coroutine.resume(), invalid_operation);
+    EXPECT_EQ(0, lua_gettop(L));
+}
+
+TEST_F(Coroutine, resume_throws_on_error)
+{
+    coroutine_reference coroutine = load("coroutine.yield() error('failed')");
+    coroutine.resume();
+    EXPECT_THROW(coroutine.resume(), runtime_error);
+    EXPECT_EQ(coroutine_status::dead, coroutine.get_status());
+}
+
+TEST_F(Coroutine, dead_while_results_are_on_the_stack)
+{
+    coroutine_reference coroutine = load("return 1, 2");
+    resume_result result = coroutine.resume();
+    EXPECT_TRUE(result.is_finished());
+    EXPECT_EQ(2, lua_gettop(coroutine.get_thread()));
+    EXPECT_EQ(coroutine_status::dead, coroutine.get_status());
+    EXPECT_THROW(coroutine.resume(), invalid_operation);
+}
+
+TEST_F(Coroutine, get_status_running)
+{
+    coroutine_reference *self = nullptr;
+    coroutine_status status = coroutine_status::dead;
+    stack::push(L, [&]()
+                { status = self->get_status(); });
+    lua_setglobal(L, "check");
+
+    coroutine_reference coroutine = load("check()");
+    self = &coroutine;
+    coroutine.resume();
+    EXPECT_EQ(coroutine_status::running, status);
+}
+
+TEST_F(Coroutine, native_function_yields)
+{
+    stack::push(L, [](int x)
+                { return yield(x, x * 2); });
+    lua_setglobal(L, "twice");
+
+    coroutine_reference coroutine = load("local r = twice(4) return r + 1");
+    {
+        std::tuple<int, int> values = coroutine.resume();
+        EXPECT_EQ(std::make_tuple(4, 8), values);
+    }
+
+    int result = coroutine.resume(10);
+    EXPECT_EQ(11, result);
+    EXPECT_EQ(coroutine_status::dead, coroutine.get_status());
+}
+
+TEST_F(Coroutine, native_function_yield_outside_coroutine)
+{
+    stack::push(L, []()
+                { return yield(); });
+    lua_setglobal(L, "pause");
+
+    EXPECT_NE(LUA_OK, luaL_dostring(L, "pause()"));
+}
+
+TEST_F(Coroutine, move)
+{
+    coroutine_reference coroutine = load("return 7");
+    coroutine_reference moved(std::move(coroutine));
+    int result = moved.resume();
+    EXPECT_EQ(7, result);
+
+    coroutine_reference other = load("return 8");
+    other = std::move(moved);
+    EXPECT_EQ(coroutine_status::dead, other.get_status());
+}
+
+TEST_F(Coroutine, push_and_get)
+{
+    coroutine_reference coroutine = load("return 1");
+    stack::push(L, coroutine);
+    EXPECT_EQ(LUA_TTHREAD, lua_type(L, -1));
+    coroutine_reference copy = stack::get<coroutine_reference>(L, -1);
+    EXPECT_EQ(coroutine.get_thread(), copy.get_thread());
+}
+
+#ifdef EASYLUA_HAS_COROUTINES
+namespace
+{
+    /// Runs coroutines that wait on timers, in order of their deadlines. Time is simulated, so the loop does not actually sleep.
+    class timer_loop
+    {
+    public:
+        struct timer
+        {
+            timer_loop &loop;
+            std::uint64_t delay;
+
+            bool await_ready() const { return delay == 0; }
+            void await_suspend(std::coroutine_handle<> handle) { loop.timers_.push({loop.now_ + delay, loop.sequence_++, handle}); }
+            std::uint64_t await_resume() const { return loop.now_; }
+        };
+
+        timer sleep(std::uint64_t delay) { return timer{*this, delay}; }
+
+        void run()
+        {
+            while (!timers_.empty())
+            {
+                const entry next = timers_.top();
+                timers_.pop();
+                now_ = next.deadline;
+                next.handle.resume();
+            }
+        }
+
+    private:
+        struct entry
+        {
+            std::uint64_t deadline;
+            std::uint64_t sequence;
+            std::coroutine_handle<> handle;
+
+            bool operator>(const entry &other) const { return deadline != other.deadline ? deadline > other.deadline : sequence > other.sequence; }
+        };
+
+        std::priority_queue<entry, std::vector<entry>, std::greater<entry>> timers_;
+        std::uint64_t now_ = 0;
+        std::uint64_t sequence_ = 0;
+    };
+}
+
+TEST_F(Coroutine, resume_async_awaits_bound_functions)
+{
+    timer_loop loop;
+    stack::push(L, [&](std::uint64_t delay)
+                { return loop.sleep(delay); });
+    lua_setglobal(L, "sleep");
+
+    coroutine_reference coroutine = load("local a = ... local t1 = sleep(10) local t2 = sleep(5) return a + t1 + t2");
+    script_task task = coroutine.resume_async(1);
+    EXPECT_FALSE(task.is_done());
+    EXPECT_THROW(task.get_results(), invalid_operation);
+
+    loop.run();
+    ASSERT_TRUE(task.is_done());
+    int result = task.get_results();
+    EXPECT_EQ(1 + 10 + 15, result);
+}
+
+TEST_F(Coroutine, resume_async_multiplexes_scripts)
+{
+    timer_loop loop;
+    stack::push(L, [&](std::uint64_t delay)
+                { return loop.sleep(delay); });
+    lua_setglobal(L, "sleep");
+
+    std::vector<coroutine_reference> coroutines;
+    std::vector<script_task> tasks;
+    coroutines.reserve(1000);
+    tasks.reserve(1000);
+    for (int i = 0; i < 1000; i++)
+    {
+        coroutines.push_back(load("local id = ... for step = 1, 3 do sleep(id % 7 + 1) coroutine.yield() end return id"));
+        tasks.push_back(coroutines.back().resume_async(i));
+    }
+
+    loop.run();
+    for (int i = 0; i < 1000; i++)
+    {
+        ASSERT_TRUE(tasks[i].is_done());
+        int id = tasks[i].get_results();
+        EXPECT_EQ(i, id);
+    }
+}
+
+TEST_F(Coroutine, resume_async_passes_on_errors)
+{
+    timer_loop loop;
+    stack::push(L, [&](std::uint64_t delay)
+                { return loop.sleep(delay); });
+    lua_setglobal(L, "sleep");
+
+    coroutine_reference coroutine = load("sleep(1) error('failed')");
+    script_task task = coroutine.resume_async();
+    loop.run();
+    ASSERT_TRUE(task.is_done());
+    EXPECT_THROW(task.get_results(), runtime_error);
+}
+#endif
@@ -0,0 +1,53 @@
+#include <easylua/expected.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace easylua;
+
+TEST(error, call_failed_keeps_message)
+{
+    const error failure = error::call_failed("rule failed", true);
+    const error copy = failure;
+    EXPECT_EQ(error_code::budget_exceeded, copy.get_code());
+    EXPECT_EQ("rule failed", copy.message());
+    EXPECT_THROW(copy.raise(), budget_exceeded);
+}
+
+TEST(error, type_mismatch_raises_type_error)
+{
+    const error mismatch = error::type_mismatch(2, LUA_TSTRING, LUA_TTABLE);
+    EXPECT_EQ("Type mismatch at index 2: expected table, got string", mismatch.message());
+
+    try
+    {
+        mismatch.raise();
+    }
+    catch (const type_error &e)
+    {
+        EXPECT_EQ(2, e.get_index());
+        EXPECT_EQ(LUA_TSTRING, e.get_actual_type());
+        EXPECT_EQ(LUA_TTABLE, e.get_expected_type());
+    }
+}
+
+TEST(expected, holds_value_or_error)
+{
+    expected<std::string> value(std::string("abc"));
+    ASSERT_TRUE(value.has_value());
+    EXPECT_EQ(3u, value->size());
+    EXPECT_EQ("abc", std::move(value).value());
+
+    const expected<std::string> failure(error::type_mismatch(-1, LUA_TNIL, LUA_TSTRING));
+    EXPECT_FALSE(failure.has_value());
+    EXPECT_EQ("default", failure.value_or("default"));
+    EXPECT_THROW(failure.value(), type_error);
+}
+
+TEST(expected, void_result)
+{
+    EXPECT_TRUE(expected<void>());
+    EXPECT_NO_THROW(expected<void>().value());
+    EXPECT_THROW(expected<void>(error::invalid_index()).value(), invalid_argument);
+}
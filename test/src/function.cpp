@@ -1,5 +1,9 @@
 #include <easylua/function.hpp>
 
+#include <optional>
+#include <string>
+#include <tuple>
+
 #include <gtest/gtest.h>
 
 using namespace easylua;
@@ -121,4 +125,230 @@ TEST(unsafe_function_reference, call_with_parameter_and_return)
     ASSERT_EQ(45, std::get<2>(result));
 
     lua_close(L);
-}
\ No newline at end of file
+}
+TEST(safe_function_reference, call_does_not_copy_arguments)
+{
+    struct copy_counter
+    {
+        copy_counter(int *copies) : copies(copies) {}
+        copy_counter(const copy_counter &other) : copies(other.copies) { ++*copies; }
+        copy_counter(copy_counter &&other) = default;
+
+        int *copies;
+    };
+
+    lua_State *L = luaL_newstate();
+    ASSERT_EQ(0, luaL_dostring(L, "function f(a, b) end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    {
+        int copies = 0;
+        easylua::safe_function_reference f(L);
+        f(copy_counter(&copies), copy_counter(&copies));
+        EXPECT_EQ(0, copies);
+    }
+
+    lua_close(L);
+}
+
+TEST(safe_function_reference, typed_call_single_result)
+{
+    lua_State *L = luaL_newstate();
+    ASSERT_EQ(0, luaL_dostring(L, "function f(a, b) return a + b, 'ignored' end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    {
+        easylua::safe_function_reference f(L);
+        EXPECT_EQ(3, f.call<int>(1, 2));
+        EXPECT_EQ(0, lua_gettop(L));
+    }
+
+    lua_close(L);
+}
+
+TEST(safe_function_reference, typed_call_tuple_result)
+{
+    lua_State *L = luaL_newstate();
+    ASSERT_EQ(0, luaL_dostring(L, "function f(a) return a + 1, 'abc', a * 2 end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    {
+        easylua::safe_function_reference f(L);
+        const auto [a, b, c] = f.call<std::tuple<int, std::string, double>>(20);
+        EXPECT_EQ(21, a);
+        EXPECT_EQ("abc", b);
+        EXPECT_EQ(40.0, c);
+        EXPECT_EQ(0, lua_gettop(L));
+    }
+
+    lua_close(L);
+}
+
+TEST(safe_function_reference, typed_call_missing_results_are_nil)
+{
+    lua_State *L = luaL_newstate();
+    ASSERT_EQ(0, luaL_dostring(L, "function f() return 1 end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    {
+        easylua::safe_function_reference f(L);
+        const auto [a, b] = f.call<std::tuple<int, std::optional<int>>>();
+        EXPECT_EQ(1, a);
+        EXPECT_FALSE(b.has_value());
+    }
+
+    lua_close(L);
+}
+
+TEST(safe_function_reference, typed_call_void)
+{
+    lua_State *L = luaL_newstate();
+    ASSERT_EQ(0, luaL_dostring(L, "function f(a) x = a return 1, 2, 3 end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    {
+        easylua::safe_function_reference f(L);
+        f.call<void>(5);
+        EXPECT_EQ(0, lua_gettop(L));
+        lua_getglobal(L, "x");
+        EXPECT_EQ(5, lua_tointeger(L, -1));
+        lua_pop(L, 1);
+    }
+
+    lua_close(L);
+}
+
+TEST(safe_function_reference, typed_call_restores_stack_on_error)
+{
+    lua_State *L = luaL_newstate();
+    ASSERT_EQ(0, luaL_dostring(L, "function f(fail) if fail then error('failed') end return 'text' end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    {
+        easylua::safe_function_reference f(L);
+        EXPECT_THROW(f.call<int>(true), easylua::runtime_error);
+        EXPECT_EQ(0, lua_gettop(L));
+        EXPECT_THROW(f.call<int>(false), easylua::type_error);
+        EXPECT_EQ(0, lua_gettop(L));
+    }
+
+    lua_close(L);
+}
+
+TEST(safe_function_reference, typed_call_pops_value_that_is_not_a_function)
+{
+    lua_State *L = luaL_newstate();
+    lua_pushinteger(L, 1);
+    lua_pushinteger(L, 2);
+    EXPECT_THROW(easylua::detail::call_typed<int>(L, 3), easylua::type_error);
+    EXPECT_EQ(1, lua_gettop(L));
+    lua_close(L);
+}
+
+TEST(unsafe_function_reference, typed_call)
+{
+    lua_State *L = luaL_newstate();
+    ASSERT_EQ(0, luaL_dostring(L, "function f(a) return a * 2 end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    easylua::unsafe_function_reference f(L, 1);
+    EXPECT_EQ(84, f.call<int>(42));
+    EXPECT_EQ(1, lua_gettop(L));
+
+    lua_close(L);
+}
+
+TEST(safe_function_reference, try_call_returns_value)
+{
+    lua_State *L = luaL_newstate();
+    ASSERT_EQ(0, luaL_dostring(L, "function f(a) if a > 0 then return a * 2 end return nil end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    {
+        easylua::safe_function_reference f(L);
+        easylua::expected<int> result = f.try_call<int>(21);
+        ASSERT_TRUE(result);
+        EXPECT_EQ(42, *result);
+
+        result = f.try_call<int>(0);
+        ASSERT_FALSE(result);
+        EXPECT_EQ(easylua::error_code::type_mismatch, result.get_error().get_code());
+        EXPECT_EQ(LUA_TNIL, result.get_error().get_actual_type());
+        EXPECT_EQ(-1, result.value_or(-1));
+        EXPECT_EQ(0, lua_gettop(L));
+    }
+
+    lua_close(L);
+}
+
+TEST(safe_function_reference, try_call_returns_lua_errors)
+{
+    lua_State *L = luaL_newstate();
+    luaL_openlibs(L);
+    ASSERT_EQ(0, luaL_dostring(L, "function f() error('rule failed', 0) end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    {
+        easylua::safe_function_reference f(L);
+        const easylua::expected<void> result = f.try_call<void>();
+        ASSERT_FALSE(result);
+        EXPECT_EQ(easylua::error_code::call_failed, result.get_error().get_code());
+        EXPECT_EQ("rule failed", result.get_error().message());
+        EXPECT_THROW(result.value(), easylua::runtime_error);
+        EXPECT_EQ(0, lua_gettop(L));
+    }
+
+    lua_close(L);
+}
+
+TEST(safe_function_reference, try_call_errors_keep_their_message)
+{
+    lua_State *L = luaL_newstate();
+    luaL_openlibs(L);
+    ASSERT_EQ(0, luaL_dostring(L, "function f(message) error(message, 0) end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    {
+        easylua::safe_function_reference f(L);
+        const easylua::expected<void> first = f.try_call<void>("first");
+        const easylua::expected<void> second = f.try_call<void>("second");
+        EXPECT_EQ("first", first.get_error().message());
+        EXPECT_EQ("second", second.get_error().message());
+    }
+
+    lua_close(L);
+}
+
+TEST(safe_function_reference, try_call_tuple_result)
+{
+    lua_State *L = luaL_newstate();
+    ASSERT_EQ(0, luaL_dostring(L, "function f(a) return a, 'x' end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    {
+        easylua::safe_function_reference f(L);
+        const auto result = f.try_call<std::tuple<int, std::string>>(7);
+        ASSERT_TRUE(result);
+        EXPECT_EQ(std::make_tuple(7, std::string("x")), *result);
+
+        const auto mismatch = f.try_call<std::tuple<int, int>>(7);
+        ASSERT_FALSE(mismatch);
+        EXPECT_EQ(LUA_TSTRING, mismatch.get_error().get_actual_type());
+        EXPECT_EQ(0, lua_gettop(L));
+    }
+
+    lua_close(L);
+}
+
+TEST(unsafe_function_reference, try_call)
+{
+    lua_State *L = luaL_newstate();
+    ASSERT_EQ(0, luaL_dostring(L, "function f(a) return a + 1 end"));
+    ASSERT_EQ(LUA_TFUNCTION, lua_getglobal(L, "f"));
+
+    easylua::unsafe_function_reference f(L, 1);
+    EXPECT_EQ(3.5, f.try_call<double>(2.5).value());
+    EXPECT_EQ(1, lua_gettop(L));
+
+    lua_close(L);
+}
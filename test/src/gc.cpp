@@ -0,0 +1,144 @@
+#include <easylua/gc.hpp>
+#include <easylua/state.hpp>
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+using namespace easylua;
+
+namespace
+{
+    void make_garbage(lua_State *L, int count)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            lua_createtable(L, 8, 0);
+            lua_pop(L, 1);
+        }
+    }
+}
+
+TEST(gc, controller_throws_on_null_state)
+{
+    EXPECT_THROW(gc_controller(nullptr), invalid_argument);
+}
+
+TEST(gc, stop_and_restart)
+{
+    state lua;
+    EXPECT_TRUE(lua.gc().is_running());
+    lua.gc().stop();
+    EXPECT_FALSE(lua.gc().is_running());
+    lua.gc().restart();
+    EXPECT_TRUE(lua.gc().is_running());
+}
+
+TEST(gc, collect_frees_garbage)
+{
+    state lua;
+    lua.gc().stop();
+    const std::size_t before = lua.gc().get_memory();
+    make_garbage(lua, 1000);
+    EXPECT_GT(lua.gc().get_memory(), before);
+
+    lua.gc().collect();
+    EXPECT_LE(lua.gc().get_memory(), before);
+}
+
+TEST(gc, step_finishes_a_cycle)
+{
+    state lua;
+    lua.gc().stop();
+    make_garbage(lua, 1000);
+
+    bool finished = false;
+    for (int i = 0; i < 100000 && !finished; i++)
+        finished = lua.gc().step();
+
+    EXPECT_TRUE(finished);
+}
+
+TEST(gc, set_mode_returns_previous_mode)
+{
+    state lua;
+    EXPECT_EQ(gc_mode::incremental, lua.gc().set_mode(gc_mode::generational));
+    EXPECT_EQ(gc_mode::generational, lua.gc().set_incremental(150, 200));
+    EXPECT_EQ(gc_mode::incremental, lua.gc().set_generational(20, 100));
+    EXPECT_EQ(gc_mode::generational, lua.gc().set_mode(gc_mode::generational));
+}
+
+TEST(gc, scheduler_stops_and_restores_automatic_collection)
+{
+    state lua;
+    {
+        gc_scheduler scheduler(lua, std::chrono::microseconds(100));
+        EXPECT_FALSE(lua.gc().is_running());
+    }
+    EXPECT_TRUE(lua.gc().is_running());
+
+    lua.gc().stop();
+    {
+        gc_scheduler scheduler(lua, std::chrono::microseconds(100));
+    }
+    EXPECT_FALSE(lua.gc().is_running());
+}
+
+TEST(gc, scheduler_rejects_negative_arguments)
+{
+    state lua;
+    EXPECT_THROW(gc_scheduler(lua, std::chrono::microseconds(-1)), invalid_argument);
+    EXPECT_THROW(gc_scheduler(lua, std::chrono::microseconds(1), -1), invalid_argument);
+}
+
+TEST(gc, scheduler_collects_and_records_statistics)
+{
+    state lua;
+    gc_scheduler scheduler(lua, std::chrono::milliseconds(50));
+    make_garbage(lua, 1000);
+    const std::size_t before = lua.gc().get_memory();
+
+    bool finished = false;
+    for (int i = 0; i < 1000 && !finished; i++)
+        finished = scheduler.run();
+
+    EXPECT_TRUE(finished);
+    EXPECT_LT(lua.gc().get_memory(), before);
+
+    const gc_scheduler::statistics &statistics = scheduler.get_statistics();
+    EXPECT_GE(statistics.runs, 1u);
+    EXPECT_GE(statistics.steps, statistics.runs);
+    EXPECT_EQ(1u, statistics.cycles);
+    EXPECT_GE(statistics.total_time, statistics.max_time);
+    EXPECT_GE(statistics.max_time, statistics.last_time);
+
+    scheduler.reset_statistics();
+    EXPECT_EQ(0u, scheduler.get_statistics().runs);
+}
+
+TEST(gc, scheduler_with_zero_budget_runs_one_step)
+{
+    state lua;
+    gc_scheduler scheduler(lua, std::chrono::nanoseconds(0));
+    make_garbage(lua, 1000);
+
+    scheduler.run();
+    EXPECT_EQ(1u, scheduler.get_statistics().steps);
+}
+
+TEST(gc, scheduler_runs_one_minor_collection_in_generational_mode)
+{
+    state lua;
+    lua.gc().set_generational();
+    gc_scheduler scheduler(lua, std::chrono::seconds(10));
+    make_garbage(lua, 1000);
+
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_TRUE(scheduler.run());
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(1));
+
+    const gc_scheduler::statistics &statistics = scheduler.get_statistics();
+    EXPECT_EQ(1u, statistics.steps);
+    EXPECT_EQ(1u, statistics.cycles);
+    EXPECT_EQ(gc_mode::generational, lua.gc().set_mode(gc_mode::generational));
+}
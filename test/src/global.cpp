@@ -0,0 +1,81 @@
+#include <easylua/function.hpp>
+#include <easylua/state.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace easylua;
+
+TEST(global, constructor_throws_on_null_state)
+{
+    EXPECT_THROW(global(nullptr, "x"), invalid_argument);
+}
+
+TEST(global, get)
+{
+    state lua;
+    ASSERT_TRUE(lua.run("x = 42"));
+    global x = lua.get_global("x");
+    int value = x;
+    EXPECT_EQ(42, value);
+    EXPECT_EQ(0, lua_gettop(lua));
+}
+
+TEST(global, get_reflects_changes)
+{
+    state lua;
+    global x = lua.get_global("x");
+    ASSERT_TRUE(lua.run("x = 1"));
+    EXPECT_EQ(1, x.get<int>());
+    ASSERT_TRUE(lua.run("x = 2"));
+    EXPECT_EQ(2, x.get<int>());
+}
+
+TEST(global, get_throws_on_wrong_type)
+{
+    state lua;
+    global x = lua.get_global("x");
+    EXPECT_THROW(x.get<int>(), type_error);
+    EXPECT_EQ(0, lua_gettop(lua));
+}
+
+TEST(global, set)
+{
+    state lua;
+    global x = lua.get_global("x");
+    x = std::string("hello");
+    lua_getglobal(lua, "x");
+    EXPECT_STREQ("hello", lua_tostring(lua, -1));
+    lua_pop(lua, 1);
+
+    x.set(5);
+    EXPECT_EQ(5, lua["x"].operator int());
+}
+
+TEST(global, get_function)
+{
+    state lua;
+    ASSERT_TRUE(lua.run("function f(a) return a * 2 end"));
+    global f = lua.get_global("f");
+    safe_function_reference function = f;
+    int result = function(21);
+    EXPECT_EQ(42, result);
+}
+
+TEST(global, move)
+{
+    state lua;
+    ASSERT_TRUE(lua.run("x = 3"));
+    global x = lua.get_global("x");
+    global y(std::move(x));
+    EXPECT_EQ(3, y.get<int>());
+}
+
+TEST(global, name_with_embedded_nul)
+{
+    state lua;
+    global x(lua, std::string_view("a\0b", 3));
+    x = 7;
+    EXPECT_EQ(7, x.get<int>());
+    lua_getglobal(lua, "a");
+    EXPECT_TRUE(lua_isnil(lua, -1));
+}
@@ -0,0 +1,128 @@
+#include <easylua/libraries.hpp>
+#include <easylua/state.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace easylua;
+
+namespace
+{
+    bool is_global_set(lua_State *L, const char *name)
+    {
+        lua_pushglobaltable(L);
+        lua_pushstring(L, name);
+        const bool set = lua_rawget(L, -2) != LUA_TNIL;
+        lua_pop(L, 2);
+        return set;
+    }
+
+    std::string run_string(state &lua, const char *code)
+    {
+        if (luaL_dostring(lua, code) != LUA_OK)
+            return std::string("error: ") + lua_tostring(lua, -1);
+
+        std::string result = lua_isstring(lua, -1) ? lua_tostring(lua, -1) : "";
+        lua_settop(lua, 0);
+        return result;
+    }
+}
+
+TEST(libraries, open_libraries_throws_on_null_state)
+{
+    EXPECT_THROW(open_libraries(nullptr, library::all), invalid_argument);
+}
+
+TEST(libraries, eager_opens_only_selected)
+{
+    state lua(library::base | library::string | library::math);
+    EXPECT_TRUE(is_global_set(lua, "print"));
+    EXPECT_TRUE(is_global_set(lua, "string"));
+    EXPECT_TRUE(is_global_set(lua, "math"));
+    EXPECT_FALSE(is_global_set(lua, "io"));
+    EXPECT_FALSE(is_global_set(lua, "os"));
+    EXPECT_FALSE(is_global_set(lua, "package"));
+    EXPECT_EQ(0, lua_gettop(lua));
+}
+
+TEST(libraries, all_matches_openlibs)
+{
+    state lua(library::all);
+    for (const char *name : {"_G", "package", "coroutine", "table", "io", "os", "string", "math", "utf8", "debug"})
+        EXPECT_TRUE(is_global_set(lua, name)) << name;
+}
+
+TEST(libraries, lazy_builds_library_on_first_use)
+{
+    state lua(library::base | library::string | library::math, library_mode::lazy);
+    EXPECT_TRUE(is_global_set(lua, "print"));
+    EXPECT_FALSE(is_global_set(lua, "math"));
+    EXPECT_FALSE(is_global_set(lua, "string"));
+
+    EXPECT_EQ("3", run_string(lua, "return tostring(math.floor(3.5))"));
+    EXPECT_TRUE(is_global_set(lua, "math"));
+    EXPECT_FALSE(is_global_set(lua, "string"));
+    EXPECT_EQ(0, lua_gettop(lua));
+}
+
+TEST(libraries, lazy_does_not_expose_unselected_libraries)
+{
+    state lua(library::base | library::math, library_mode::lazy);
+    EXPECT_EQ("nil", run_string(lua, "return tostring(io)"));
+    EXPECT_EQ("nil", run_string(lua, "return tostring(undefined_global)"));
+}
+
+TEST(libraries, lazy_string_methods)
+{
+    state lua(library::base | library::string, library_mode::lazy);
+    EXPECT_EQ("HELLO", run_string(lua, "return ('hello'):upper()"));
+    EXPECT_TRUE(is_global_set(lua, "string"));
+    EXPECT_EQ("abc", run_string(lua, "local s = 'abc' return s:sub(1, 3)"));
+}
+
+TEST(libraries, lazy_string_arithmetic)
+{
+    state lua(library::base | library::string, library_mode::lazy);
+    EXPECT_EQ("11", run_string(lua, "return tostring('10' + 1)"));
+    EXPECT_TRUE(is_global_set(lua, "string"));
+    EXPECT_EQ("-2", run_string(lua, "return tostring(-'2')"));
+    EXPECT_EQ("3", run_string(lua, "return tostring('10' // 3)"));
+}
+
+TEST(libraries, lazy_string_arithmetic_opens_library_first)
+{
+    state lua(library::base | library::string, library_mode::lazy);
+    EXPECT_EQ("0.5", run_string(lua, "return tostring(1 / '2')"));
+    EXPECT_EQ("HI", run_string(lua, "return ('hi'):upper()"));
+}
+
+TEST(libraries, lazy_require)
+{
+    state lua(library::base | library::package | library::table | library::utf8, library_mode::lazy);
+    EXPECT_EQ("true", run_string(lua, "local t = require('table') return tostring(t == table)"));
+    EXPECT_EQ("3", run_string(lua, "return tostring(require('utf8').len('abc'))"));
+}
+
+TEST(libraries, lazy_removes_hook_when_everything_is_open)
+{
+    state lua(library::base | library::math, library_mode::lazy);
+    EXPECT_EQ("1", run_string(lua, "return tostring(math.abs(-1))"));
+    EXPECT_EQ("nil", run_string(lua, "return tostring(undefined_global)"));
+
+    lua_pushglobaltable(lua);
+    EXPECT_FALSE(lua_getmetatable(lua, -1));
+    lua_pop(lua, 1);
+}
+
+TEST(libraries, lazy_falls_back_to_eager_with_global_metatable)
+{
+    state lua;
+    lua_pushglobaltable(lua);
+    lua_newtable(lua);
+    lua_setmetatable(lua, -2);
+    lua_pop(lua, 1);
+
+    lua.open_libraries(library::math, library_mode::lazy);
+    EXPECT_TRUE(is_global_set(lua, "math"));
+}
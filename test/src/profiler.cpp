@@ -0,0 +1,204 @@
+#include <easylua/budget.hpp>
+#include <easylua/profiler.hpp>
+#include <easylua/state.hpp>
+
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+class Profiler : public ::testing::Test
+{
+public:
+    Profiler()
+    {
+        L = luaL_newstate();
+        if (!L)
+            throw std::runtime_error("Could not create Lua state");
+
+        luaL_openlibs(L);
+    }
+
+    ~Profiler() { lua_close(L); }
+
+protected:
+    lua_State *L;
+};
+
+using namespace easylua;
+
+static const char *const workload = R"(local function hot()
+    local sum = 0
+    for i = 1, 200000 do
+        sum = sum + i % 7
+    end
+    return sum
+end
+
+local function outer()
+    local sum = hot()
+    return sum
+end
+
+for i = 1, 5 do
+    outer()
+end
+)";
+
+TEST_F(Profiler, constructor_throws_on_invalid_arguments)
+{
+    EXPECT_THROW(profiler(nullptr), invalid_argument);
+    EXPECT_THROW(profiler(L, 0), invalid_argument);
+    EXPECT_THROW(profiler(L, 100, 0), invalid_argument);
+}
+
+TEST_F(Profiler, does_not_sample_until_started)
+{
+    profiler profiler(L, 100);
+    EXPECT_FALSE(profiler.is_running());
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, workload));
+    EXPECT_EQ(0u, profiler.get_sample_count());
+    EXPECT_EQ(nullptr, lua_gethook(L));
+}
+
+TEST_F(Profiler, samples_hot_location)
+{
+    profiler profiler(L, 100);
+    profiler.start();
+    EXPECT_TRUE(profiler.is_running());
+    ASSERT_EQ(LUA_OK, luaL_loadbuffer(L, workload, std::char_traits<char>::length(workload), "=workload"));
+    ASSERT_EQ(LUA_OK, lua_pcall(L, 0, 0, 0));
+    profiler.stop();
+
+    EXPECT_GT(profiler.get_sample_count(), 100u);
+
+    const auto top = profiler.get_top(1);
+    ASSERT_EQ(1u, top.size());
+    EXPECT_EQ(0u, top[0].location.find("workload:"));
+    EXPECT_GT(top[0].self_samples, profiler.get_sample_count() / 2);
+    EXPECT_GE(top[0].total_samples, top[0].self_samples);
+}
+
+TEST_F(Profiler, writes_folded_stacks)
+{
+    profiler profiler(L, 100);
+    profiler.start();
+    ASSERT_EQ(LUA_OK, luaL_loadbuffer(L, workload, std::char_traits<char>::length(workload), "=workload"));
+    ASSERT_EQ(LUA_OK, lua_pcall(L, 0, 0, 0));
+    profiler.stop();
+
+    std::ostringstream out;
+    profiler.write_folded(out);
+    const std::string folded = out.str();
+
+    // The main chunk calls outer on line 15, which calls hot on line 10.
+    EXPECT_NE(std::string::npos, folded.find("workload:15;workload:10;workload:"));
+
+    std::istringstream lines(folded);
+    std::string line;
+    std::uint64_t total = 0;
+    while (std::getline(lines, line))
+    {
+        const auto space = line.rfind(' ');
+        ASSERT_NE(std::string::npos, space);
+        total += std::stoull(line.substr(space + 1));
+    }
+
+    EXPECT_EQ(profiler.get_sample_count(), total);
+}
+
+TEST_F(Profiler, writes_report)
+{
+    profiler profiler(L, 100);
+    profiler.start();
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, workload));
+    profiler.stop();
+
+    std::ostringstream out;
+    profiler.write_report(out, 3);
+    std::istringstream lines(out.str());
+    std::string line;
+    int count = 0;
+    while (std::getline(lines, line))
+        count++;
+
+    EXPECT_GE(count, 2);
+    EXPECT_LE(count, 4);
+}
+
+TEST_F(Profiler, stop_restores_previous_hook)
+{
+    const lua_Hook hook = [](lua_State *, lua_Debug *) {};
+    lua_sethook(L, hook, LUA_MASKCOUNT, 10);
+
+    {
+        profiler profiler(L, 100);
+        profiler.start();
+        EXPECT_NE(hook, lua_gethook(L));
+    }
+
+    EXPECT_EQ(hook, lua_gethook(L));
+    EXPECT_EQ(10, lua_gethookcount(L));
+}
+
+TEST_F(Profiler, does_not_start_while_a_budget_is_enforced)
+{
+    execution_budget budget;
+    budget.max_instructions = 1'000'000'000;
+    const budget_scope scope(L, budget);
+
+    profiler profiler(L, 100);
+    EXPECT_THROW(profiler.start(), invalid_operation);
+    EXPECT_EQ(&detail::budget_hook, lua_gethook(L));
+}
+
+TEST_F(Profiler, stop_keeps_a_budget_hook_installed_after_start)
+{
+    profiler profiler(L, 100);
+    profiler.start();
+    {
+        execution_budget budget;
+        budget.max_instructions = 10000;
+        const budget_scope scope(L, budget);
+        profiler.stop();
+        EXPECT_EQ(&detail::budget_hook, lua_gethook(L));
+        EXPECT_NE(LUA_OK, luaL_dostring(L, "while true do end"));
+        EXPECT_TRUE(scope.is_exceeded());
+    }
+
+    // The scope restored the hook of the stopped profiler, which removes itself.
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, workload));
+    EXPECT_EQ(nullptr, lua_gethook(L));
+}
+
+TEST_F(Profiler, can_be_toggled_and_reset)
+{
+    profiler profiler(L, 100);
+    profiler.start();
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, workload));
+    profiler.stop();
+    const auto samples = profiler.get_sample_count();
+    ASSERT_GT(samples, 0u);
+
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, workload));
+    EXPECT_EQ(samples, profiler.get_sample_count());
+
+    profiler.start();
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, workload));
+    profiler.stop();
+    EXPECT_GT(profiler.get_sample_count(), samples);
+
+    profiler.reset();
+    EXPECT_EQ(0u, profiler.get_sample_count());
+    EXPECT_TRUE(profiler.get_top(10).empty());
+}
+
+TEST_F(Profiler, only_one_profiler_runs_per_state)
+{
+    profiler first(L, 100);
+    profiler second(L, 100);
+    first.start();
+    EXPECT_THROW(second.start(), invalid_operation);
+    first.stop();
+    EXPECT_NO_THROW(second.start());
+}
@@ -1,5 +1,8 @@
 #include <easylua/reference.hpp>
 
+#include <memory>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 struct mock_unsafe_reference : easylua::unsafe_reference
@@ -68,7 +71,160 @@ TEST(safe_reference, constructor_throws_on_invalid_type)
     lua_close(L);
 }
 
-// TODO copy, move
+TEST(safe_reference, constructor_pops_top)
+{
+    lua_State *L = luaL_newstate();
+    lua_pushnumber(L, 5);
+    {
+        mock_safe_reference ref(L, -1, LUA_TNUMBER);
+        EXPECT_EQ(0, lua_gettop(L));
+    }
+    lua_close(L);
+}
+
+TEST(safe_reference, constructor_removes_value_below_top)
+{
+    lua_State *L = luaL_newstate();
+    lua_pushnumber(L, 5);
+    lua_pushstring(L, "top");
+    {
+        mock_safe_reference ref(L, 1, LUA_TNUMBER);
+        EXPECT_EQ(1, lua_gettop(L));
+        EXPECT_STREQ("top", lua_tostring(L, 1));
+        ref.push();
+        EXPECT_EQ(5, lua_tonumber(L, -1));
+    }
+    lua_close(L);
+}
+
+TEST(safe_reference, constructor_copies_pseudo_index)
+{
+    lua_State *L = luaL_newstate();
+    {
+        mock_safe_reference ref(L, LUA_REGISTRYINDEX, LUA_TTABLE);
+        EXPECT_EQ(0, lua_gettop(L));
+        ref.push();
+        EXPECT_TRUE(lua_rawequal(L, -1, LUA_REGISTRYINDEX));
+    }
+    lua_close(L);
+}
+
+TEST(safe_reference, copy_shares_slot)
+{
+    lua_State *L = luaL_newstate();
+    lua_pushnumber(L, 5);
+    {
+        mock_safe_reference ref(L, -1, LUA_TNUMBER);
+        const int slot = ref.reference();
+        {
+            mock_safe_reference copy(ref);
+            EXPECT_EQ(slot, copy.reference());
+
+            mock_safe_reference assigned = copy;
+            EXPECT_EQ(slot, assigned.reference());
+        }
+
+        // The slot is still held by the original.
+        lua_rawgeti(L, LUA_REGISTRYINDEX, slot);
+        EXPECT_EQ(5, lua_tonumber(L, -1));
+        lua_pop(L, 1);
+
+        ref.push();
+        EXPECT_EQ(5, lua_tonumber(L, -1));
+    }
+    lua_close(L);
+}
+
+TEST(safe_reference, last_copy_releases_slot)
+{
+    lua_State *L = luaL_newstate();
+    lua_pushnumber(L, 5);
+    auto ref = std::make_unique<mock_safe_reference>(L, -1, LUA_TNUMBER);
+    const int slot = ref->reference();
+    auto copy = std::make_unique<mock_safe_reference>(*ref);
+    ref.reset();
+
+    lua_rawgeti(L, LUA_REGISTRYINDEX, slot);
+    EXPECT_EQ(LUA_TNUMBER, lua_type(L, -1));
+    EXPECT_EQ(5, lua_tonumber(L, -1));
+    lua_pop(L, 1);
+
+    copy.reset();
+
+    // A new reference reuses the released slot.
+    lua_pushnumber(L, 6);
+    {
+        mock_safe_reference other(L, -1, LUA_TNUMBER);
+        EXPECT_EQ(slot, other.reference());
+    }
+    lua_close(L);
+}
+
+TEST(safe_reference, move)
+{
+    lua_State *L = luaL_newstate();
+    lua_pushnumber(L, 5);
+    {
+        mock_safe_reference ref(L, -1, LUA_TNUMBER);
+        const int slot = ref.reference();
+        mock_safe_reference moved(std::move(ref));
+        EXPECT_EQ(slot, moved.reference());
+        EXPECT_FALSE(ref.is_valid());
+        EXPECT_THROW(ref.push(), easylua::runtime_error);
+
+        lua_pushnumber(L, 6);
+        mock_safe_reference assigned(L, -1, LUA_TNUMBER);
+        assigned = std::move(moved);
+        EXPECT_EQ(slot, assigned.reference());
+        EXPECT_FALSE(moved.is_valid());
+        assigned.push();
+        EXPECT_EQ(5, lua_tonumber(L, -1));
+    }
+    lua_close(L);
+}
+
+TEST(safe_reference, reset)
+{
+    lua_State *L = luaL_newstate();
+    lua_pushnumber(L, 5);
+    {
+        mock_safe_reference ref(L, -1, LUA_TNUMBER);
+        mock_safe_reference copy(ref);
+        ref.reset();
+        EXPECT_FALSE(ref.is_valid());
+        EXPECT_TRUE(copy.is_valid());
+        copy.push();
+        EXPECT_EQ(5, lua_tonumber(L, -1));
+    }
+    lua_close(L);
+}
+
+TEST(safe_reference, store_in_vector)
+{
+    lua_State *L = luaL_newstate();
+    std::vector<mock_safe_reference> references;
+    for (int i = 0; i < 100; i++)
+    {
+        lua_pushinteger(L, i);
+        references.emplace_back(L, -1, LUA_TNUMBER);
+    }
+
+    std::vector<mock_safe_reference> copies = references;
+    easylua::reset_references(references.begin(), references.end());
+    for (const auto &reference : references)
+        EXPECT_FALSE(reference.is_valid());
+
+    for (int i = 0; i < 100; i++)
+    {
+        copies[i].push();
+        EXPECT_EQ(i, lua_tointeger(L, -1));
+        lua_pop(L, 1);
+    }
+
+    EXPECT_EQ(0, lua_gettop(L));
+    copies.clear();
+    lua_close(L);
+}
 
 TEST(safe_reference, push)
 {
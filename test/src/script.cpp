@@ -1,5 +1,10 @@
 #include <easylua/script.hpp>
 
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
 #include <gtest/gtest.h>
 
 class Script : public ::testing::Test
@@ -46,4 +51,114 @@ TEST_F(Script, run_string_succeeds)
     lua_getglobal(L, "test");
     ASSERT_EQ(LUA_TNUMBER, lua_type(L, -1));
     ASSERT_EQ(5, lua_tonumber(L, -1));
-}
\ No newline at end of file
+}
+TEST_F(Script, load_string_with_embedded_nul)
+{
+    const std::string code("s = 'a\0b'", 9);
+    ASSERT_TRUE(script::run_string(L, code));
+    lua_getglobal(L, "s");
+    size_t length = 0;
+    lua_tolstring(L, -1, &length);
+    EXPECT_EQ(3, length);
+}
+
+TEST_F(Script, load_buffer_succeeds)
+{
+    std::string_view code = "test = 5 -- trailing data that is not part of the chunk";
+    ASSERT_TRUE(script::load_buffer(L, code.substr(0, 8), "=test"));
+    ASSERT_EQ(LUA_OK, lua_pcall(L, 0, 0, 0));
+    lua_getglobal(L, "test");
+    EXPECT_EQ(5, lua_tointeger(L, -1));
+}
+
+TEST_F(Script, load_buffer_uses_chunkname)
+{
+    const script::load_result result = script::load_buffer(L, "undefined_function()", "=my_chunk");
+    ASSERT_TRUE(result);
+    ASSERT_NE(LUA_OK, lua_pcall(L, 0, 0, 0));
+    EXPECT_EQ(0, std::string(lua_tostring(L, -1)).rfind("my_chunk:1:", 0));
+}
+
+TEST_F(Script, dump_throws_on_wrong_type)
+{
+    lua_pushnumber(L, 5);
+    EXPECT_THROW(script::dump(L), type_error);
+}
+
+TEST_F(Script, dump_throws_on_c_function)
+{
+    lua_pushcfunction(L, [](lua_State *) { return 0; });
+    EXPECT_THROW(script::dump(L), runtime_error);
+}
+
+TEST_F(Script, dump_and_load_buffer_round_trip)
+{
+    ASSERT_TRUE(script::load_string(L, "return 40 + 2"));
+    const std::string bytecode = script::dump(L, -1, true);
+    lua_pop(L, 1);
+    ASSERT_EQ(0, lua_gettop(L));
+
+    ASSERT_TRUE(script::load_buffer(L, bytecode, "=bytecode", script::load_mode::binary));
+    ASSERT_EQ(LUA_OK, lua_pcall(L, 0, 1, 0));
+    EXPECT_EQ(42, lua_tointeger(L, -1));
+}
+
+TEST_F(Script, load_buffer_respects_mode)
+{
+    ASSERT_TRUE(script::load_string(L, "return 1"));
+    const std::string bytecode = script::dump(L);
+    lua_pop(L, 1);
+
+    EXPECT_EQ(script::load_result::result::syntax_error,
+              script::load_buffer(L, bytecode, "=bytecode", script::load_mode::text).get_result());
+    EXPECT_EQ(script::load_result::result::syntax_error,
+              script::load_buffer(L, "return 1", "=text", script::load_mode::binary).get_result());
+}
+
+TEST_F(Script, load_file_mapped_throws_on_empty_path)
+{
+    EXPECT_THROW(script::load_file_mapped(L, ""), invalid_argument);
+}
+
+TEST_F(Script, load_file_mapped_fails_on_missing_file)
+{
+    const script::load_result result = script::load_file_mapped(L, "does_not_exist.lua");
+    EXPECT_EQ(script::load_result::result::file_error, result.get_result());
+    EXPECT_NE(std::string::npos, result.get_error_message().find(std::strerror(ENOENT)));
+}
+
+TEST_F(Script, load_file_mapped_fails_on_directory)
+{
+    const script::load_result result = script::load_file_mapped(L, std::filesystem::temp_directory_path().string());
+    EXPECT_EQ(script::load_result::result::file_error, result.get_result());
+    EXPECT_NE(std::string::npos, result.get_error_message().find("not a regular file"));
+}
+
+TEST_F(Script, load_file_mapped_succeeds)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "easylua_mapped_test.lua";
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "#!/usr/bin/env lua\ntest = 5\nundefined_function()";
+    }
+
+    ASSERT_TRUE(script::load_file_mapped(L, path.string()));
+    ASSERT_NE(LUA_OK, lua_pcall(L, 0, 0, 0));
+
+    // The shebang line is skipped but still counted
+    const std::string error = lua_tostring(L, -1);
+    EXPECT_NE(std::string::npos, error.find(":3:"));
+    lua_getglobal(L, "test");
+    EXPECT_EQ(5, lua_tointeger(L, -1));
+
+    std::filesystem::remove(path);
+}
+
+TEST_F(Script, load_file_mapped_empty_file)
+{
+    const std::filesystem::path path = std::filesystem::temp_directory_path() / "easylua_mapped_empty.lua";
+    std::ofstream(path, std::ios::trunc).close();
+
+    EXPECT_TRUE(script::load_file_mapped(L, path.string()));
+    std::filesystem::remove(path);
+}
@@ -0,0 +1,251 @@
+#include <easylua/snapshot.hpp>
+#include <easylua/state.hpp>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+using namespace easylua;
+
+namespace
+{
+    std::string run_string(lua_State *L, const char *code)
+    {
+        if (luaL_dostring(L, code) != LUA_OK)
+        {
+            std::string error = std::string("error: ") + lua_tostring(L, -1);
+            lua_settop(L, 0);
+            return error;
+        }
+
+        std::string result = lua_isstring(L, -1) ? lua_tostring(L, -1) : "";
+        lua_settop(L, 0);
+        return result;
+    }
+
+    int add_one(lua_State *L)
+    {
+        lua_pushinteger(L, luaL_checkinteger(L, 1) + 1);
+        return 1;
+    }
+
+    bool has_issue(const state_snapshot &snapshot, const std::string &path)
+    {
+        for (const snapshot_issue &issue : snapshot.get_issues())
+        {
+            if (issue.path == path)
+                return true;
+        }
+
+        return false;
+    }
+}
+
+TEST(snapshot, throws_on_null_state)
+{
+    EXPECT_THROW(state_snapshot(nullptr), invalid_argument);
+}
+
+TEST(snapshot, restores_scalars_and_tables)
+{
+    state source(library::all);
+    ASSERT_EQ("", run_string(source, "limits = { max = 10, ratio = 0.5, name = 'rules', enabled = true, [1] = 'first' }"));
+
+    const state_snapshot snapshot(source);
+    EXPECT_TRUE(snapshot.is_complete());
+
+    state copy = snapshot.instantiate();
+    EXPECT_EQ("10 0.5 rules true first", run_string(copy, "return string.format('%d %s %s %s %s', limits.max, limits.ratio, limits.name, "
+                                                            "tostring(limits.enabled), limits[1])"));
+    EXPECT_EQ("integer", run_string(copy, "return math.type(limits.max)"));
+    EXPECT_EQ(0, lua_gettop(copy));
+}
+
+TEST(snapshot, restores_functions)
+{
+    state source(library::all);
+    ASSERT_EQ("", run_string(source, "function score(x) return x * 2 + offset end offset = 3"));
+
+    state copy = state_snapshot(source).instantiate();
+    EXPECT_EQ("13", run_string(copy, "return tostring(score(5))"));
+}
+
+TEST(snapshot, keeps_shared_and_cyclic_tables)
+{
+    state source(library::all);
+    ASSERT_EQ("", run_string(source, "shared = {} a = { s = shared } b = { s = shared } a.self = a"));
+
+    state copy = state_snapshot(source).instantiate();
+    EXPECT_EQ("true true", run_string(copy, "return tostring(a.s == b.s and a.s == shared) .. ' ' .. tostring(a.self == a)"));
+}
+
+TEST(snapshot, keeps_metatables)
+{
+    state source(library::all);
+    ASSERT_EQ("", run_string(source, "vector = setmetatable({}, { __index = function(t, k) return k .. '!' end })"));
+
+    state copy = state_snapshot(source).instantiate();
+    EXPECT_EQ("x!", run_string(copy, "return vector.x"));
+}
+
+TEST(snapshot, shares_upvalues_between_closures)
+{
+    state source(library::all);
+    ASSERT_EQ("", run_string(source, "do local count = 5 function increment() count = count + 1 end function get() return count end end"));
+
+    state copy = state_snapshot(source).instantiate();
+    EXPECT_EQ("7", run_string(copy, "increment() increment() return tostring(get())"));
+
+    // The copies do not share anything with the source.
+    EXPECT_EQ("5", run_string(source, "return tostring(get())"));
+}
+
+TEST(snapshot, restores_library_values_by_name)
+{
+    state source(library::all);
+    ASSERT_EQ("", run_string(source, "fmt = string.format helpers = { upper = string.upper }"));
+
+    state copy = state_snapshot(source).instantiate();
+    EXPECT_EQ("true true", run_string(copy, "return tostring(fmt == string.format) .. ' ' .. tostring(helpers.upper == string.upper)"));
+    EXPECT_EQ("AB", run_string(copy, "return ('ab'):upper()"));
+}
+
+TEST(snapshot, removes_library_fields_that_were_removed)
+{
+    state source(library::all);
+    ASSERT_EQ("", run_string(source, "dofile = nil os.execute = nil package.loaded.debug = nil"));
+
+    const state_snapshot snapshot(source);
+    EXPECT_TRUE(snapshot.is_complete());
+
+    state copy = snapshot.instantiate();
+    EXPECT_EQ("nil nil nil function", run_string(copy, "return tostring(dofile) .. ' ' .. tostring(os.execute) .. ' ' .. "
+                                                       "tostring(package.loaded.debug) .. ' ' .. type(os.time)"));
+}
+
+TEST(snapshot, captures_library_fields_that_were_changed)
+{
+    state source(library::all);
+    ASSERT_EQ("", run_string(source, "math.pi = 3 string.format = function() return 'custom' end "
+                                     "string.trim = function(s) return (s:gsub('^%s+', '')) end package.loaded.rules = { level = 4 }"));
+
+    const state_snapshot snapshot(source);
+    EXPECT_TRUE(snapshot.is_complete());
+
+    state copy = snapshot.instantiate();
+    EXPECT_EQ("3", run_string(copy, "return tostring(math.pi)"));
+    EXPECT_EQ("custom", run_string(copy, "return string.format('%d', 1)"));
+    EXPECT_EQ("a", run_string(copy, "return ('  a'):trim()"));
+    EXPECT_EQ("4", run_string(copy, "return tostring(require('rules').level)"));
+    EXPECT_EQ("true", run_string(copy, "return tostring(package.loaded.string == string)"));
+}
+
+TEST(snapshot, captures_replaced_library_tables)
+{
+    state source(library::all);
+    ASSERT_EQ("", run_string(source, "os = { clock = os.clock, name = 'sandbox' }"));
+
+    const state_snapshot snapshot(source);
+    EXPECT_TRUE(snapshot.is_complete());
+
+    state copy = snapshot.instantiate();
+    EXPECT_EQ("sandbox nil number", run_string(copy, "return os.name .. ' ' .. tostring(os.execute) .. ' ' .. type(os.clock())"));
+}
+
+TEST(snapshot, reports_values_that_cannot_be_captured)
+{
+    state source(library::all);
+    lua_pushcfunction(source, &add_one);
+    lua_setglobal(source, "add_one");
+    lua_newuserdata(source, 4);
+    lua_setglobal(source, "blob");
+    ASSERT_EQ("", run_string(source, "config = { co = coroutine.create(print), level = 2 }"));
+
+    const state_snapshot snapshot(source);
+    EXPECT_FALSE(snapshot.is_complete());
+    EXPECT_EQ(3u, snapshot.get_issues().size());
+    EXPECT_TRUE(has_issue(snapshot, "add_one"));
+    EXPECT_TRUE(has_issue(snapshot, "blob"));
+    EXPECT_TRUE(has_issue(snapshot, "config.co"));
+
+    // The values that could be captured are still restored.
+    state copy = snapshot.instantiate();
+    EXPECT_EQ("2 nil", run_string(copy, "return config.level .. ' ' .. tostring(config.co)"));
+}
+
+TEST(snapshot, captures_registered_functions)
+{
+    state source(library::all);
+    lua_pushcfunction(source, &add_one);
+    lua_setglobal(source, "add_one");
+
+    snapshot_options options;
+    options.functions.emplace_back("add_one", &add_one);
+    const state_snapshot snapshot(source, options);
+    EXPECT_TRUE(snapshot.is_complete());
+
+    state copy = snapshot.instantiate();
+    EXPECT_EQ("4", run_string(copy, "return tostring(add_one(3))"));
+}
+
+TEST(snapshot, strict_throws_with_the_paths)
+{
+    state source(library::all);
+    lua_newuserdata(source, 4);
+    lua_setglobal(source, "blob");
+
+    snapshot_options options;
+    options.strict = true;
+    try
+    {
+        state_snapshot snapshot(source, options);
+        FAIL() << "expected invalid_operation";
+    }
+    catch (const invalid_operation &e)
+    {
+        EXPECT_NE(std::string::npos, std::string(e.what()).find("blob"));
+    }
+}
+
+TEST(snapshot, opens_only_the_captured_libraries)
+{
+    state source(library::base | library::string);
+    ASSERT_EQ("", run_string(source, "greeting = string.rep('a', 3)"));
+
+    snapshot_options options;
+    options.libraries = library::base | library::string;
+    const state_snapshot snapshot(source, options);
+    EXPECT_TRUE(snapshot.is_complete());
+
+    state copy = snapshot.instantiate();
+    EXPECT_EQ("aaa nil", run_string(copy, "return greeting .. ' ' .. tostring(io)"));
+}
+
+TEST(snapshot, restores_into_many_states)
+{
+    state source(library::all);
+    ASSERT_EQ("", run_string(source, "counter = { value = 0 } function bump() counter.value = counter.value + 1 return counter.value end"));
+
+    const state_snapshot snapshot(source, snapshot_options{library::all, {}, true, false});
+    for (int i = 0; i < 3; i++)
+    {
+        state copy = snapshot.instantiate();
+        EXPECT_EQ("1", run_string(copy, "return tostring(bump())"));
+    }
+}
+
+TEST(snapshot, leaves_the_stack_unchanged)
+{
+    state source(library::all);
+    ASSERT_EQ("", run_string(source, "x = { 1, 2, 3 }"));
+    lua_pushinteger(source, 42);
+
+    const state_snapshot snapshot(source);
+    EXPECT_EQ(1, lua_gettop(source));
+
+    state copy;
+    lua_pushinteger(copy, 7);
+    snapshot.restore(copy);
+    EXPECT_EQ(1, lua_gettop(copy));
+    EXPECT_EQ("3", run_string(copy, "return tostring(#x)"));
+}
@@ -1,6 +1,13 @@
 #include <easylua/function.hpp>
 #include <easylua/stack.hpp>
 
+#include <array>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 class Stack : public ::testing::Test
@@ -254,4 +261,434 @@ TEST_F(Stack, push_unsafe_function_reference)
     unsafe_function_reference f = stack::get<unsafe_function_reference>(L, 1);
     stack::push(L, f);
     EXPECT_EQ(test_function, lua_tocfunction(L, 1));
-}
\ No newline at end of file
+}
+static int add(int a, int b)
+{
+    return a + b;
+}
+
+TEST_F(Stack, push_free_function)
+{
+    stack::push(L, &add);
+    lua_setglobal(L, "add");
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "return add(2, 3)"));
+    EXPECT_EQ(5, lua_tointeger(L, -1));
+}
+
+TEST_F(Stack, push_free_function_throws_lua_error_on_wrong_argument)
+{
+    stack::push(L, &add);
+    lua_setglobal(L, "add");
+    ASSERT_NE(LUA_OK, luaL_dostring(L, "return add(2, 'x')"));
+    EXPECT_NE(std::string::npos, std::string(lua_tostring(L, -1)).find("Type mismatch at index 2"));
+}
+
+TEST_F(Stack, push_free_function_throws_lua_error_on_missing_argument)
+{
+    stack::push(L, &add);
+    lua_setglobal(L, "add");
+    EXPECT_NE(LUA_OK, luaL_dostring(L, "return add(2)"));
+}
+
+TEST_F(Stack, push_lambda_without_captures)
+{
+    stack::push(L, [](std::string a, double b) { return a + std::to_string(static_cast<int>(b)); });
+    lua_setglobal(L, "f");
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "return f('x', 4)"));
+    EXPECT_STREQ("x4", lua_tostring(L, -1));
+}
+
+TEST_F(Stack, push_lambda_with_captures)
+{
+    int calls = 0;
+    std::string prefix = "result: ";
+    stack::push(L, [&calls, prefix](int value) { ++calls; return prefix + std::to_string(value); });
+    lua_setglobal(L, "f");
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "f(1) return f(2)"));
+    EXPECT_STREQ("result: 2", lua_tostring(L, -1));
+    EXPECT_EQ(2, calls);
+}
+
+TEST_F(Stack, push_lambda_without_return_value)
+{
+    int value = 0;
+    stack::push(L, [&value](int a) { value = a; });
+    lua_setglobal(L, "f");
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "return f(7)"));
+    EXPECT_EQ(0, lua_gettop(L));
+    EXPECT_EQ(7, value);
+}
+
+TEST_F(Stack, push_lambda_with_multiple_return_values)
+{
+    stack::push(L, [](int a) { return std::make_tuple(a, a * 2, std::string("x")); });
+    lua_setglobal(L, "f");
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "return f(3)"));
+    ASSERT_EQ(3, lua_gettop(L));
+    EXPECT_EQ(3, lua_tointeger(L, 1));
+    EXPECT_EQ(6, lua_tointeger(L, 2));
+    EXPECT_STREQ("x", lua_tostring(L, 3));
+}
+
+TEST_F(Stack, push_lambda_converts_exceptions)
+{
+    stack::push(L, []() -> int { throw std::runtime_error("boom"); });
+    lua_setglobal(L, "f");
+    ASSERT_NE(LUA_OK, luaL_dostring(L, "return f()"));
+    EXPECT_STREQ("boom", lua_tostring(L, -1));
+}
+
+TEST_F(Stack, push_lambda_destroys_captures)
+{
+    auto counter = std::make_shared<int>(0);
+    stack::push(L, [counter]() { return *counter; });
+    EXPECT_EQ(2, counter.use_count());
+    lua_pop(L, 1);
+    lua_gc(L, LUA_GCCOLLECT);
+    EXPECT_EQ(1, counter.use_count());
+}
+
+struct accumulator
+{
+    int total = 0;
+    int add(int value) { return total += value; }
+    int get() const { return total; }
+};
+
+TEST_F(Stack, push_member_function)
+{
+    accumulator acc;
+    stack::push(L, &acc);
+    lua_setglobal(L, "acc");
+    stack::push(L, &accumulator::add);
+    lua_setglobal(L, "add");
+    stack::push(L, &accumulator::get);
+    lua_setglobal(L, "get");
+
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "add(acc, 2) add(acc, 3) return get(acc)"));
+    EXPECT_EQ(5, lua_tointeger(L, -1));
+    EXPECT_EQ(5, acc.total);
+}
+
+TEST_F(Stack, push_member_function_throws_lua_error_without_object)
+{
+    stack::push(L, &accumulator::get);
+    lua_setglobal(L, "get");
+    EXPECT_NE(LUA_OK, luaL_dostring(L, "return get(5)"));
+}
+
+TEST_F(Stack, get_object_pointer)
+{
+    accumulator acc;
+    stack::push(L, &acc);
+    EXPECT_EQ(&acc, stack::get<accumulator *>(L, 1));
+}
+
+TEST_F(Stack, push_captureless_cfunction_lambda)
+{
+    stack::push(L, [](lua_State *L) { lua_pushinteger(L, 9); return 1; });
+    EXPECT_EQ(LUA_OK, lua_pcall(L, 0, 1, 0));
+    EXPECT_EQ(9, lua_tointeger(L, -1));
+}
+
+TEST_F(Stack, get_string_with_embedded_nul)
+{
+    lua_pushlstring(L, "a\0b", 3);
+    EXPECT_EQ(std::string("a\0b", 3), stack::get<std::string>(L, 1));
+}
+
+TEST_F(Stack, get_string_view_with_embedded_nul)
+{
+    lua_pushlstring(L, "a\0b", 3);
+    const std::string_view view = stack::get<std::string_view>(L, 1);
+    EXPECT_EQ(3, view.size());
+    EXPECT_EQ(lua_tostring(L, 1), view.data());
+}
+
+TEST_F(Stack, get_string_view_does_not_convert_numbers)
+{
+    lua_pushinteger(L, 5);
+    EXPECT_THROW(stack::get<std::string_view>(L, 1), type_error);
+    EXPECT_EQ(LUA_TNUMBER, lua_type(L, 1));
+}
+
+TEST_F(Stack, push_string_with_embedded_nul)
+{
+    stack::push(L, std::string("a\0b", 3));
+    size_t length = 0;
+    lua_tolstring(L, 1, &length);
+    EXPECT_EQ(3, length);
+}
+
+TEST_F(Stack, push_string_view_with_embedded_nul)
+{
+    stack::push(L, std::string_view("a\0b", 3));
+    size_t length = 0;
+    lua_tolstring(L, 1, &length);
+    EXPECT_EQ(3, length);
+}
+
+struct copy_counter
+{
+    copy_counter(int *copies) : copies(copies) {}
+    copy_counter(const copy_counter &other) : copies(other.copies) { ++*copies; }
+    copy_counter(copy_counter &&other) = default;
+
+    int *copies;
+};
+
+TEST_F(Stack, push_rvalue_does_not_copy)
+{
+    int copies = 0;
+    stack::push(L, copy_counter(&copies));
+    EXPECT_EQ(0, copies);
+}
+
+TEST_F(Stack, push_lvalue_copies_once)
+{
+    int copies = 0;
+    copy_counter counter(&copies);
+    stack::push(L, counter);
+    EXPECT_EQ(1, copies);
+}
+
+TEST_F(Stack, push_multiple_values_forwards_arguments)
+{
+    int copies = 0;
+    copy_counter counter(&copies);
+    const std::string text = "text";
+    stack::push(L, counter, text, copy_counter(&copies));
+    EXPECT_EQ(1, copies);
+    EXPECT_EQ(3, lua_gettop(L));
+}
+
+TEST_F(Stack, push_vector)
+{
+    stack::push(L, std::vector<int>{1, 2, 3});
+    ASSERT_EQ(LUA_TTABLE, lua_type(L, -1));
+    EXPECT_EQ(3u, lua_rawlen(L, -1));
+    lua_rawgeti(L, -1, 2);
+    EXPECT_EQ(2, lua_tointeger(L, -1));
+}
+
+TEST_F(Stack, push_vector_of_bool)
+{
+    const std::vector<bool> values{true, false};
+    stack::push(L, values);
+    lua_rawgeti(L, -1, 1);
+    lua_rawgeti(L, -2, 2);
+    EXPECT_TRUE(lua_toboolean(L, -2));
+    EXPECT_FALSE(lua_toboolean(L, -1));
+}
+
+TEST_F(Stack, get_vector)
+{
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "t = { 'a', 'b', 'c' }"));
+    lua_getglobal(L, "t");
+    EXPECT_EQ((std::vector<std::string>{"a", "b", "c"}), stack::get<std::vector<std::string>>(L, -1));
+    EXPECT_EQ(1, lua_gettop(L));
+}
+
+TEST_F(Stack, get_vector_throws_on_wrong_type)
+{
+    lua_pushinteger(L, 1);
+    EXPECT_THROW(stack::get<std::vector<int>>(L, -1), type_error);
+
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "t = { 1, 'b' }"));
+    lua_getglobal(L, "t");
+    EXPECT_THROW(stack::get<std::vector<int>>(L, -1), type_error);
+    EXPECT_EQ(2, lua_gettop(L));
+}
+
+TEST_F(Stack, push_and_get_nested_vector)
+{
+    const std::vector<std::vector<double>> values{{1.5}, {2.5, 3.5}};
+    stack::push(L, values);
+    EXPECT_EQ(values, stack::get<std::vector<std::vector<double>>>(L, -1));
+}
+
+TEST_F(Stack, push_and_get_array)
+{
+    stack::push(L, std::array<int, 3>{4, 5, 6});
+    EXPECT_EQ(3u, lua_rawlen(L, -1));
+    EXPECT_EQ((std::array<int, 3>{4, 5, 6}), (stack::get<std::array<int, 3>>(L, -1)));
+}
+
+TEST_F(Stack, push_and_get_map)
+{
+    const std::map<std::string, int> values{{"a", 1}, {"b", 2}};
+    stack::push(L, values);
+    lua_getfield(L, -1, "b");
+    EXPECT_EQ(2, lua_tointeger(L, -1));
+    lua_pop(L, 1);
+
+    EXPECT_EQ(values, (stack::get<std::map<std::string, int>>(L, -1)));
+    EXPECT_EQ(1, lua_gettop(L));
+}
+
+TEST_F(Stack, push_and_get_unordered_map)
+{
+    std::unordered_map<int, std::string> values{{10, "ten"}, {20, "twenty"}};
+    stack::push(L, values);
+    EXPECT_EQ(values, (stack::get<std::unordered_map<int, std::string>>(L, -1)));
+}
+
+TEST_F(Stack, push_and_get_optional)
+{
+    stack::push(L, std::optional<int>(3));
+    stack::push(L, std::optional<int>());
+    EXPECT_EQ(LUA_TNIL, lua_type(L, -1));
+    EXPECT_EQ(std::nullopt, stack::get<std::optional<int>>(L, -1));
+    EXPECT_EQ(3, stack::get<std::optional<int>>(L, -2));
+    EXPECT_EQ(std::nullopt, stack::get<std::optional<int>>(L, 5));
+}
+
+TEST_F(Stack, push_and_get_pair_and_tuple)
+{
+    stack::push(L, std::make_pair(1, std::string("one")));
+    EXPECT_EQ(2u, lua_rawlen(L, -1));
+    EXPECT_EQ(std::make_pair(1, std::string("one")), (stack::get<std::pair<int, std::string>>(L, -1)));
+
+    stack::push(L, std::make_tuple(true, 2.5, std::string("x")));
+    EXPECT_EQ(std::make_tuple(true, 2.5, std::string("x")), (stack::get<std::tuple<bool, double, std::string>>(L, -1)));
+    EXPECT_EQ(2, lua_gettop(L));
+}
+
+TEST_F(Stack, native_function_with_containers)
+{
+    stack::push(L, [](const std::vector<int> &values, std::optional<int> scale)
+                {
+                    std::vector<int> result;
+                    for (int value : values)
+                        result.push_back(value * scale.value_or(1));
+                    return result; });
+    lua_setglobal(L, "scale");
+
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "a = scale({ 1, 2 }, 3); b = scale({ 4 })"));
+    lua_getglobal(L, "a");
+    EXPECT_EQ((std::vector<int>{3, 6}), stack::get<std::vector<int>>(L, -1));
+    lua_getglobal(L, "b");
+    EXPECT_EQ((std::vector<int>{4}), stack::get<std::vector<int>>(L, -1));
+}
+
+TEST_F(Stack, try_get_returns_value)
+{
+    lua_pushinteger(L, 42);
+    lua_pushstring(L, "text");
+
+    const expected<int> number = stack::try_get<int>(L, 1);
+    ASSERT_TRUE(number);
+    EXPECT_EQ(42, *number);
+
+    const expected<std::string> text = stack::try_get<std::string>(L, 2);
+    ASSERT_TRUE(text);
+    EXPECT_EQ("text", *text);
+}
+
+TEST_F(Stack, try_get_returns_type_mismatch)
+{
+    lua_pushnil(L);
+
+    const expected<double> number = stack::try_get<double>(L, -1);
+    ASSERT_FALSE(number);
+    EXPECT_EQ(error_code::type_mismatch, number.get_error().get_code());
+    EXPECT_EQ(-1, number.get_error().get_index());
+    EXPECT_EQ(LUA_TNIL, number.get_error().get_actual_type());
+    EXPECT_EQ(LUA_TNUMBER, number.get_error().get_expected_type());
+    EXPECT_EQ("Type mismatch at index -1: expected number, got nil", number.get_error().message());
+    EXPECT_THROW(number.value(), type_error);
+    EXPECT_EQ(1.5, number.value_or(1.5));
+}
+
+TEST_F(Stack, try_get_index_zero)
+{
+    const expected<int> number = stack::try_get<int>(L, 0);
+    ASSERT_FALSE(number);
+    EXPECT_EQ(error_code::invalid_index, number.get_error().get_code());
+    EXPECT_THROW(number.value(), invalid_argument);
+}
+
+TEST_F(Stack, try_get_optional)
+{
+    lua_pushnil(L);
+    lua_pushboolean(L, 1);
+
+    const expected<std::optional<int>> missing = stack::try_get<std::optional<int>>(L, 1);
+    ASSERT_TRUE(missing);
+    EXPECT_FALSE(missing->has_value());
+
+    EXPECT_FALSE(stack::try_get<std::optional<int>>(L, 2));
+}
+
+TEST_F(Stack, try_get_containers)
+{
+    stack::push(L, std::vector<int>{1, 2, 3});
+    stack::push(L, std::vector<std::string>{"a"});
+    lua_pushinteger(L, 1);
+
+    const expected<std::vector<int>> values = stack::try_get<std::vector<int>>(L, 1);
+    ASSERT_TRUE(values);
+    EXPECT_EQ((std::vector<int>{1, 2, 3}), *values);
+
+    const expected<std::vector<int>> elements = stack::try_get<std::vector<int>>(L, 2);
+    ASSERT_FALSE(elements);
+    EXPECT_EQ(LUA_TSTRING, elements.get_error().get_actual_type());
+
+    const expected<std::vector<int>> number = stack::try_get<std::vector<int>>(L, 3);
+    ASSERT_FALSE(number);
+    EXPECT_EQ(LUA_TTABLE, number.get_error().get_expected_type());
+    EXPECT_EQ(3, lua_gettop(L));
+}
+
+TEST_F(Stack, try_get_reference)
+{
+    lua_pushinteger(L, 1);
+    EXPECT_FALSE(stack::try_get<safe_function_reference>(L, -1));
+    EXPECT_EQ(1, lua_gettop(L));
+
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "return function() end"));
+    EXPECT_TRUE(stack::try_get<safe_function_reference>(L, -1));
+}
+
+TEST_F(Stack, get_object_pointer_rejects_other_types)
+{
+    struct other
+    {
+        int value = 0;
+    };
+
+    other object;
+    stack::push(L, &object);
+    EXPECT_THROW(stack::get<accumulator *>(L, -1), type_error);
+    EXPECT_FALSE(stack::try_get<accumulator *>(L, -1));
+
+    lua_pushlightuserdata(L, &object);
+    EXPECT_THROW(stack::get<accumulator *>(L, -1), type_error);
+    EXPECT_FALSE(stack::try_get<accumulator *>(L, -1));
+}
+
+TEST_F(Stack, null_object_pointer_is_nil)
+{
+    stack::push(L, static_cast<accumulator *>(nullptr));
+    EXPECT_TRUE(lua_isnil(L, -1));
+    EXPECT_EQ(nullptr, stack::get<accumulator *>(L, -1));
+}
+
+TEST_F(Stack, member_function_rejects_object_of_other_type)
+{
+    struct other
+    {
+        int total = 0;
+    };
+
+    other object;
+    stack::push(L, &accumulator::get);
+    lua_setglobal(L, "get");
+    stack::push(L, &object);
+    lua_setglobal(L, "object");
+    lua_pushlightuserdata(L, &object);
+    lua_setglobal(L, "light");
+
+    EXPECT_NE(LUA_OK, luaL_dostring(L, "return get(object)"));
+    EXPECT_NE(LUA_OK, luaL_dostring(L, "return get(light)"));
+}
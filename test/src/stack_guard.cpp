@@ -0,0 +1,188 @@
+#include <easylua/global.hpp>
+#include <easylua/stack.hpp>
+#include <easylua/stack_guard.hpp>
+
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+class StackGuard : public ::testing::Test
+{
+public:
+    StackGuard()
+    {
+        L = luaL_newstate();
+        if (!L)
+            throw std::runtime_error("Could not create Lua state");
+
+        previous_handler_ = easylua::set_stack_leak_handler(&record_leak);
+        leaks.clear();
+    }
+
+    ~StackGuard()
+    {
+        easylua::set_stack_leak_handler(previous_handler_);
+        lua_close(L);
+    }
+
+protected:
+    static void record_leak(const easylua::stack_leak &leak) { leaks.push_back(leak); }
+
+    lua_State *L;
+    static std::vector<easylua::stack_leak> leaks;
+
+private:
+    easylua::stack_leak_handler previous_handler_;
+};
+
+std::vector<easylua::stack_leak> StackGuard::leaks;
+
+using namespace easylua;
+
+TEST_F(StackGuard, restores_top)
+{
+    lua_pushinteger(L, 1);
+    {
+        const stack_guard guard(L);
+        EXPECT_EQ(1, guard.get_top());
+        lua_pushinteger(L, 2);
+        lua_pushinteger(L, 3);
+    }
+
+    EXPECT_EQ(1, lua_gettop(L));
+    EXPECT_EQ(1, lua_tointeger(L, -1));
+}
+
+TEST_F(StackGuard, restores_top_on_exception)
+{
+    try
+    {
+        const stack_guard guard(L);
+        lua_pushinteger(L, 1);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    EXPECT_EQ(0, lua_gettop(L));
+}
+
+TEST_F(StackGuard, check_accepts_balanced_scope)
+{
+    {
+        const stack_check check(L, 0, __FILE__, __LINE__, __func__);
+        lua_pushinteger(L, 1);
+        lua_pop(L, 1);
+    }
+
+    {
+        const stack_check check(L, 1, __FILE__, __LINE__, __func__);
+        lua_pushinteger(L, 1);
+    }
+
+    EXPECT_TRUE(leaks.empty());
+}
+
+TEST_F(StackGuard, check_reports_call_site)
+{
+    int line = 0;
+    {
+        const stack_check check(L, 0, __FILE__, line = __LINE__, "leaky");
+        lua_pushinteger(L, 1);
+        lua_pushinteger(L, 2);
+    }
+
+    ASSERT_EQ(1u, leaks.size());
+    EXPECT_STREQ(__FILE__, leaks[0].file);
+    EXPECT_EQ(line, leaks[0].line);
+    EXPECT_STREQ("leaky", leaks[0].function);
+    EXPECT_EQ(0, leaks[0].expected_top);
+    EXPECT_EQ(2, leaks[0].actual_top);
+}
+
+TEST_F(StackGuard, check_ignores_exceptions)
+{
+    try
+    {
+        const stack_check check(L, 0, __FILE__, __LINE__, __func__);
+        lua_pushinteger(L, 1);
+        throw std::runtime_error("error");
+    }
+    catch (const std::runtime_error &)
+    {
+    }
+
+    EXPECT_TRUE(leaks.empty());
+}
+
+#if EASYLUA_STACK_CHECKS
+TEST_F(StackGuard, macro_reports_leak)
+{
+    {
+        EASYLUA_STACK_CHECK(L);
+        lua_pushinteger(L, 1);
+    }
+
+    {
+        EASYLUA_STACK_CHECK(L, 1);
+        lua_pushinteger(L, 1);
+    }
+
+    ASSERT_EQ(1u, leaks.size());
+    EXPECT_STREQ(__FILE__, leaks[0].file);
+}
+#endif
+
+#if EASYLUA_STACK_CHECKS
+namespace
+{
+    // A reference that pushes one value too many, below the global table and name that global::set() has pushed, to make the check of
+    // the library find a leak.
+    class leaky_reference : public unsafe_reference
+    {
+    public:
+        explicit leaky_reference(lua_State *state) : unsafe_reference(state, -1, LUA_TNUMBER) {}
+
+        void push() const override
+        {
+            unsafe_reference::push();
+            lua_pushnil(lua_state_);
+            lua_rotate(lua_state_, -4, 1);
+        }
+    };
+}
+
+TEST_F(StackGuard, library_check_reports_caller)
+{
+    lua_pushinteger(L, 1);
+    const leaky_reference value(L);
+    const global number(L, "number");
+    const int line = __LINE__ + 1;
+    number.set(value);
+
+    ASSERT_EQ(1u, leaks.size());
+    EXPECT_STREQ(__FILE__, leaks[0].file);
+    EXPECT_EQ(line, leaks[0].line);
+    EXPECT_EQ(1, leaks[0].expected_top);
+    EXPECT_EQ(2, leaks[0].actual_top);
+}
+#endif
+
+TEST_F(StackGuard, push_reserves_stack_for_many_values)
+{
+    stack::push(L, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32,
+                33, 34, 35, 36, 37, 38, 39, 40);
+    ASSERT_EQ(40, lua_gettop(L));
+    for (int i = 1; i <= 40; i++)
+        EXPECT_EQ(i, lua_tointeger(L, i));
+}
+
+TEST_F(StackGuard, push_reserves_stack_for_nested_containers)
+{
+    std::vector<std::vector<std::vector<int>>> value(3, std::vector<std::vector<int>>(3, std::vector<int>{1, 2, 3}));
+    stack::push(L, value);
+    EXPECT_EQ(1, lua_gettop(L));
+    EXPECT_EQ(value, stack::get<decltype(value)>(L, -1));
+}
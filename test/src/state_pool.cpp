@@ -0,0 +1,174 @@
+#include <easylua/state_pool.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace easylua;
+
+TEST(state_pool, constructor_throws_on_zero_size)
+{
+    EXPECT_THROW(state_pool(0, nullptr), invalid_argument);
+}
+
+TEST(state_pool, constructor_runs_setup_for_every_state)
+{
+    int calls = 0;
+    state_pool pool(3, [&](state &lua)
+                    { calls++; lua.run("x = 42"); });
+
+    EXPECT_EQ(3, calls);
+    EXPECT_EQ(3u, pool.size());
+    EXPECT_EQ(3u, pool.available());
+
+    auto lease = pool.acquire();
+    EXPECT_EQ(42, lease->get_global("x").get<int>());
+}
+
+TEST(state_pool, constructor_passes_on_setup_exceptions)
+{
+    EXPECT_THROW(state_pool(2, [](state &)
+                            { throw runtime_error("setup failed"); }),
+                 runtime_error);
+}
+
+TEST(state_pool, lease_returns_state)
+{
+    state_pool pool(1, nullptr);
+    lua_State *first = nullptr;
+    {
+        auto lease = pool.acquire();
+        first = lease;
+        EXPECT_EQ(0u, pool.available());
+        EXPECT_FALSE(pool.try_acquire());
+    }
+
+    EXPECT_EQ(1u, pool.available());
+    auto lease = pool.try_acquire();
+    ASSERT_TRUE(lease);
+    EXPECT_EQ(first, static_cast<lua_State *>(*lease));
+}
+
+TEST(state_pool, lease_move)
+{
+    state_pool pool(1, nullptr);
+    {
+        auto lease = pool.acquire();
+        auto moved = std::move(lease);
+        EXPECT_EQ(0u, pool.available());
+    }
+
+    EXPECT_EQ(1u, pool.available());
+}
+
+TEST(state_pool, lease_clears_stack)
+{
+    state_pool pool(1, nullptr);
+    {
+        auto lease = pool.acquire();
+        lua_pushinteger(lease, 1);
+    }
+
+    EXPECT_EQ(0, lua_gettop(pool.acquire()));
+}
+
+TEST(state_pool, try_acquire_for_times_out)
+{
+    state_pool pool(1, nullptr);
+    auto lease = pool.acquire();
+    EXPECT_FALSE(pool.try_acquire_for(std::chrono::milliseconds(5)));
+
+    const state_pool::metrics metrics = pool.get_metrics();
+    EXPECT_EQ(1u, metrics.acquisitions);
+    EXPECT_EQ(1u, metrics.exhaustions);
+    EXPECT_EQ(1u, metrics.failures);
+    EXPECT_GE(metrics.max_wait, std::chrono::milliseconds(5));
+    EXPECT_EQ(metrics.max_wait, metrics.total_wait);
+}
+
+TEST(state_pool, acquire_waits_for_release)
+{
+    state_pool pool(1, nullptr);
+    auto lease = std::make_unique<state_pool::lease>(pool.acquire());
+
+    std::thread releaser([&]
+                         {
+                             std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                             lease.reset(); });
+
+    auto second = pool.acquire();
+    releaser.join();
+
+    const state_pool::metrics metrics = pool.get_metrics();
+    EXPECT_EQ(2u, metrics.acquisitions);
+    EXPECT_EQ(1u, metrics.exhaustions);
+    EXPECT_EQ(0u, metrics.failures);
+    EXPECT_GT(metrics.total_wait.count(), 0);
+}
+
+TEST(state_pool, restore_globals)
+{
+    state_pool pool(1, [](state &lua)
+                    { lua.run("a = 1; b = 2"); },
+                    state_pool::reset_mode::restore_globals);
+    {
+        auto lease = pool.acquire();
+        ASSERT_TRUE(lease->run("a = 10; b = nil; c = 3"));
+    }
+
+    auto lease = pool.acquire();
+    EXPECT_EQ(1, lease->get_global("a").get<int>());
+    EXPECT_EQ(2, lease->get_global("b").get<int>());
+    EXPECT_EQ(nil, lease->get_global("c").get<nil_t>());
+}
+
+TEST(state_pool, collect_garbage)
+{
+    state_pool pool(1, nullptr, state_pool::reset_mode::collect_garbage);
+    int before = 0;
+    {
+        auto lease = pool.acquire();
+        before = lua_gc(lease, LUA_GCCOUNT, 0);
+        ASSERT_TRUE(lease->run("local t = {} for i = 1, 10000 do t[i] = {} end"));
+    }
+
+    auto lease = pool.acquire();
+    EXPECT_LE(lua_gc(lease, LUA_GCCOUNT, 0), before + 1);
+}
+
+TEST(state_pool, states_are_not_shared_between_threads)
+{
+    state_pool pool(2, nullptr);
+    std::map<lua_State *, std::atomic<int>> users;
+    {
+        auto a = pool.acquire();
+        auto b = pool.acquire();
+        users[a];
+        users[b];
+    }
+
+    std::atomic<bool> shared{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++)
+        threads.emplace_back([&]
+                             {
+                                 for (int i = 0; i < 1000; i++)
+                                 {
+                                     auto lease = pool.acquire();
+                                     if (users.at(lease).fetch_add(1) != 0)
+                                         shared = true;
+                                     lua_pushinteger(lease, i);
+                                     users.at(lease).fetch_sub(1);
+                                 } });
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    EXPECT_FALSE(shared);
+    EXPECT_EQ(2u, pool.available());
+    EXPECT_EQ(4002u, pool.get_metrics().acquisitions);
+}
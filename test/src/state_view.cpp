@@ -99,6 +99,19 @@ TEST(state_view, get_global_string)
     lua_close(L);
 }
 
+TEST(state_view, get_global_string_view)
+{
+    lua_State *L = luaL_newstate();
+    lua_pushstring(L, "hello");
+    lua_setglobal(L, "test");
+
+    easylua::state_view state(L);
+    std::string_view value = state["test"];
+    EXPECT_EQ("hello", value);
+    EXPECT_EQ(0, lua_gettop(L));
+    lua_close(L);
+}
+
 TEST(state_view, get_global_nil)
 {
     lua_State *L = luaL_newstate();
@@ -160,3 +173,19 @@ TEST(state_view, set_global_string)
     lua_getglobal(L, "test");
     EXPECT_STREQ("hello", lua_tostring(L, -1));
 }
+
+TEST(state_view, get_global_leaves_stack_unchanged)
+{
+    lua_State *L = luaL_newstate();
+    easylua::state_view state(L);
+    state["test"] = 5;
+
+    for (int i = 0; i < 100; i++)
+    {
+        int value = state["test"];
+        EXPECT_EQ(5, value);
+    }
+
+    EXPECT_EQ(0, lua_gettop(L));
+    lua_close(L);
+}
@@ -0,0 +1,70 @@
+#include <easylua/stack.hpp>
+#include <easylua/string_reference.hpp>
+
+#include <gtest/gtest.h>
+
+class StringReference : public ::testing::Test
+{
+public:
+    StringReference()
+    {
+        L = luaL_newstate();
+        if (!L)
+            throw std::runtime_error("Could not create Lua state");
+    }
+
+    ~StringReference() { lua_close(L); }
+
+protected:
+    lua_State *L;
+};
+
+using namespace easylua;
+
+TEST_F(StringReference, unsafe_constructor_throws_on_wrong_type)
+{
+    lua_pushnumber(L, 5);
+    EXPECT_THROW(unsafe_string_reference(L, -1), type_error);
+}
+
+TEST_F(StringReference, unsafe_get)
+{
+    lua_pushlstring(L, "a\0b", 3);
+    unsafe_string_reference ref(L, -1);
+    EXPECT_EQ(std::string_view("a\0b", 3), ref.get());
+    EXPECT_EQ(lua_tostring(L, -1), ref.get().data());
+}
+
+TEST_F(StringReference, safe_constructor_throws_on_wrong_type)
+{
+    lua_pushnumber(L, 5);
+    EXPECT_THROW(safe_string_reference(L, -1), type_error);
+}
+
+TEST_F(StringReference, safe_view_outlives_stack_slot)
+{
+    lua_pushlstring(L, "binary\0frame", 12);
+    safe_string_reference ref(L, -1);
+    lua_settop(L, 0);
+    lua_gc(L, LUA_GCCOLLECT);
+
+    const std::string_view view = ref;
+    EXPECT_EQ(std::string_view("binary\0frame", 12), view);
+}
+
+TEST_F(StringReference, get_from_stack)
+{
+    lua_pushstring(L, "hello");
+    const safe_string_reference ref = stack::get<safe_string_reference>(L, -1);
+    EXPECT_EQ("hello", ref.get());
+}
+
+TEST_F(StringReference, get_below_top_leaves_stack_unchanged)
+{
+    lua_pushstring(L, "hello");
+    lua_pushinteger(L, 1);
+    const safe_string_reference ref = stack::get<safe_string_reference>(L, 1);
+    EXPECT_EQ("hello", ref.get());
+    EXPECT_EQ(2, lua_gettop(L));
+    EXPECT_EQ(1, lua_tointeger(L, -1));
+}
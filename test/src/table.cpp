@@ -0,0 +1,180 @@
+#include <easylua/function.hpp>
+#include <easylua/table.hpp>
+
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+class Table : public ::testing::Test
+{
+public:
+    Table()
+    {
+        L = luaL_newstate();
+        if (!L)
+            throw std::runtime_error("Could not create Lua state");
+    }
+
+    ~Table() { lua_close(L); }
+
+protected:
+    lua_State *L;
+};
+
+using namespace easylua;
+
+TEST_F(Table, constructor_throws_on_null_state)
+{
+    EXPECT_THROW(unsafe_table_reference(nullptr), invalid_argument);
+    EXPECT_THROW(safe_table_reference::create(nullptr), invalid_argument);
+}
+
+TEST_F(Table, constructor_throws_on_wrong_type)
+{
+    lua_pushnumber(L, 5);
+    EXPECT_THROW(unsafe_table_reference(L, -1), type_error);
+    EXPECT_THROW(safe_table_reference(L, -1), type_error);
+}
+
+TEST_F(Table, unsafe_get_and_set)
+{
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "t = { x = 1, 'first' }"));
+    lua_getglobal(L, "t");
+    unsafe_table_reference t(L);
+
+    EXPECT_EQ(1, t.get<int>("x"));
+    EXPECT_EQ("first", t.get<std::string>(1));
+
+    t.set("y", 2.5);
+    t.set(std::string("z"), true);
+    t.set(2, "second");
+    EXPECT_EQ(2.5, t.get<double>(std::string("y")));
+    EXPECT_TRUE(t.get<bool>("z"));
+    EXPECT_EQ("second", t.get<std::string_view>(2));
+    EXPECT_EQ(1, lua_gettop(L));
+}
+
+TEST_F(Table, unsafe_reference_survives_pushes)
+{
+    lua_createtable(L, 0, 0);
+    unsafe_table_reference t(L);
+    lua_pushinteger(L, 5);
+
+    t.set("x", 1);
+    EXPECT_EQ(1, t.get<int>("x"));
+    t.push();
+    EXPECT_TRUE(lua_rawequal(L, 1, -1));
+    EXPECT_EQ(3, lua_gettop(L));
+}
+
+TEST_F(Table, safe_get_and_set)
+{
+    safe_table_reference t = safe_table_reference::create(L);
+    EXPECT_EQ(0, lua_gettop(L));
+
+    t.set("name", "value");
+    EXPECT_EQ("value", t.get<std::string>("name"));
+    EXPECT_EQ(nil, t.get<nil_t>("missing"));
+    EXPECT_EQ(0, lua_gettop(L));
+}
+
+TEST_F(Table, get_throws_on_wrong_type)
+{
+    safe_table_reference t = safe_table_reference::create(L);
+    t.set("x", "text");
+    EXPECT_THROW(t.get<int>("x"), type_error);
+    EXPECT_EQ(0, lua_gettop(L));
+}
+
+TEST_F(Table, get_calls_metamethods)
+{
+    luaL_requiref(L, LUA_GNAME, luaopen_base, 1);
+    lua_pop(L, 1);
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "t = setmetatable({}, { __index = function(t, k) return k .. '!' end })"));
+    lua_getglobal(L, "t");
+    safe_table_reference t(L);
+
+    EXPECT_EQ("a!", t.get<std::string>("a"));
+    EXPECT_FALSE(t.contains("a"));
+}
+
+TEST_F(Table, raw_get_and_set)
+{
+    safe_table_reference t = safe_table_reference::create(L, 3);
+    for (int i = 1; i <= 3; i++)
+        t.raw_set(i, i * 10);
+
+    EXPECT_EQ(3u, t.size());
+    EXPECT_EQ(20, t.raw_get<int>(2));
+    EXPECT_TRUE(t.contains(3));
+    EXPECT_FALSE(t.contains(4));
+    EXPECT_EQ(0, lua_gettop(L));
+}
+
+TEST_F(Table, get_table)
+{
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "t = { inner = { value = 42 } }"));
+    lua_getglobal(L, "t");
+    safe_table_reference t(L);
+
+    safe_table_reference inner = t.get<safe_table_reference>("inner");
+    EXPECT_EQ(42, inner.get<int>("value"));
+    EXPECT_EQ(0, lua_gettop(L));
+}
+
+TEST_F(Table, get_function)
+{
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "t = { f = function(a) return a + 1 end }"));
+    lua_getglobal(L, "t");
+    safe_table_reference t(L);
+
+    safe_function_reference f = t.get<safe_function_reference>("f");
+    int result = f(1);
+    EXPECT_EQ(2, result);
+}
+
+TEST_F(Table, set_table)
+{
+    safe_table_reference outer = safe_table_reference::create(L);
+    safe_table_reference inner = safe_table_reference::create(L);
+    inner.set("x", 1);
+    outer.set("inner", inner);
+    EXPECT_EQ(1, outer.get<safe_table_reference>("inner").get<int>("x"));
+}
+
+TEST_F(Table, for_each)
+{
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "t = { a = 1, b = 2, c = 3 }"));
+    lua_getglobal(L, "t");
+    unsafe_table_reference t(L);
+
+    std::map<std::string, int> entries;
+    t.for_each<std::string_view, int>([&](std::string_view key, int value)
+                                      { entries.emplace(key, value); });
+
+    EXPECT_EQ((std::map<std::string, int>{{"a", 1}, {"b", 2}, {"c", 3}}), entries);
+    EXPECT_EQ(1, lua_gettop(L));
+}
+
+TEST_F(Table, for_each_throws_on_wrong_type)
+{
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "t = { a = 'x' }"));
+    lua_getglobal(L, "t");
+    safe_table_reference t(L);
+
+    EXPECT_THROW((t.for_each<std::string, int>([](const std::string &, int) {})), type_error);
+    EXPECT_EQ(0, lua_gettop(L));
+}
+
+TEST_F(Table, push_and_get)
+{
+    safe_table_reference t = safe_table_reference::create(L);
+    t.set("x", 5);
+    stack::push(L, t);
+    lua_setglobal(L, "t");
+
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "y = t.x * 2"));
+    lua_getglobal(L, "y");
+    EXPECT_EQ(10, lua_tointeger(L, -1));
+}
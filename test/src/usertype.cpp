@@ -0,0 +1,191 @@
+#include <easylua/usertype.hpp>
+
+#include <cmath>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+class Usertype : public ::testing::Test
+{
+public:
+    Usertype()
+    {
+        L = luaL_newstate();
+        if (!L)
+            throw std::runtime_error("Could not create Lua state");
+        luaL_openlibs(L);
+    }
+
+    ~Usertype() { lua_close(L); }
+
+protected:
+    lua_State *L;
+};
+
+using namespace easylua;
+
+struct point
+{
+    point() = default;
+    point(double x, double y) : x(x), y(y) {}
+
+    double length() const { return std::sqrt(x * x + y * y); }
+    void scale(double factor)
+    {
+        x *= factor;
+        y *= factor;
+    }
+
+    point operator+(const point &other) const { return point(x + other.x, y + other.y); }
+
+    double x = 0;
+    double y = 0;
+};
+
+static void register_point(lua_State *L)
+{
+    usertype<point>(L, "point")
+        .constructor<>("zero")
+        .constructor<double, double>()
+        .property("x", &point::x)
+        .property("y", &point::y)
+        .method("length", &point::length)
+        .method("scale", &point::scale)
+        .metamethod("__add", [](const point &a, const point &b) { return a + b; })
+        .metamethod("__eq", [](const point &a, const point &b) { return a.x == b.x && a.y == b.y; });
+}
+
+TEST_F(Usertype, constructor_throws_on_null_state)
+{
+    EXPECT_THROW(usertype<point>(nullptr, "point"), invalid_argument);
+}
+
+TEST_F(Usertype, constructor_throws_on_null_name)
+{
+    EXPECT_THROW(usertype<point>(L, nullptr), invalid_argument);
+}
+
+TEST_F(Usertype, construct_and_call_methods_from_lua)
+{
+    register_point(L);
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "local p = point.new(3, 4) return p:length()"));
+    EXPECT_EQ(5, lua_tonumber(L, -1));
+}
+
+TEST_F(Usertype, properties)
+{
+    register_point(L);
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "local p = point.zero() p.x = 6 p.y = 8 p:scale(0.5) return p.x, p.y, p:length()"));
+    EXPECT_EQ(3, lua_tonumber(L, 1));
+    EXPECT_EQ(4, lua_tonumber(L, 2));
+    EXPECT_EQ(5, lua_tonumber(L, 3));
+}
+
+TEST_F(Usertype, unknown_property_is_nil)
+{
+    register_point(L);
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "return point.zero().z"));
+    EXPECT_TRUE(lua_isnil(L, -1));
+}
+
+TEST_F(Usertype, setting_unknown_property_fails)
+{
+    register_point(L);
+    EXPECT_NE(LUA_OK, luaL_dostring(L, "point.zero().z = 1"));
+}
+
+TEST_F(Usertype, metamethods)
+{
+    register_point(L);
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "local p = point.new(1, 2) + point.new(3, 4) return p.x, p.y, p == point.new(4, 6)"));
+    EXPECT_EQ(4, lua_tonumber(L, 1));
+    EXPECT_EQ(6, lua_tonumber(L, 2));
+    EXPECT_TRUE(lua_toboolean(L, 3));
+}
+
+TEST_F(Usertype, metamethod_throws_on_managed_name)
+{
+    EXPECT_THROW(usertype<point>(L, "point").metamethod("__gc", [](point &) {}), invalid_argument);
+}
+
+TEST_F(Usertype, push_by_value_and_get)
+{
+    register_point(L);
+    stack::push(L, point(1, 2));
+    ASSERT_EQ(LUA_TUSERDATA, lua_type(L, -1));
+
+    point *stored = stack::get<point *>(L, -1);
+    EXPECT_EQ(stored, lua_touserdata(L, -1));
+
+    point copy = stack::get<point>(L, -1);
+    EXPECT_EQ(1, copy.x);
+    EXPECT_EQ(2, copy.y);
+}
+
+TEST_F(Usertype, push_pointer_of_registered_type)
+{
+    register_point(L);
+    point p(3, 4);
+    stack::push(L, &p);
+    lua_setglobal(L, "p");
+
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "p:scale(2) p.x = p.x + 1 return p:length()"));
+    EXPECT_EQ(7, p.x);
+    EXPECT_EQ(8, p.y);
+
+    lua_getglobal(L, "p");
+    EXPECT_EQ(&p, stack::get<point *>(L, -1));
+}
+
+TEST_F(Usertype, get_throws_on_other_type)
+{
+    register_point(L);
+    struct other
+    {
+        int value;
+    };
+
+    usertype<other>(L, "other");
+    stack::push(L, other{1});
+    EXPECT_THROW(stack::get<point *>(L, -1), type_error);
+    lua_pushnumber(L, 5);
+    EXPECT_THROW(stack::get<point>(L, -1), type_error);
+}
+
+TEST_F(Usertype, unregistered_type_can_be_pushed_by_value)
+{
+    stack::push(L, point(1, 2));
+    EXPECT_EQ(1, stack::get<point>(L, -1).x);
+}
+
+TEST_F(Usertype, objects_are_destroyed_by_garbage_collector)
+{
+    struct holder
+    {
+        std::shared_ptr<int> value;
+    };
+
+    auto value = std::make_shared<int>(5);
+    stack::push(L, holder{value});
+    EXPECT_EQ(2, value.use_count());
+    lua_pop(L, 1);
+    lua_gc(L, LUA_GCCOLLECT);
+    EXPECT_EQ(1, value.use_count());
+}
+
+TEST_F(Usertype, bound_function_takes_usertype_by_reference)
+{
+    register_point(L);
+    stack::push(L, [](point &p) { p.x = 42; });
+    lua_setglobal(L, "set_x");
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "local p = point.zero() set_x(p) return p.x"));
+    EXPECT_EQ(42, lua_tonumber(L, -1));
+}
+
+TEST_F(Usertype, registration_is_shared_across_calls)
+{
+    register_point(L);
+    usertype<point>(L, "point").method("sum", [](const point &p) { return p.x + p.y; });
+    ASSERT_EQ(LUA_OK, luaL_dostring(L, "local p = point.new(1, 2) return p:sum(), p:length()"));
+    EXPECT_EQ(3, lua_tonumber(L, 1));
+}